@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "config.h"
+#include "linked_list.h"
+#include "log_entry.h"
+#include "logger.h"
+#include "persistence.h"
+
+/*
+ * Rows per second for each DB_WRITE_MODE against the PostgreSQL server in
+ * the DB_* environment (rows are inserted into processed_logs). Pipeline
+ * mode runs at depth 1, which commits every row on its own sync, and at
+ * the configured DB_PIPELINE_DEPTH, which commits once per group.
+ */
+
+#define BENCH_BATCHES 50
+#define BENCH_BATCH_SIZE 500
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e6) + ((double)ts.tv_nsec / 1e3);
+}
+
+static int run_case(const AppConfig *base, DbWriteMode mode, size_t depth, AppLogger *logger) {
+    char error[256] = {0};
+    AppConfig config = *base;
+    config.db_write_mode = mode;
+    config.db_pipeline_depth = depth;
+    config.db_pool_size = 1;
+
+    Persistence persistence;
+    if (!persistence_init(&persistence, &config, logger, error, sizeof(error))) {
+        fprintf(stderr, "persistence_init failed: %s\n", error);
+        return 0;
+    }
+
+    size_t stored = 0;
+    size_t failed_rows = 0;
+    uint64_t next_id = 1;
+    double started = now_us();
+    for (size_t round = 0; round < BENCH_BATCHES; ++round) {
+        LinkedList batch;
+        LinkedList failed;
+        linked_list_init(&batch);
+        linked_list_init(&failed);
+        for (size_t i = 0; i < BENCH_BATCH_SIZE; ++i) {
+            linked_list_push_back(&batch,
+                                  log_entry_create(next_id++, "INFO", "bench", "disk usage within limits", log_entry_now_ms()));
+        }
+
+        persistence_write_batch(&persistence, 0, &batch, log_entry_now_ms(), &failed, error, sizeof(error));
+        stored += linked_list_size(&batch);
+        failed_rows += linked_list_size(&failed);
+        linked_list_clear(&batch, log_entry_free);
+        linked_list_clear(&failed, log_entry_free);
+    }
+    double elapsed_s = (now_us() - started) / 1e6;
+
+    printf("mode=%-11s depth=%-4zu batch=%d rows_per_sec=%.0f failed=%zu\n",
+           db_write_mode_to_string(mode),
+           mode == DB_WRITE_PIPELINE ? depth : 0,
+           BENCH_BATCH_SIZE,
+           (double)stored / elapsed_s,
+           failed_rows);
+
+    persistence_close(&persistence);
+    return 1;
+}
+
+int main(void) {
+    setenv("LOG_LEVEL", "ERROR", 0);
+
+    char error[256] = {0};
+    AppConfig config;
+    if (!config_load_from_env(&config, error, sizeof(error))) {
+        fprintf(stderr, "config_load_from_env failed: %s\n", error);
+        return 1;
+    }
+
+    AppLogger logger;
+    if (!logger_init(&logger, config.log_level, stderr)) {
+        return 1;
+    }
+
+    int ok = run_case(&config, DB_WRITE_COPY, 0, &logger) && run_case(&config, DB_WRITE_TRANSACTION, 0, &logger) &&
+             run_case(&config, DB_WRITE_PIPELINE, 1, &logger) &&
+             run_case(&config, DB_WRITE_PIPELINE, config.db_pipeline_depth, &logger);
+
+    logger_close(&logger);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "buffer_engine.h"
+#include "logger.h"
+
+#define BENCH_CAPACITY 200000
+#define BENCH_ROUNDS 5
+#define BENCH_PREVIEW_ITEMS 200
+#define BENCH_PREVIEW_CALLS 2000
+#define BENCH_MAX_PRODUCERS 8
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+static int run_case(AppLogger *logger, BufferQueueBackend backend, int use_arena) {
+    char error[256] = {0};
+    static char preview[262144];
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, BENCH_CAPACITY);
+    options.queue_backend = backend;
+    options.use_arena = use_arena;
+
+    BufferEngine engine;
+    if (!buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error))) {
+        fprintf(stderr, "init failed: %s\n", error);
+        return 0;
+    }
+
+    double enqueue_s = 0.0;
+    double dequeue_s = 0.0;
+    double preview_s = 0.0;
+
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        double started = now_seconds();
+        for (size_t i = 0; i < BENCH_CAPACITY; ++i) {
+            if (!buffer_engine_enqueue(&engine, "INFO", "bench", "disk ok", error, sizeof(error))) {
+                fprintf(stderr, "enqueue failed: %s\n", error);
+                buffer_engine_shutdown(&engine);
+                return 0;
+            }
+        }
+        enqueue_s += now_seconds() - started;
+
+        started = now_seconds();
+        for (int call = 0; call < BENCH_PREVIEW_CALLS; ++call) {
+            buffer_engine_pending_json(&engine, BENCH_PREVIEW_ITEMS, preview, sizeof(preview));
+        }
+        preview_s += now_seconds() - started;
+
+        started = now_seconds();
+        LogEntry *entry = NULL;
+        while (buffer_engine_dequeue(&engine, &entry)) {
+            buffer_engine_release_entry(&engine, entry);
+        }
+        dequeue_s += now_seconds() - started;
+    }
+
+    const double operations = (double)BENCH_CAPACITY * BENCH_ROUNDS;
+    printf("backend=%-4s arena=%d enqueue_ns=%.1f dequeue_ns=%.1f preview_us=%.1f\n",
+           buffer_queue_backend_to_string(backend),
+           use_arena,
+           (enqueue_s / operations) * 1e9,
+           (dequeue_s / operations) * 1e9,
+           (preview_s / (BENCH_PREVIEW_CALLS * BENCH_ROUNDS)) * 1e6);
+
+    buffer_engine_shutdown(&engine);
+    return 1;
+}
+
+typedef struct {
+    BufferEngine *engine;
+    size_t count;
+} ProducerArgs;
+
+static void *producer_main(void *arg) {
+    ProducerArgs *args = (ProducerArgs *)arg;
+    char error[256] = {0};
+
+    for (size_t i = 0; i < args->count; ++i) {
+        buffer_engine_enqueue(args->engine, "INFO", "bench", "disk ok", error, sizeof(error));
+    }
+
+    return NULL;
+}
+
+static int run_producers(AppLogger *logger, BufferIngestMode ingest_mode, size_t producers) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, BENCH_CAPACITY);
+    options.ingest_mode = ingest_mode;
+    options.use_arena = 1;
+
+    BufferEngine engine;
+    if (!buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error))) {
+        fprintf(stderr, "init failed: %s\n", error);
+        return 0;
+    }
+
+    pthread_t threads[BENCH_MAX_PRODUCERS];
+    ProducerArgs args[BENCH_MAX_PRODUCERS];
+    double elapsed_s = 0.0;
+
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        double started = now_seconds();
+        for (size_t i = 0; i < producers; ++i) {
+            args[i].engine = &engine;
+            args[i].count = BENCH_CAPACITY / producers;
+            pthread_create(&threads[i], NULL, producer_main, &args[i]);
+        }
+        for (size_t i = 0; i < producers; ++i) {
+            pthread_join(threads[i], NULL);
+        }
+        elapsed_s += now_seconds() - started;
+
+        LogEntry *entry = NULL;
+        while (buffer_engine_dequeue(&engine, &entry)) {
+            buffer_engine_release_entry(&engine, entry);
+        }
+    }
+
+    EngineMetrics metrics;
+    buffer_engine_get_metrics(&engine, &metrics);
+    printf("ingest=%-8s producers=%zu enqueue_per_sec=%.0f ingested=%llu\n",
+           buffer_ingest_mode_to_string(ingest_mode),
+           producers,
+           (double)metrics.total_ingested / elapsed_s,
+           (unsigned long long)metrics.total_ingested);
+
+    buffer_engine_shutdown(&engine);
+    return 1;
+}
+
+int main(void) {
+    AppLogger logger;
+    if (!logger_init(&logger, LOGGER_ERROR, stderr)) {
+        return 1;
+    }
+
+    int ok = run_case(&logger, BUFFER_QUEUE_LIST, 0) &&
+             run_case(&logger, BUFFER_QUEUE_RING, 0) &&
+             run_case(&logger, BUFFER_QUEUE_LIST, 1) &&
+             run_case(&logger, BUFFER_QUEUE_RING, 1);
+
+    for (size_t producers = 1; ok && producers <= BENCH_MAX_PRODUCERS; producers *= 2) {
+        ok = run_producers(&logger, BUFFER_INGEST_MUTEX, producers) &&
+             run_producers(&logger, BUFFER_INGEST_LOCKFREE, producers);
+    }
+
+    logger_close(&logger);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "engine_api.h"
+
+/*
+ * Ingest throughput and tail latency through the public engine_* API while
+ * one reader keeps calling the pending preview, metrics and health. The
+ * "global" case wraps every call in one mutex, which is how the runtime
+ * serialized entry points before the lifecycle lock was split; "split" calls
+ * straight through. Runs against the null sink, so no database is needed.
+ */
+
+#define BENCH_MAX_PRODUCERS 8
+#define BENCH_CALLS_PER_PRODUCER 100000
+
+typedef struct {
+    int serialize;
+    atomic_int stop;
+    atomic_uint_least64_t reads;
+} BenchShared;
+
+typedef struct {
+    BenchShared *shared;
+    unsigned long long failed;
+    double *latencies_us;
+} ProducerArgs;
+
+static pthread_mutex_t g_global_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e6) + ((double)ts.tv_nsec / 1e3);
+}
+
+static void *producer_main(void *arg) {
+    ProducerArgs *args = (ProducerArgs *)arg;
+    BenchShared *shared = args->shared;
+
+    for (size_t i = 0; i < BENCH_CALLS_PER_PRODUCER; ++i) {
+        double started = now_us();
+        if (shared->serialize) {
+            pthread_mutex_lock(&g_global_lock);
+        }
+        int ok = engine_add_log("INFO", "disk usage within limits", "bench");
+        if (shared->serialize) {
+            pthread_mutex_unlock(&g_global_lock);
+        }
+
+        args->latencies_us[i] = now_us() - started;
+        args->failed += ok ? 0 : 1;
+    }
+
+    return NULL;
+}
+
+static void *reader_main(void *arg) {
+    BenchShared *shared = (BenchShared *)arg;
+    unsigned int round = 0;
+
+    while (!atomic_load(&shared->stop)) {
+        if (shared->serialize) {
+            pthread_mutex_lock(&g_global_lock);
+        }
+        switch (round++ % 3) {
+            case 0:
+                engine_get_pending_logs();
+                break;
+            case 1:
+                engine_get_metrics();
+                break;
+            default:
+                engine_health();
+                break;
+        }
+        if (shared->serialize) {
+            pthread_mutex_unlock(&g_global_lock);
+        }
+        atomic_fetch_add(&shared->reads, 1);
+    }
+
+    return NULL;
+}
+
+static int compare_doubles(const void *left, const void *right) {
+    double a = *(const double *)left;
+    double b = *(const double *)right;
+    return (a > b) - (a < b);
+}
+
+static int run_case(int serialize, size_t producers) {
+    if (!engine_init()) {
+        fprintf(stderr, "engine_init failed: %s\n", engine_last_error());
+        return 0;
+    }
+
+    BenchShared shared;
+    shared.serialize = serialize;
+    atomic_init(&shared.stop, 0);
+    atomic_init(&shared.reads, 0);
+
+    pthread_t threads[BENCH_MAX_PRODUCERS];
+    ProducerArgs args[BENCH_MAX_PRODUCERS];
+    for (size_t i = 0; i < producers; ++i) {
+        args[i].shared = &shared;
+        args[i].failed = 0;
+        args[i].latencies_us = (double *)malloc(sizeof(double) * BENCH_CALLS_PER_PRODUCER);
+        if (args[i].latencies_us == NULL) {
+            fprintf(stderr, "unable to allocate latency samples\n");
+            return 0;
+        }
+    }
+
+    pthread_t reader;
+    pthread_create(&reader, NULL, reader_main, &shared);
+    double started = now_us();
+    for (size_t i = 0; i < producers; ++i) {
+        pthread_create(&threads[i], NULL, producer_main, &args[i]);
+    }
+
+    unsigned long long failed = 0;
+    for (size_t i = 0; i < producers; ++i) {
+        pthread_join(threads[i], NULL);
+        failed += args[i].failed;
+    }
+    double elapsed_s = (now_us() - started) / 1e6;
+    atomic_store(&shared.stop, 1);
+    pthread_join(reader, NULL);
+
+    const size_t calls = producers * BENCH_CALLS_PER_PRODUCER;
+    double *latencies = (double *)malloc(sizeof(double) * calls);
+    size_t offset = 0;
+    for (size_t i = 0; i < producers; ++i) {
+        for (size_t j = 0; latencies != NULL && j < BENCH_CALLS_PER_PRODUCER; ++j) {
+            latencies[offset++] = args[i].latencies_us[j];
+        }
+        free(args[i].latencies_us);
+    }
+
+    double p99_us = 0.0;
+    double max_us = 0.0;
+    if (latencies != NULL && offset > 0) {
+        qsort(latencies, offset, sizeof(double), compare_doubles);
+        p99_us = latencies[(size_t)((double)(offset - 1) * 0.99)];
+        max_us = latencies[offset - 1];
+    }
+    free(latencies);
+
+    printf("lock=%-6s producers=%zu add_log_per_sec=%.0f reads_per_sec=%.0f p99_us=%.1f max_us=%.1f failed=%llu\n",
+           serialize ? "global" : "split",
+           producers,
+           (double)calls / elapsed_s,
+           (double)atomic_load(&shared.reads) / elapsed_s,
+           p99_us,
+           max_us,
+           failed);
+
+    engine_shutdown();
+    return 1;
+}
+
+int main(void) {
+    setenv("SINK", "null", 1);
+    setenv("LOG_LEVEL", "ERROR", 0);
+    /* Room for every call, so the numbers measure locking rather than rejection. */
+    setenv("BUFFER_CAPACITY", "1000000", 0);
+    setenv("BUFFER_INGEST_MODE", "lockfree", 0);
+    setenv("AUTO_PROCESS_THRESHOLD", "1000", 0);
+    setenv("PROCESS_BATCH_SIZE", "500", 0);
+    setenv("PROCESSOR_THREADS", "4", 0);
+    setenv("PENDING_PREVIEW_LIMIT", "1000", 0);
+    setenv("SHUTDOWN_SNAPSHOT", "0", 1);
+    setenv("JOURNAL_ENABLED", "0", 1);
+    setenv("SPILL_ENABLED", "0", 1);
+    setenv("DEAD_LETTER_MAX_ATTEMPTS", "0", 1);
+
+    const size_t producer_counts[] = {1, 4, BENCH_MAX_PRODUCERS};
+    for (size_t i = 0; i < sizeof(producer_counts) / sizeof(producer_counts[0]); ++i) {
+        if (!run_case(1, producer_counts[i]) || !run_case(0, producer_counts[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
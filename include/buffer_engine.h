@@ -2,35 +2,213 @@
 #define BUFFER_ENGINE_H
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include "entry_arena.h"
+#include "journal.h"
+#include "latency_histogram.h"
 #include "linked_list.h"
 #include "logger.h"
+#include "mpmc_queue.h"
+#include "ring_queue.h"
+#include "spill_queue.h"
+
+/*
+ * Latency histograms kept by the engine. Enqueue is the producer's call
+ * time; queue wait runs from ingest to dequeue by the processor; persist
+ * batch is one sink write and persist row that write divided by its rows;
+ * end to end runs from ingest until the entry is stored.
+ */
+typedef enum {
+    ENGINE_LATENCY_ENQUEUE = 0,
+    ENGINE_LATENCY_QUEUE_WAIT = 1,
+    ENGINE_LATENCY_PERSIST_BATCH = 2,
+    ENGINE_LATENCY_PERSIST_ROW = 3,
+    ENGINE_LATENCY_END_TO_END = 4,
+    ENGINE_LATENCY_KIND_COUNT = 5
+} EngineLatencyKind;
+
+/*
+ * Priority lanes. Every entry is routed by its level to one lane; the
+ * processor dequeues across lanes by BufferLaneSchedule, so ERROR traffic
+ * does not wait behind a DEBUG flood. Without configured lanes the engine
+ * keeps one catch-all lane and behaves as a single FIFO.
+ */
+#define BUFFER_MAX_LANES 4
+#define BUFFER_LANE_NAME_MAX 16
+#define BUFFER_LANE_LEVELS_MAX 128
+
+typedef enum {
+    BUFFER_LANES_WEIGHTED = 0,
+    BUFFER_LANES_STRICT = 1
+} BufferLaneSchedule;
+
+typedef struct {
+    char name[BUFFER_LANE_NAME_MAX];
+    char levels[BUFFER_LANE_LEVELS_MAX]; /* comma-separated, case-insensitive; "*" takes unclaimed levels */
+    size_t capacity; /* admission limit for new entries; 0 = only the engine capacity applies */
+    unsigned int weight; /* entries per turn under the weighted schedule */
+} BufferLaneOptions;
+
+typedef struct {
+    char name[BUFFER_LANE_NAME_MAX];
+    size_t depth;
+    size_t capacity;
+    unsigned int weight;
+    uint64_t rejected;
+} LaneMetrics;
 
 typedef struct {
     uint64_t total_ingested;
     uint64_t total_processed;
     uint64_t total_errors;
+    uint64_t total_dead_lettered;
+    uint64_t total_dropped;
     size_t queue_depth;
     size_t buffer_capacity;
     size_t memory_bytes_estimate;
     double last_processing_ms;
     int64_t started_at_ms;
     int64_t last_processed_at_ms;
+    size_t arena_slots_total;
+    size_t arena_slots_in_use;
+    size_t arena_high_water;
+    uint64_t arena_fallback_allocs;
+    size_t spilled_entries;
+    size_t spilled_bytes;
+    size_t spill_segments;
+    uint64_t spilled_total;
+    uint64_t paged_in_total;
+    int64_t latency_window_started_at_ms;
+    LatencySummary latency[ENGINE_LATENCY_KIND_COUNT];
+    size_t lane_count;
+    LaneMetrics lanes[BUFFER_MAX_LANES];
 } EngineMetrics;
 
+typedef enum {
+    BUFFER_QUEUE_LIST = 0,
+    BUFFER_QUEUE_RING = 1
+} BufferQueueBackend;
+
+typedef enum {
+    BUFFER_INGEST_MUTEX = 0,
+    BUFFER_INGEST_LOCKFREE = 1
+} BufferIngestMode;
+
+typedef enum {
+    BUFFER_ENQUEUE_OK = 0,
+    BUFFER_ENQUEUE_INVALID = 1,
+    BUFFER_ENQUEUE_FULL = 2,
+    BUFFER_ENQUEUE_NO_MEMORY = 3,
+    BUFFER_ENQUEUE_JOURNAL_ERROR = 4
+} BufferEnqueueStatus;
+
 typedef struct {
+    const char *level;
+    const char *source;
+    const char *message;
+} BufferLogInput;
+
+typedef struct {
+    size_t capacity;
+    BufferQueueBackend queue_backend;
+    BufferIngestMode ingest_mode;
+    int use_arena;
+    size_t arena_slot_size;
+    size_t arena_headroom; /* extra slots for entries held by batches in flight */
+    EntryArenaPageMode arena_page_mode;
+    int arena_prefault;
+    size_t lane_count; /* 0 = one catch-all lane */
+    BufferLaneOptions lanes[BUFFER_MAX_LANES]; /* highest priority first */
+    BufferLaneSchedule lane_schedule;
+} BufferEngineOptions;
+
+/*
+ * Lane depth counts entries reserved for the lane, including ones still in
+ * the lock-free inbox. Requeued and paged-in entries return to their lane
+ * even past its capacity: the limit only refuses new entries.
+ */
+typedef struct {
+    BufferLaneOptions options;
     LinkedList queue;
+    RingQueue ring;
+    atomic_size_t depth;
+    _Atomic uint64_t rejected;
+} BufferLane;
+
+/*
+ * In mutex mode producers append to the backend queue under `mutex`. In
+ * lock-free mode producers reserve capacity with a CAS on `depth` and
+ * publish into the MPMC `inbox`; consumers (holding `mutex`) move inbox
+ * entries into the backend queue, which also keeps requeued entries ahead
+ * of newer ones. Each lane has its own backend queue; `lane_cursor` and
+ * `lane_credit` carry the weighted schedule's turn between dequeues and,
+ * like the queues, are guarded by `mutex`.
+ *
+ * Metrics never take `mutex`: every counter is an atomic, and the consumer
+ * side (processed, dead-lettered, last batch) lives on its own cache line so
+ * workers finishing batches do not bounce the line producers update.
+ */
+typedef struct {
+    BufferQueueBackend backend;
+    BufferIngestMode ingest_mode;
+    BufferLane lanes[BUFFER_MAX_LANES];
+    size_t lane_count;
+    size_t catch_all_lane;
+    BufferLaneSchedule lane_schedule;
+    size_t lane_cursor;
+    unsigned int lane_credit;
+    MpmcQueue inbox;
     pthread_mutex_t mutex;
-    uint64_t next_log_id;
     size_t capacity;
-    EngineMetrics metrics;
+    EntryArena arena;
+    Journal *journal; /* optional write-ahead journal; entries are durable before they are queued */
+    SpillQueue *spill; /* optional overflow tier used once `capacity` entries are in memory */
+    int64_t started_at_ms;
+    _Atomic uint64_t next_log_id;
+    _Atomic uint64_t total_ingested;
+    _Atomic uint64_t total_errors;
+    _Atomic uint64_t arena_fallback_allocs;
+    atomic_size_t depth;
+    atomic_size_t memory_bytes;
+    atomic_size_t in_flight; /* dequeued, not yet released or requeued */
+    _Alignas(MPMC_CACHE_LINE) _Atomic uint64_t total_processed;
+    _Atomic uint64_t total_dead_lettered;
+    _Atomic uint64_t total_dropped;
+    _Atomic double last_processing_ms;
+    _Atomic int64_t last_processed_at_ms;
+    LatencyHistogram latency[ENGINE_LATENCY_KIND_COUNT];
+    _Atomic int64_t latency_window_started_at_ms;
     AppLogger *logger;
     int initialized;
 } BufferEngine;
 
+BufferQueueBackend buffer_queue_backend_from_string(const char *text);
+const char *buffer_queue_backend_to_string(BufferQueueBackend backend);
+BufferIngestMode buffer_ingest_mode_from_string(const char *text);
+const char *buffer_ingest_mode_to_string(BufferIngestMode mode);
+BufferLaneSchedule buffer_lane_schedule_from_string(const char *text);
+const char *buffer_lane_schedule_to_string(BufferLaneSchedule schedule);
+/*
+ * Fills the lane options from "name=LEVEL,LEVEL;name=*" plus comma-separated
+ * weights and capacities matched to lanes by position (missing weights are
+ * 1, missing capacities 0). An empty spec leaves the single default lane.
+ */
+int buffer_engine_parse_lanes(BufferEngineOptions *options,
+                              const char *spec,
+                              const char *weights,
+                              const char *capacities,
+                              char *error,
+                              size_t error_size);
+void buffer_engine_default_options(BufferEngineOptions *options, size_t capacity);
 int buffer_engine_init(BufferEngine *engine, size_t capacity, AppLogger *logger, char *error, size_t error_size);
+int buffer_engine_init_with_options(BufferEngine *engine,
+                                    const BufferEngineOptions *options,
+                                    AppLogger *logger,
+                                    char *error,
+                                    size_t error_size);
 void buffer_engine_shutdown(BufferEngine *engine);
 int buffer_engine_enqueue(BufferEngine *engine,
                           const char *level,
@@ -38,11 +216,54 @@ int buffer_engine_enqueue(BufferEngine *engine,
                           const char *message,
                           char *error,
                           size_t error_size);
+size_t buffer_engine_enqueue_batch(BufferEngine *engine,
+                                   const BufferLogInput *items,
+                                   size_t count,
+                                   int *statuses,
+                                   char *error,
+                                   size_t error_size);
+int buffer_engine_restore(BufferEngine *engine,
+                          const LogEntryRecord *record,
+                          uint32_t journal_segment,
+                          char *error,
+                          size_t error_size);
 int buffer_engine_requeue_front(BufferEngine *engine, LogEntry *entry, char *error, size_t error_size);
+int buffer_engine_requeue_front_batch(BufferEngine *engine, LinkedList *entries, char *error, size_t error_size);
 int buffer_engine_dequeue(BufferEngine *engine, LogEntry **entry_out);
+size_t buffer_engine_dequeue_batch(BufferEngine *engine, size_t max_items, LinkedList *out_list);
+void buffer_engine_release_entry(BufferEngine *engine, LogEntry *entry);
+void buffer_engine_release_batch(BufferEngine *engine, LinkedList *entries);
+/*
+ * Frees in-flight entries that were neither stored nor requeued. Unlike a
+ * release their journal records are kept, so the next start replays them;
+ * they are counted in `total_dropped`.
+ */
+void buffer_engine_drop_batch(BufferEngine *engine, LinkedList *entries);
+/*
+ * Takes in-flight entries off the engine's books without freeing them, so
+ * the room they held can be paged into. buffer_engine_reattach_batch() puts
+ * them back before they are released, requeued or dropped.
+ */
+void buffer_engine_detach_batch(BufferEngine *engine, const LinkedList *entries);
+void buffer_engine_reattach_batch(BufferEngine *engine, const LinkedList *entries);
+void buffer_engine_attach_journal(BufferEngine *engine, Journal *journal);
+void buffer_engine_attach_spill(BufferEngine *engine, SpillQueue *spill);
+size_t buffer_engine_queue_depth(BufferEngine *engine);
+/*
+ * Ingest time of the entry at the head of the in-memory queue, or 0 when it
+ * is empty. Takes `mutex` briefly, unlike buffer_engine_get_metrics().
+ */
+int64_t buffer_engine_oldest_ingested_at_ms(BufferEngine *engine);
 int buffer_engine_get_metrics(BufferEngine *engine, EngineMetrics *out_metrics);
 void buffer_engine_mark_processed(BufferEngine *engine, double processing_ms);
+/* One update for a whole stored batch; `last_processing_ms` is its newest entry's latency. */
+void buffer_engine_mark_processed_batch(BufferEngine *engine, size_t count, double last_processing_ms);
 void buffer_engine_mark_error(BufferEngine *engine);
+void buffer_engine_record_latency(BufferEngine *engine, EngineLatencyKind kind, uint64_t micros, uint64_t count);
+/* Starts a new percentile window for every latency histogram. */
+void buffer_engine_reset_latency_window(BufferEngine *engine);
+const char *buffer_engine_latency_kind_to_string(EngineLatencyKind kind);
+void buffer_engine_mark_dead_lettered(BufferEngine *engine);
 int buffer_engine_pending_json(BufferEngine *engine,
                                size_t max_items,
                                char *buffer,
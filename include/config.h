@@ -3,23 +3,92 @@
 
 #include <stddef.h>
 
+#include "buffer_engine.h"
+#include "entry_arena.h"
 #include "logger.h"
 
+/* How processed batches reach PostgreSQL (DB_WRITE_MODE). */
+typedef enum {
+    DB_WRITE_COPY = 0,
+    DB_WRITE_TRANSACTION = 1,
+    DB_WRITE_PIPELINE = 2,
+} DbWriteMode;
+
+/* Where processed batches go (SINK). */
+typedef enum {
+    SINK_POSTGRES = 0,
+    SINK_FILE = 1,
+    SINK_NULL = 2,
+} SinkKind;
+
+/* How the queue processor sizes batches (PROCESS_BATCH_MODE). */
+typedef enum {
+    BATCH_SIZE_STATIC = 0,
+    BATCH_SIZE_ADAPTIVE = 1,
+} BatchSizeMode;
+
 typedef struct {
+    SinkKind sink_kind;
+    char sink_file_dir[256];
+    size_t sink_file_segment_bytes;
+    int sink_file_fsync;
     char db_host[128];
     int db_port;
     char db_name[128];
     char db_user[128];
     char db_password[128];
     int db_connect_timeout;
+    DbWriteMode db_write_mode;
+    size_t db_pipeline_depth;
+    size_t db_pool_size;
+    int db_source_affinity;
+    int db_breaker_failures;
+    int db_reconnect_backoff_ms;
+    int db_reconnect_backoff_max_ms;
     size_t buffer_capacity;
     size_t auto_process_threshold;
     size_t process_batch_size;
+    BatchSizeMode process_batch_mode;
+    size_t process_batch_min;
+    size_t process_batch_max;
+    int process_batch_target_ms;
     size_t pending_preview_limit;
+    char dead_letter_path[256];
+    unsigned int dead_letter_max_attempts;
+    int spill_enabled;
+    char spill_dir[256];
+    size_t spill_segment_bytes;
+    size_t spill_max_bytes;
+    int journal_enabled;
+    char journal_dir[256];
+    size_t journal_segment_bytes;
+    int journal_fsync;
+    size_t processor_threads;
+    int processor_linger_ms;
+    int process_max_linger_ms;
+    int shutdown_drain_timeout_ms;
+    int shutdown_snapshot;
+    char snapshot_path[256];
+    BufferQueueBackend buffer_queue_backend;
+    BufferIngestMode buffer_ingest_mode;
+    char buffer_lanes[256];
+    char buffer_lane_weights[64];
+    char buffer_lane_capacities[128];
+    BufferLaneSchedule buffer_lane_schedule;
+    int entry_arena_enabled;
+    size_t entry_arena_slot_bytes;
+    EntryArenaPageMode entry_arena_pages;
+    int entry_arena_prefault;
     LoggerLevel log_level;
     int api_port;
 } AppConfig;
 
+DbWriteMode db_write_mode_from_string(const char *text);
+const char *db_write_mode_to_string(DbWriteMode mode);
+SinkKind sink_kind_from_string(const char *text);
+const char *sink_kind_to_string(SinkKind kind);
+BatchSizeMode batch_size_mode_from_string(const char *text);
+const char *batch_size_mode_to_string(BatchSizeMode mode);
 int config_load_from_env(AppConfig *config, char *error, size_t error_size);
 int config_build_conninfo(const AppConfig *config, char *buffer, size_t buffer_size);
 
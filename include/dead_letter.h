@@ -0,0 +1,26 @@
+#ifndef DEAD_LETTER_H
+#define DEAD_LETTER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "log_entry.h"
+
+/*
+ * Append-only JSON-lines file for entries the database kept rejecting.
+ * It is deliberately local: a record that PostgreSQL refuses to store would
+ * most likely be refused by a dead-letter table as well.
+ */
+typedef struct {
+    FILE *file;
+    pthread_mutex_t mutex;
+    char path[256];
+    int initialized;
+} DeadLetterStore;
+
+int dead_letter_open(DeadLetterStore *store, const char *path, char *error, size_t error_size);
+int dead_letter_write(DeadLetterStore *store, const LogEntry *entry, const char *reason, char *error, size_t error_size);
+void dead_letter_close(DeadLetterStore *store);
+
+#endif
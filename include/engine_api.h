@@ -6,10 +6,29 @@
 int engine_init(void);
 int engine_shutdown(void);
 int engine_add_log(const char *level, const char *message, const char *source);
+int engine_add_logs(const char **levels, const char **messages, const char **sources, size_t count, int *statuses);
+/*
+ * JSON responses. The pointer-returning calls use a per-thread buffer that
+ * the calling thread's next engine call may overwrite. The *_into() variants
+ * write into `buffer` and return the JSON length, or 0 when it did not fit
+ * (`buffer` then holds an error object if there is room) and the caller
+ * may retry with a larger one. engine_process_queue_into() processes the
+ * batch either way, so only its report is lost.
+ */
 const char *engine_get_pending_logs(void);
 const char *engine_process_queue(size_t max_items);
 const char *engine_get_metrics(void);
 const char *engine_health(void);
+size_t engine_get_pending_logs_into(char *buffer, size_t buffer_size);
+size_t engine_process_queue_into(size_t max_items, char *buffer, size_t buffer_size);
+size_t engine_get_metrics_into(char *buffer, size_t buffer_size);
+size_t engine_health_into(char *buffer, size_t buffer_size);
+/* Starts a new window for the latency percentiles reported by engine_get_metrics(). */
+int engine_reset_latency_window(void);
+/* Counts from the last engine_shutdown(): drained, snapshotted, journaled, dropped, elapsed_ms. */
+const char *engine_shutdown_report(void);
+size_t engine_shutdown_report_into(char *buffer, size_t buffer_size);
+/* Last error of the calling thread. */
 const char *engine_last_error(void);
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef ENTRY_ARENA_H
+#define ENTRY_ARENA_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "log_entry.h"
+#include "mpmc_queue.h"
+
+typedef enum {
+    ENTRY_ARENA_PAGES_DEFAULT = 0,
+    ENTRY_ARENA_PAGES_TRANSPARENT = 1,
+    ENTRY_ARENA_PAGES_EXPLICIT = 2
+} EntryArenaPageMode;
+
+/*
+ * Fixed pool of equally sized LogEntry slots reserved once at startup.
+ * Free slots are kept in a lock-free MPMC queue, so concurrent producers
+ * and consumers can allocate and release without a shared mutex.
+ */
+typedef struct {
+    unsigned char *base;
+    size_t mapped_bytes;
+    size_t slot_size;
+    size_t slot_count;
+    MpmcQueue free_slots;
+    atomic_size_t in_use;
+    atomic_size_t high_water;
+    EntryArenaPageMode page_mode;
+    int initialized;
+} EntryArena;
+
+EntryArenaPageMode entry_arena_page_mode_from_string(const char *text);
+const char *entry_arena_page_mode_to_string(EntryArenaPageMode mode);
+int entry_arena_init(EntryArena *arena,
+                     size_t slot_count,
+                     size_t slot_size,
+                     EntryArenaPageMode page_mode,
+                     int prefault,
+                     char *error,
+                     size_t error_size);
+LogEntry *entry_arena_alloc(EntryArena *arena, size_t entry_size);
+int entry_arena_owns(const EntryArena *arena, const LogEntry *entry);
+void entry_arena_release(EntryArena *arena, LogEntry *entry);
+size_t entry_arena_in_use(const EntryArena *arena);
+size_t entry_arena_high_water(const EntryArena *arena);
+void entry_arena_destroy(EntryArena *arena);
+
+#endif
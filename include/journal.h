@@ -0,0 +1,102 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "linked_list.h"
+#include "log_entry.h"
+#include "logger.h"
+
+/*
+ * Append-only write-ahead journal for the in-memory buffer. Records go to
+ * numbered segment files in `dir`; appends are acknowledged only once they
+ * reach the file (and the disk, with fsync on). Concurrent appenders share
+ * one write+fsync: whoever finds no flush running becomes the leader and
+ * writes everything buffered so far (group commit).
+ *
+ * Each entry remembers its segment. Releasing an entry (persisted,
+ * dead-lettered or dropped) decrements that segment's outstanding count and
+ * a sealed segment with nothing outstanding is deleted. Truncation is per
+ * segment, so replay is at-least-once: entries already persisted from a
+ * segment that still had live entries come back after a crash. Smaller
+ * segments bound those duplicates at the cost of more files.
+ */
+typedef struct {
+    uint32_t seq;
+    size_t outstanding;
+    size_t bytes;
+} JournalSegment;
+
+typedef struct {
+    uint64_t appends;
+    uint64_t records;
+    uint64_t syncs;
+    uint64_t bytes_written;
+    double append_latency_ms_avg;
+    double append_latency_ms_max;
+    size_t segments;
+    size_t segment_bytes_total;
+    uint32_t active_segment;
+    uint64_t replayed;
+    uint64_t replay_dropped;
+    uint64_t replay_corrupt;
+    double recovery_ms;
+} JournalStats;
+
+typedef struct {
+    char dir[256];
+    size_t segment_limit;
+    int fsync_enabled;
+    int fd;
+    uint32_t active_seq;
+    size_t active_bytes;
+    unsigned char *pending;
+    size_t pending_len;
+    size_t pending_capacity;
+    unsigned char *spare;
+    size_t spare_capacity;
+    uint64_t appended_ticket;
+    uint64_t durable_ticket;
+    int flushing;
+    int failed;
+    JournalSegment *segments;
+    size_t segment_count;
+    size_t segment_capacity;
+    pthread_mutex_t mutex;
+    pthread_cond_t flushed;
+    _Atomic uint64_t appends;
+    _Atomic uint64_t records;
+    _Atomic uint64_t syncs;
+    _Atomic uint64_t bytes_written;
+    _Atomic uint64_t append_us_total;
+    _Atomic uint64_t append_us_max;
+    uint64_t replayed;
+    uint64_t replay_dropped;
+    uint64_t replay_corrupt;
+    double recovery_ms;
+    AppLogger *logger;
+    int initialized;
+} Journal;
+
+/* Called once per recovered record; returning 0 drops the record. */
+typedef int (*JournalReplayFn)(void *context, const LogEntryRecord *record, uint32_t segment);
+
+int journal_open(Journal *journal,
+                 const char *dir,
+                 size_t segment_limit,
+                 int fsync_enabled,
+                 AppLogger *logger,
+                 char *error,
+                 size_t error_size);
+int journal_replay(Journal *journal, JournalReplayFn fn, void *context, char *error, size_t error_size);
+int journal_append(Journal *journal, LogEntry *entry, char *error, size_t error_size);
+int journal_append_batch(Journal *journal, LinkedList *entries, char *error, size_t error_size);
+void journal_release(Journal *journal, const LogEntry *entry);
+void journal_release_segment(Journal *journal, uint32_t segment);
+void journal_get_stats(Journal *journal, JournalStats *out_stats);
+void journal_close(Journal *journal);
+
+#endif
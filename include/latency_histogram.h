@@ -0,0 +1,46 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * Log-bucketed latency histogram in microseconds (HDR-style): values below
+ * 16 us get one bucket each, larger ones 8 sub-buckets per power of two, so
+ * any reported percentile is within 12.5% of the recorded value. Recording
+ * is a few relaxed atomic adds and never blocks.
+ *
+ * Percentiles cover the current window: everything recorded since the last
+ * latency_histogram_reset_window() (or since init). A reset copies the
+ * cumulative counts into a baseline rather than clearing them, so recorders
+ * never race a reset; only readers and resets share `window_mutex`.
+ */
+#define LATENCY_HISTOGRAM_BUCKETS 312
+
+typedef struct {
+    uint64_t count;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+} LatencySummary;
+
+typedef struct {
+    _Atomic uint64_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+    _Atomic uint64_t sum_us;
+    _Atomic uint64_t window_max_us;
+    pthread_mutex_t window_mutex;
+    uint64_t baseline[LATENCY_HISTOGRAM_BUCKETS];
+    uint64_t baseline_sum_us;
+} LatencyHistogram;
+
+int latency_histogram_init(LatencyHistogram *histogram);
+void latency_histogram_destroy(LatencyHistogram *histogram);
+/* Records `count` samples of `micros` each (count > 1 for amortized per-row costs). */
+void latency_histogram_record(LatencyHistogram *histogram, uint64_t micros, uint64_t count);
+void latency_histogram_summarize(LatencyHistogram *histogram, LatencySummary *out_summary);
+void latency_histogram_reset_window(LatencyHistogram *histogram);
+
+#endif
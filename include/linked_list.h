@@ -5,15 +5,13 @@
 
 #include "log_entry.h"
 
-typedef struct LinkedListNode {
-    LogEntry *entry;
-    struct LinkedListNode *next;
-    struct LinkedListNode *prev;
-} LinkedListNode;
-
+/*
+ * Intrusive doubly linked FIFO: the next/prev links are stored inside each
+ * LogEntry, so push/pop only relink pointers and never allocate.
+ */
 typedef struct {
-    LinkedListNode *head;
-    LinkedListNode *tail;
+    LogEntry *head;
+    LogEntry *tail;
     size_t size;
 } LinkedList;
 
@@ -21,6 +19,10 @@ void linked_list_init(LinkedList *list);
 int linked_list_push_back(LinkedList *list, LogEntry *entry);
 int linked_list_push_front(LinkedList *list, LogEntry *entry);
 LogEntry *linked_list_pop_front(LinkedList *list);
+void linked_list_remove(LinkedList *list, LogEntry *entry);
+size_t linked_list_pop_front_batch(LinkedList *list, size_t max_items, LinkedList *out_list);
+void linked_list_prepend_list(LinkedList *list, LinkedList *other);
+void linked_list_append_list(LinkedList *list, LinkedList *other);
 size_t linked_list_size(const LinkedList *list);
 void linked_list_clear(LinkedList *list, void (*entry_free_fn)(LogEntry *));
 
@@ -8,20 +8,64 @@
 #define LOG_SOURCE_MAX_LEN 64
 #define LOG_MESSAGE_MAX_LEN 512
 
-typedef struct {
+/*
+ * Compact log record: one allocation holding the header followed by the
+ * length-prefixed level/source/message strings (each NUL-terminated so they
+ * can be handed to libpq and the JSON writer without copying). The queue
+ * links live in the header so enqueueing never allocates a separate node.
+ */
+typedef struct LogEntry {
+    struct LogEntry *next;
+    struct LogEntry *prev;
     uint64_t id;
-    char level[LOG_LEVEL_MAX_LEN];
-    char source[LOG_SOURCE_MAX_LEN];
-    char message[LOG_MESSAGE_MAX_LEN];
     int64_t ingested_at_ms;
+    uint16_t level_len;
+    uint16_t source_len;
+    uint16_t message_len;
+    uint16_t attempts; /* writes the database rejected; drives dead-lettering */
+    uint32_t journal_segment; /* journal segment holding this entry; 0 when not journaled */
+    uint8_t lane; /* buffer engine priority lane; derived from the level, never persisted */
+    char data[];
 } LogEntry;
 
+/*
+ * Portable on-disk form shared by the journal and other local stores:
+ * ingested_at_ms (8 bytes LE), attempts, level_len, source_len, message_len
+ * (2 bytes LE each), then the three NUL-terminated strings. Deserialized
+ * records point into the caller's buffer.
+ */
+#define LOG_ENTRY_RECORD_HEADER_SIZE 16
+#define LOG_ENTRY_RECORD_MAX_SIZE (LOG_ENTRY_RECORD_HEADER_SIZE + LOG_LEVEL_MAX_LEN + LOG_SOURCE_MAX_LEN + LOG_MESSAGE_MAX_LEN)
+
+typedef struct {
+    int64_t ingested_at_ms;
+    uint16_t attempts;
+    const char *level;
+    const char *source;
+    const char *message;
+} LogEntryRecord;
+
 int64_t log_entry_now_ms(void);
+size_t log_entry_required_size(const char *level, const char *source, const char *message);
 int log_entry_init(LogEntry *entry,
+                   size_t entry_size,
                    uint64_t id,
                    const char *level,
                    const char *source,
                    const char *message,
                    int64_t ingested_at_ms);
+LogEntry *log_entry_create(uint64_t id,
+                           const char *level,
+                           const char *source,
+                           const char *message,
+                           int64_t ingested_at_ms);
+void log_entry_free(LogEntry *entry);
+size_t log_entry_size(const LogEntry *entry);
+const char *log_entry_level(const LogEntry *entry);
+const char *log_entry_source(const LogEntry *entry);
+const char *log_entry_message(const LogEntry *entry);
+size_t log_entry_serialized_size(const LogEntry *entry);
+size_t log_entry_serialize(const LogEntry *entry, unsigned char *buffer, size_t buffer_size);
+size_t log_entry_deserialize(const unsigned char *buffer, size_t buffer_size, LogEntryRecord *record);
 
 #endif
@@ -0,0 +1,31 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define MPMC_CACHE_LINE 64
+
+typedef struct {
+    atomic_size_t sequence;
+    void *value;
+} MpmcCell;
+
+/*
+ * Bounded multi-producer/multi-consumer queue of pointers using
+ * sequence-numbered cells: each push/pop claims a position with one CAS and
+ * never takes a lock. Capacity is rounded up to a power of two.
+ */
+typedef struct {
+    MpmcCell *cells;
+    size_t mask;
+    _Alignas(MPMC_CACHE_LINE) atomic_size_t enqueue_pos;
+    _Alignas(MPMC_CACHE_LINE) atomic_size_t dequeue_pos;
+} MpmcQueue;
+
+int mpmc_queue_init(MpmcQueue *queue, size_t min_capacity);
+void mpmc_queue_destroy(MpmcQueue *queue);
+int mpmc_queue_push(MpmcQueue *queue, void *value);
+void *mpmc_queue_pop(MpmcQueue *queue);
+
+#endif
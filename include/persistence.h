@@ -1,19 +1,87 @@
 #ifndef PERSISTENCE_H
 #define PERSISTENCE_H
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include <libpq-fe.h>
 
 #include "buffer_engine.h"
 #include "config.h"
+#include "linked_list.h"
 
+#define PERSISTENCE_MAX_CONNECTIONS 32
+
+typedef enum {
+    PERSISTENCE_BREAKER_CLOSED = 0,
+    PERSISTENCE_BREAKER_OPEN = 1,
+    PERSISTENCE_BREAKER_HALF_OPEN = 2,
+} PersistenceBreakerState;
+
+/*
+ * One pooled connection. `mutex` is held for a whole statement or batch.
+ * Source-routed batches take a ticket at dispatch time and wait on `turn`
+ * until `now_serving` reaches it, so they commit in dequeue order.
+ * `refused` is set when the server turned a write down for a reason other
+ * than the rows in it (read-only standby, full disk, timeout, ...).
+ */
 typedef struct {
     PGconn *conn;
+    int refused;
+    pthread_mutex_t mutex;
+    pthread_cond_t turn;
+    uint64_t next_ticket;
+    uint64_t now_serving;
+    atomic_size_t pipeline_in_flight;
+} PersistenceConnection;
+
+typedef struct {
+    PersistenceConnection connections[PERSISTENCE_MAX_CONNECTIONS];
+    size_t connection_count;
+    int source_affinity;
+    DbWriteMode write_mode;
+    size_t pipeline_depth;
+    atomic_size_t pipeline_in_flight_peak;
+    atomic_size_t busy_connections;
+    atomic_uint_least64_t acquisitions;
+    atomic_uint_least64_t wait_us_total;
+    atomic_uint_least64_t wait_us_max;
+    atomic_uint_least64_t reconnects;
+    pthread_mutex_t breaker_mutex;
+    PersistenceBreakerState breaker_state;
+    unsigned int breaker_failures;
+    unsigned int breaker_threshold;
+    int64_t breaker_retry_at_ms;
+    int64_t breaker_backoff_ms;
+    int64_t reconnect_backoff_initial_ms;
+    int64_t reconnect_backoff_max_ms;
     AppLogger *logger;
     int initialized;
 } Persistence;
 
+/* A batch split by source hash, with the ticket reserved on each target connection. */
+typedef struct {
+    LinkedList parts[PERSISTENCE_MAX_CONNECTIONS];
+    uint64_t tickets[PERSISTENCE_MAX_CONNECTIONS];
+} PersistenceRoute;
+
+typedef struct {
+    size_t pipeline_in_flight;
+    size_t pipeline_in_flight_peak;
+    size_t pool_size;
+    size_t pool_busy;
+    uint64_t pool_acquisitions;
+    double pool_wait_ms_avg;
+    double pool_wait_ms_max;
+    uint64_t reconnects;
+    PersistenceBreakerState breaker_state;
+    unsigned int breaker_failures;
+    int64_t breaker_retry_in_ms;
+} PersistenceStats;
+
+const char *persistence_breaker_state_to_string(PersistenceBreakerState state);
 int persistence_init(Persistence *persistence, const AppConfig *config, AppLogger *logger, char *error, size_t error_size);
 int persistence_ping(Persistence *persistence, char *error, size_t error_size);
 int persistence_insert_processed_log(Persistence *persistence,
@@ -22,6 +90,41 @@ int persistence_insert_processed_log(Persistence *persistence,
                                      double processing_ms,
                                      char *error,
                                      size_t error_size);
+/*
+ * Writes a processed batch using the configured DB_WRITE_MODE. Entries that
+ * were not stored are moved from `batch` to `failed`, in order; on return
+ * `batch` holds only stored entries. Returns 1 when nothing failed.
+ * A batch can be partly stored in every mode: pipeline mode reports failures
+ * per entry, and when the server rejects a copy or transaction statement the
+ * batch is retried row by row so only the rejected rows fail. An entry's
+ * attempt count is raised only for a data error on that row (SQLSTATE class
+ * 22 or 23). Any other server error, like a dropped connection, fails the
+ * rest of the batch uncounted and counts against the circuit breaker.
+ * `slot` picks the preferred pool connection.
+ */
+int persistence_write_batch(Persistence *persistence,
+                            size_t slot,
+                            LinkedList *batch,
+                            int64_t processed_at_ms,
+                            LinkedList *failed,
+                            char *error,
+                            size_t error_size);
+/*
+ * Source affinity: split `batch` per connection and reserve each part's turn.
+ * Callers must route batches in dequeue order and must hand every route to
+ * persistence_write_routed(), which moves stored entries to `stored`.
+ */
+void persistence_route_batch(Persistence *persistence, LinkedList *batch, PersistenceRoute *route);
+int persistence_write_routed(Persistence *persistence,
+                             PersistenceRoute *route,
+                             int64_t processed_at_ms,
+                             LinkedList *stored,
+                             LinkedList *failed,
+                             char *error,
+                             size_t error_size);
+/* Cheap pre-check: 0 while the breaker is open and its retry time has not come. */
+int persistence_breaker_allows(Persistence *persistence);
+void persistence_get_stats(Persistence *persistence, PersistenceStats *stats);
 int persistence_insert_metrics(Persistence *persistence,
                                const EngineMetrics *metrics,
                                char *error,
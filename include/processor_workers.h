@@ -0,0 +1,67 @@
+#ifndef PROCESSOR_WORKERS_H
+#define PROCESSOR_WORKERS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer_engine.h"
+#include "logger.h"
+#include "queue_processor.h"
+
+/*
+ * Pool of dedicated processing threads. Ingest paths call
+ * processor_workers_notify() once the queue crosses the threshold; workers
+ * also wake every `linger_ms` to flush whatever is pending, so database
+ * latency never lands on the request that happened to cross the threshold.
+ *
+ * With `max_linger_ms` > 0 the timer follows the queue head instead: a
+ * worker sleeps until the oldest entry is `max_linger_ms` old (at most
+ * `linger_ms`) and only then flushes below the threshold.
+ */
+typedef struct {
+    QueueProcessor *processor;
+    BufferEngine *engine;
+    AppLogger *logger;
+    pthread_t *threads;
+    size_t thread_count;
+    size_t started_count;
+    size_t threshold;
+    size_t batch_size;
+    int64_t linger_ms;
+    int64_t max_linger_ms;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    atomic_int notify_pending;
+    atomic_size_t next_slot;
+    int running;
+    int initialized;
+} ProcessorWorkers;
+
+int processor_workers_start(ProcessorWorkers *workers,
+                            QueueProcessor *processor,
+                            BufferEngine *engine,
+                            AppLogger *logger,
+                            size_t thread_count,
+                            size_t threshold,
+                            size_t batch_size,
+                            int64_t linger_ms,
+                            int64_t max_linger_ms,
+                            char *error,
+                            size_t error_size);
+void processor_workers_notify(ProcessorWorkers *workers);
+void processor_workers_stop(ProcessorWorkers *workers);
+/*
+ * Shutdown drain: `thread_count` threads (the caller included) process
+ * batches on their own pool slots until the queue is empty, a batch fails
+ * or `deadline_ms` (log_entry_now_ms() clock) passes. Returns the number of
+ * entries persisted.
+ */
+size_t processor_workers_drain(QueueProcessor *processor,
+                               AppLogger *logger,
+                               size_t thread_count,
+                               size_t batch_size,
+                               int64_t deadline_ms);
+
+#endif
@@ -1,30 +1,68 @@
 #ifndef QUEUE_PROCESSOR_H
 #define QUEUE_PROCESSOR_H
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 
 #include "buffer_engine.h"
-#include "persistence.h"
+#include "dead_letter.h"
+#include "sink.h"
 
+/*
+ * `dead_letters` may be NULL; entries are then requeued indefinitely.
+ * `dispatch_mutex` keeps dequeue and the sink's reservation in one order
+ * for ordered sinks (PostgreSQL with DB_SOURCE_AFFINITY).
+ *
+ * With adaptive batching, `batch_size` is steered by AIMD between
+ * `batch_min` and `batch_max`: it halves when a sink write fails or takes
+ * longer than `batch_target_ms`, grows by `batch_min` when a batch comes
+ * back full (the backlog is at least a batch deep) and shrinks by
+ * `batch_min` when it does not, so quiet periods settle on small batches.
+ */
 typedef struct {
     BufferEngine *engine;
-    Persistence *persistence;
+    Sink *sink;
+    DeadLetterStore *dead_letters;
     AppLogger *logger;
     size_t default_batch_size;
+    int adaptive;
+    size_t batch_min;
+    size_t batch_max;
+    double batch_target_ms;
+    atomic_size_t batch_size;
+    unsigned int max_attempts;
+    pthread_mutex_t dispatch_mutex;
+    int initialized;
 } QueueProcessor;
 
 int queue_processor_init(QueueProcessor *processor,
                          BufferEngine *engine,
-                         Persistence *persistence,
+                         Sink *sink,
+                         DeadLetterStore *dead_letters,
                          AppLogger *logger,
                          size_t default_batch_size,
+                         unsigned int max_attempts,
                          char *error,
                          size_t error_size);
+/* Switches to adaptive batching; call before any batch is processed. */
+void queue_processor_set_adaptive(QueueProcessor *processor, size_t min_size, size_t max_size, double target_ms);
+/* Size used when no explicit limit is given: the adaptive choice, or `default_batch_size`. */
+size_t queue_processor_batch_size(QueueProcessor *processor);
 int queue_processor_process(QueueProcessor *processor,
                             size_t max_items,
                             size_t *processed_count,
                             double *elapsed_ms,
                             char *error,
                             size_t error_size);
+/* Same as queue_processor_process(), passing `slot` to the sink (the preferred pool connection). */
+int queue_processor_process_slot(QueueProcessor *processor,
+                                 size_t slot,
+                                 size_t max_items,
+                                 size_t *processed_count,
+                                 double *elapsed_ms,
+                                 char *error,
+                                 size_t error_size);
+void queue_processor_shutdown(QueueProcessor *processor);
 
 #endif
@@ -0,0 +1,28 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <stddef.h>
+
+#include "log_entry.h"
+
+/*
+ * Bounded contiguous deque of entry pointers. Supports the same
+ * push_back/push_front/pop_front operations as LinkedList so the buffer
+ * engine can scan pending entries sequentially instead of chasing links.
+ */
+typedef struct {
+    LogEntry **slots;
+    size_t capacity;
+    size_t head;
+    size_t size;
+} RingQueue;
+
+int ring_queue_init(RingQueue *ring, size_t capacity);
+void ring_queue_destroy(RingQueue *ring);
+int ring_queue_push_back(RingQueue *ring, LogEntry *entry);
+int ring_queue_push_front(RingQueue *ring, LogEntry *entry);
+LogEntry *ring_queue_pop_front(RingQueue *ring);
+LogEntry *ring_queue_at(const RingQueue *ring, size_t index);
+size_t ring_queue_size(const RingQueue *ring);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef SINK_H
+#define SINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer_engine.h"
+#include "config.h"
+#include "linked_list.h"
+#include "logger.h"
+#include "persistence.h"
+
+typedef struct Sink Sink;
+
+/*
+ * Destination for processed batches. `write_batch` leaves stored entries
+ * in `batch` and moves the rest to `failed` in order, returning 1 when
+ * nothing failed. Sinks that keep a per-key order across workers set
+ * `ordered`; the processor then calls `reserve` under its dispatch lock
+ * right after dequeuing and hands the result to `write_batch`.
+ * `available`, `reserve` and `record_metrics` are optional.
+ */
+typedef struct {
+    const char *name;
+    int (*open)(Sink *sink, const AppConfig *config, AppLogger *logger, char *error, size_t error_size);
+    void *(*reserve)(Sink *sink, LinkedList *batch);
+    int (*write_batch)(Sink *sink,
+                       size_t slot,
+                       void *reservation,
+                       LinkedList *batch,
+                       int64_t processed_at_ms,
+                       LinkedList *failed,
+                       char *error,
+                       size_t error_size);
+    int (*flush)(Sink *sink, char *error, size_t error_size);
+    int (*health)(Sink *sink, char *error, size_t error_size);
+    int (*available)(Sink *sink);
+    int (*record_metrics)(Sink *sink, const EngineMetrics *metrics, char *error, size_t error_size);
+    void (*close)(Sink *sink);
+} SinkOps;
+
+struct Sink {
+    const SinkOps *ops;
+    void *state;
+    SinkKind kind;
+    int ordered;
+    int initialized;
+};
+
+extern const SinkOps SINK_POSTGRES_OPS;
+extern const SinkOps SINK_FILE_OPS;
+extern const SinkOps SINK_NULL_OPS;
+
+int sink_open(Sink *sink, const AppConfig *config, AppLogger *logger, char *error, size_t error_size);
+const char *sink_name(const Sink *sink);
+void *sink_reserve(Sink *sink, LinkedList *batch);
+int sink_write_batch(Sink *sink,
+                     size_t slot,
+                     void *reservation,
+                     LinkedList *batch,
+                     int64_t processed_at_ms,
+                     LinkedList *failed,
+                     char *error,
+                     size_t error_size);
+int sink_flush(Sink *sink, char *error, size_t error_size);
+int sink_health(Sink *sink, char *error, size_t error_size);
+int sink_available(Sink *sink);
+int sink_record_metrics(Sink *sink, const EngineMetrics *metrics, char *error, size_t error_size);
+/* The PostgreSQL state behind a postgres sink, for pool and breaker stats; NULL for other sinks. */
+Persistence *sink_persistence(Sink *sink);
+void sink_close(Sink *sink);
+
+#endif
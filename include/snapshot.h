@@ -0,0 +1,48 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+
+#include "buffer_engine.h"
+#include "log_entry.h"
+
+/*
+ * Shutdown snapshot: whatever could not be persisted before the shutdown
+ * deadline is written to one file of `[u32 len][record]` frames (records in
+ * log_entry_serialize() format) behind an 8-byte magic, then reloaded by the
+ * next engine_init(). The file is written under `<path>.tmp` and renamed
+ * into place after an fsync, so a snapshot is either complete or absent.
+ */
+typedef int (*SnapshotRestoreFn)(void *context, const LogEntryRecord *record);
+
+/*
+ * Dequeues everything left in `engine` (spilled entries included) into the
+ * snapshot and releases the entries once the file is renamed into place.
+ * Records of an older snapshot still at `path` are carried over behind them.
+ * `written_count` is the number of records in the renamed file. On failure
+ * the temporary file is removed and every dequeued entry is requeued ahead
+ * of the rest; only entries that fit neither in memory nor in the spill tier
+ * are dropped (counted in `total_dropped`).
+ */
+int snapshot_write(const char *path,
+                   BufferEngine *engine,
+                   size_t batch_size,
+                   size_t *written_count,
+                   char *error,
+                   size_t error_size);
+/*
+ * Feeds every record to `restore` in FIFO order and removes the file once all
+ * were accepted. A missing file is not an error. If `restore` rejects a
+ * record (the buffer is full), loading stops and the file is rewritten with
+ * that record and the rest; `kept_count` says how many stayed behind for the
+ * next start. Returns 0 only when the file cannot be read or rewritten.
+ */
+int snapshot_load(const char *path,
+                  SnapshotRestoreFn restore,
+                  void *context,
+                  size_t *loaded_count,
+                  size_t *kept_count,
+                  char *error,
+                  size_t error_size);
+
+#endif
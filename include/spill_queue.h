@@ -0,0 +1,75 @@
+#ifndef SPILL_QUEUE_H
+#define SPILL_QUEUE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_entry.h"
+#include "logger.h"
+
+/*
+ * FIFO overflow tier for the buffer: records are appended to fixed-size,
+ * memory-mapped segment files in `dir` and read back from the oldest one.
+ * At most two segments are mapped at a time (the write tail and the read
+ * head), so resident memory stays bounded however much is spilled; fully
+ * read segments are unmapped and deleted. Spill files are scratch space,
+ * not a durability mechanism: leftovers from a previous run are removed on
+ * open (the journal covers crash recovery).
+ */
+typedef struct {
+    uint32_t seq;
+    size_t used;
+} SpillSegment;
+
+typedef struct {
+    size_t entries;
+    size_t bytes;
+    size_t segments;
+    uint64_t spilled_total;
+    uint64_t spilled_bytes_total;
+    uint64_t paged_in_total;
+    uint64_t paged_in_bytes_total;
+} SpillStats;
+
+typedef struct {
+    char dir[256];
+    size_t segment_bytes;
+    size_t max_bytes;
+    SpillSegment *segments;
+    size_t segment_count;
+    size_t segment_capacity;
+    uint32_t next_seq;
+    unsigned char *write_map;
+    unsigned char *read_map;
+    size_t read_offset;
+    size_t bytes;
+    pthread_mutex_t mutex;
+    atomic_size_t entries;
+    _Atomic uint64_t spilled_total;
+    _Atomic uint64_t spilled_bytes_total;
+    _Atomic uint64_t paged_in_total;
+    _Atomic uint64_t paged_in_bytes_total;
+    AppLogger *logger;
+    int initialized;
+} SpillQueue;
+
+int spill_queue_open(SpillQueue *spill,
+                     const char *dir,
+                     size_t segment_bytes,
+                     size_t max_bytes,
+                     AppLogger *logger,
+                     char *error,
+                     size_t error_size);
+int spill_queue_push(SpillQueue *spill, const LogEntry *entry, char *error, size_t error_size);
+int spill_queue_pop(SpillQueue *spill,
+                    unsigned char *buffer,
+                    size_t buffer_size,
+                    LogEntryRecord *record,
+                    uint32_t *journal_segment);
+size_t spill_queue_size(SpillQueue *spill);
+void spill_queue_get_stats(SpillQueue *spill, SpillStats *out_stats);
+void spill_queue_close(SpillQueue *spill);
+
+#endif
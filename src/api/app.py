@@ -21,6 +21,10 @@ class LogRequest(BaseModel):
     message: str = Field(min_length=1, max_length=511)
 
 
+class LogBatchRequest(BaseModel):
+    logs: list[LogRequest] = Field(min_length=1, max_length=10000)
+
+
 class ProcessRequest(BaseModel):
     max_items: int = Field(default=0, ge=0, le=100000)
 
@@ -61,6 +65,23 @@ def post_logs(payload: LogRequest) -> dict:
     }
 
 
+@app.post("/logs/batch")
+def post_logs_batch(payload: LogBatchRequest) -> dict:
+    accepted, results = engine.add_logs(
+        [(item.level, item.message, item.source) for item in payload.logs]
+    )
+    if accepted <= 0:
+        raise HTTPException(status_code=500, detail={"error": engine.last_error(), "results": results})
+
+    rejected = len(payload.logs) - accepted
+    return {
+        "status": "ok" if rejected == 0 else "partial",
+        "accepted": accepted,
+        "rejected": rejected,
+        "results": results,
+    }
+
+
 @app.get("/logs")
 def get_logs() -> dict:
     data = engine.pending_logs()
@@ -85,6 +106,13 @@ def metrics() -> dict:
     return data
 
 
+@app.post("/metrics/latency/reset")
+def reset_latency_window() -> dict:
+    if not engine.reset_latency_window():
+        raise HTTPException(status_code=500, detail={"error": engine.last_error()})
+    return {"status": "ok", "message": "latency window reset"}
+
+
 @app.get("/")
 def dashboard() -> FileResponse:
     return FileResponse(WEB_DIR / "index.html")
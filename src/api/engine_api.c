@@ -2,13 +2,19 @@
 
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "buffer_engine.h"
 #include "config.h"
+#include "dead_letter.h"
+#include "journal.h"
 #include "log_entry.h"
-#include "persistence.h"
+#include "processor_workers.h"
 #include "queue_processor.h"
+#include "sink.h"
+#include "snapshot.h"
+#include "spill_queue.h"
 
 #define ENGINE_ERROR_BUFFER_SIZE 512
 #define ENGINE_JSON_SMALL 4096
@@ -17,35 +23,59 @@
 /*
  * Process-wide runtime singleton is justified here because the API wrapper
  * (FFI boundary) needs one shared in-memory queue across HTTP requests.
+ *
+ * `lifecycle` only orders init/shutdown (writers) against every other entry
+ * point (readers); operations run concurrently and rely on the component
+ * locks (buffer, pool connections, journal, sink). Writers are preferred so
+ * a steady stream of ingest cannot starve shutdown.
  */
 typedef struct {
     int initialized;
     AppConfig config;
     AppLogger logger;
     BufferEngine buffer;
-    Persistence persistence;
+    SpillQueue spill;
+    Journal journal;
+    Sink sink;
+    DeadLetterStore dead_letters;
     QueueProcessor processor;
-    pthread_mutex_t lock;
-    char last_error[ENGINE_ERROR_BUFFER_SIZE];
-    char json_metrics[ENGINE_JSON_SMALL];
-    char json_health[ENGINE_JSON_SMALL];
-    char json_process[ENGINE_JSON_SMALL];
-    char json_pending[ENGINE_JSON_PENDING];
+    ProcessorWorkers workers;
+    pthread_rwlock_t lifecycle;
+    char json_shutdown[ENGINE_JSON_SMALL];
+    size_t snapshot_restored;
 } EngineRuntime;
 
 static EngineRuntime g_runtime = {
     .initialized = 0,
-    .lock = PTHREAD_MUTEX_INITIALIZER,
+#if defined(PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP)
+    .lifecycle = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP,
+#else
+    .lifecycle = PTHREAD_RWLOCK_INITIALIZER,
+#endif
+    .json_shutdown = "{}",
 };
 
+/*
+ * Strings returned by the pointer-returning API and the last error are per
+ * calling thread (like errno): a result stays valid until the same thread
+ * calls into the engine again. The *_into() variants write into a buffer the
+ * caller owns and keep nothing.
+ */
+static _Thread_local char t_last_error[ENGINE_ERROR_BUFFER_SIZE];
+static _Thread_local char t_json_metrics[ENGINE_JSON_SMALL];
+static _Thread_local char t_json_health[ENGINE_JSON_SMALL];
+static _Thread_local char t_json_process[ENGINE_JSON_SMALL];
+static _Thread_local char t_json_shutdown[ENGINE_JSON_SMALL];
+static _Thread_local char t_json_pending[ENGINE_JSON_PENDING];
+
 static void set_last_error(const char *error_text) {
-    snprintf(g_runtime.last_error,
-             sizeof(g_runtime.last_error),
+    snprintf(t_last_error,
+             sizeof(t_last_error),
              "%s",
              error_text != NULL ? error_text : "unknown error");
 
     if (g_runtime.logger.initialized) {
-        logger_log(&g_runtime.logger, LOGGER_ERROR, "engine_api", "%s", g_runtime.last_error);
+        logger_log(&g_runtime.logger, LOGGER_ERROR, "engine_api", "%s", t_last_error);
     }
 }
 
@@ -58,11 +88,52 @@ static int ensure_initialized(void) {
     return 1;
 }
 
+/* Arena room for what the processors can hold at once: one full batch per thread. */
+static size_t arena_headroom(const AppConfig *config) {
+    size_t threads = config->processor_threads > 0 ? config->processor_threads : 1;
+    size_t batch_size =
+        config->process_batch_mode == BATCH_SIZE_ADAPTIVE ? config->process_batch_max : config->process_batch_size;
+    if (batch_size > config->buffer_capacity) {
+        batch_size = config->buffer_capacity;
+    }
+    return batch_size > 0 && threads > config->buffer_capacity / batch_size ? config->buffer_capacity
+                                                                             : threads * batch_size;
+}
+
+static int replay_into_buffer(void *context, const LogEntryRecord *record, uint32_t segment) {
+    return buffer_engine_restore((BufferEngine *)context, record, segment, NULL, 0);
+}
+
+static int restore_snapshot_entry(void *context, const LogEntryRecord *record) {
+    return buffer_engine_restore((BufferEngine *)context, record, 0, NULL, 0);
+}
+
+/* Recovers what a previous run left in the journal, then journals new ingest. */
+static int open_journal(char *error, size_t error_size) {
+    if (!journal_open(&g_runtime.journal,
+                      g_runtime.config.journal_dir,
+                      g_runtime.config.journal_segment_bytes,
+                      g_runtime.config.journal_fsync,
+                      &g_runtime.logger,
+                      error,
+                      error_size)) {
+        return 0;
+    }
+
+    if (!journal_replay(&g_runtime.journal, replay_into_buffer, &g_runtime.buffer, error, error_size)) {
+        journal_close(&g_runtime.journal);
+        return 0;
+    }
+
+    buffer_engine_attach_journal(&g_runtime.buffer, &g_runtime.journal);
+    return 1;
+}
+
 int engine_init(void) {
-    pthread_mutex_lock(&g_runtime.lock);
+    pthread_rwlock_wrlock(&g_runtime.lifecycle);
 
     if (g_runtime.initialized) {
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 1;
     }
 
@@ -70,105 +141,328 @@ int engine_init(void) {
 
     if (!config_load_from_env(&g_runtime.config, error, sizeof(error))) {
         set_last_error(error);
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 0;
     }
 
     if (!logger_init(&g_runtime.logger, g_runtime.config.log_level, stdout)) {
         set_last_error("failed to initialize logger");
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 0;
     }
 
-    if (!buffer_engine_init(&g_runtime.buffer,
-                            g_runtime.config.buffer_capacity,
-                            &g_runtime.logger,
-                            error,
-                            sizeof(error))) {
+    BufferEngineOptions buffer_options;
+    buffer_engine_default_options(&buffer_options, g_runtime.config.buffer_capacity);
+    buffer_options.queue_backend = g_runtime.config.buffer_queue_backend;
+    buffer_options.ingest_mode = g_runtime.config.buffer_ingest_mode;
+    buffer_options.use_arena = g_runtime.config.entry_arena_enabled;
+    buffer_options.arena_slot_size = g_runtime.config.entry_arena_slot_bytes;
+    buffer_options.arena_headroom = arena_headroom(&g_runtime.config);
+    buffer_options.arena_page_mode = g_runtime.config.entry_arena_pages;
+    buffer_options.arena_prefault = g_runtime.config.entry_arena_prefault;
+    buffer_options.lane_schedule = g_runtime.config.buffer_lane_schedule;
+
+    if (!buffer_engine_parse_lanes(&buffer_options,
+                                   g_runtime.config.buffer_lanes,
+                                   g_runtime.config.buffer_lane_weights,
+                                   g_runtime.config.buffer_lane_capacities,
+                                   error,
+                                   sizeof(error))) {
         set_last_error(error);
         logger_close(&g_runtime.logger);
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 0;
     }
 
-    if (!persistence_init(&g_runtime.persistence,
-                          &g_runtime.config,
-                          &g_runtime.logger,
-                          error,
-                          sizeof(error))) {
+    if (!buffer_engine_init_with_options(&g_runtime.buffer,
+                                         &buffer_options,
+                                         &g_runtime.logger,
+                                         error,
+                                         sizeof(error))) {
         set_last_error(error);
+        logger_close(&g_runtime.logger);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
+    }
+
+    if (g_runtime.config.spill_enabled) {
+        if (!spill_queue_open(&g_runtime.spill,
+                              g_runtime.config.spill_dir,
+                              g_runtime.config.spill_segment_bytes,
+                              g_runtime.config.spill_max_bytes,
+                              &g_runtime.logger,
+                              error,
+                              sizeof(error))) {
+            set_last_error(error);
+            buffer_engine_shutdown(&g_runtime.buffer);
+            logger_close(&g_runtime.logger);
+            pthread_rwlock_unlock(&g_runtime.lifecycle);
+            return 0;
+        }
+        buffer_engine_attach_spill(&g_runtime.buffer, &g_runtime.spill);
+    }
+
+    /* Both reloads come after the spill queue, so a backlog larger than the buffer overflows to disk. */
+    /* A snapshot that cannot be (fully) loaded stays on disk; it never blocks startup. */
+    g_runtime.snapshot_restored = 0;
+    size_t snapshot_kept = 0;
+    if (g_runtime.config.shutdown_snapshot &&
+        !snapshot_load(g_runtime.config.snapshot_path,
+                       restore_snapshot_entry,
+                       &g_runtime.buffer,
+                       &g_runtime.snapshot_restored,
+                       &snapshot_kept,
+                       error,
+                       sizeof(error))) {
+        logger_log(&g_runtime.logger,
+                   LOGGER_ERROR,
+                   "engine_api",
+                   "snapshot %s was not loaded and is kept: %s",
+                   g_runtime.config.snapshot_path,
+                   error);
+        error[0] = '\0';
+    }
+    if (snapshot_kept > 0) {
+        logger_log(&g_runtime.logger,
+                   LOGGER_ERROR,
+                   "engine_api",
+                   "snapshot %s holds more than the buffer; %zu entries stay in it for the next start",
+                   g_runtime.config.snapshot_path,
+                   snapshot_kept);
+    }
+    if (g_runtime.snapshot_restored > 0) {
+        logger_log(&g_runtime.logger,
+                   LOGGER_INFO,
+                   "engine_api",
+                   "restored %zu entries from snapshot %s",
+                   g_runtime.snapshot_restored,
+                   g_runtime.config.snapshot_path);
+    }
+
+    if (g_runtime.config.journal_enabled && !open_journal(error, sizeof(error))) {
+        set_last_error(error);
+        buffer_engine_shutdown(&g_runtime.buffer);
+        spill_queue_close(&g_runtime.spill);
+        logger_close(&g_runtime.logger);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
+    }
+
+    if (!sink_open(&g_runtime.sink, &g_runtime.config, &g_runtime.logger, error, sizeof(error))) {
+        set_last_error(error);
+        buffer_engine_shutdown(&g_runtime.buffer);
+        spill_queue_close(&g_runtime.spill);
+        journal_close(&g_runtime.journal);
+        logger_close(&g_runtime.logger);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
+    }
+
+    /* DEAD_LETTER_MAX_ATTEMPTS=0 disables dead-lettering: failed entries are requeued forever. */
+    int use_dead_letters = g_runtime.config.dead_letter_max_attempts > 0;
+    if (use_dead_letters &&
+        !dead_letter_open(&g_runtime.dead_letters, g_runtime.config.dead_letter_path, error, sizeof(error))) {
+        set_last_error(error);
+        sink_close(&g_runtime.sink);
         buffer_engine_shutdown(&g_runtime.buffer);
+        spill_queue_close(&g_runtime.spill);
+        journal_close(&g_runtime.journal);
         logger_close(&g_runtime.logger);
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 0;
     }
 
     if (!queue_processor_init(&g_runtime.processor,
                               &g_runtime.buffer,
-                              &g_runtime.persistence,
+                              &g_runtime.sink,
+                              use_dead_letters ? &g_runtime.dead_letters : NULL,
                               &g_runtime.logger,
                               g_runtime.config.process_batch_size,
+                              g_runtime.config.dead_letter_max_attempts,
                               error,
                               sizeof(error))) {
         set_last_error(error);
-        persistence_close(&g_runtime.persistence);
+        dead_letter_close(&g_runtime.dead_letters);
+        sink_close(&g_runtime.sink);
         buffer_engine_shutdown(&g_runtime.buffer);
+        spill_queue_close(&g_runtime.spill);
+        journal_close(&g_runtime.journal);
         logger_close(&g_runtime.logger);
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
+    }
+
+    if (g_runtime.config.process_batch_mode == BATCH_SIZE_ADAPTIVE) {
+        size_t batch_max = g_runtime.config.process_batch_max;
+        if (batch_max > g_runtime.config.buffer_capacity) {
+            batch_max = g_runtime.config.buffer_capacity;
+        }
+        queue_processor_set_adaptive(&g_runtime.processor,
+                                     g_runtime.config.process_batch_min,
+                                     batch_max,
+                                     (double)g_runtime.config.process_batch_target_ms);
+    }
+
+    if (g_runtime.config.processor_threads > 0 &&
+        !processor_workers_start(&g_runtime.workers,
+                                 &g_runtime.processor,
+                                 &g_runtime.buffer,
+                                 &g_runtime.logger,
+                                 g_runtime.config.processor_threads,
+                                 g_runtime.config.auto_process_threshold,
+                                 g_runtime.config.process_batch_size,
+                                 g_runtime.config.processor_linger_ms,
+                                 g_runtime.config.process_max_linger_ms,
+                                 error,
+                                 sizeof(error))) {
+        set_last_error(error);
+        queue_processor_shutdown(&g_runtime.processor);
+        dead_letter_close(&g_runtime.dead_letters);
+        sink_close(&g_runtime.sink);
+        buffer_engine_shutdown(&g_runtime.buffer);
+        spill_queue_close(&g_runtime.spill);
+        journal_close(&g_runtime.journal);
+        logger_close(&g_runtime.logger);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 0;
     }
 
     g_runtime.initialized = 1;
-    snprintf(g_runtime.last_error, sizeof(g_runtime.last_error), "");
+    snprintf(t_last_error, sizeof(t_last_error), "");
     logger_log(&g_runtime.logger, LOGGER_INFO, "engine_api", "runtime initialized");
 
-    pthread_mutex_unlock(&g_runtime.lock);
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
     return 1;
 }
 
 int engine_shutdown(void) {
-    pthread_mutex_lock(&g_runtime.lock);
+    pthread_rwlock_wrlock(&g_runtime.lifecycle);
 
     if (!g_runtime.initialized) {
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 1;
     }
 
-    for (;;) {
-        size_t processed = 0;
-        double elapsed = 0.0;
-        char error[ENGINE_ERROR_BUFFER_SIZE] = {0};
-
-        if (!queue_processor_process(&g_runtime.processor,
-                                     g_runtime.config.process_batch_size,
-                                     &processed,
-                                     &elapsed,
-                                     error,
-                                     sizeof(error))) {
-            set_last_error(error);
-            break;
+    const int64_t started_at = log_entry_now_ms();
+    processor_workers_stop(&g_runtime.workers);
+
+    /* Drain in parallel on every worker's pool slot while the deadline allows. */
+    size_t drain_threads = g_runtime.config.processor_threads > 0 ? g_runtime.config.processor_threads : 1;
+    size_t drained = processor_workers_drain(&g_runtime.processor,
+                                             &g_runtime.logger,
+                                             drain_threads,
+                                             g_runtime.config.process_batch_size,
+                                             started_at + g_runtime.config.shutdown_drain_timeout_ms);
+
+    /*
+     * Whatever is left survives the restart: the journal already holds it
+     * when enabled, otherwise it goes to the snapshot file.
+     */
+    size_t snapshotted = 0;
+    if (buffer_engine_queue_depth(&g_runtime.buffer) > 0 && !g_runtime.config.journal_enabled &&
+        g_runtime.config.shutdown_snapshot) {
+        char snapshot_error[ENGINE_ERROR_BUFFER_SIZE] = {0};
+        if (!snapshot_write(g_runtime.config.snapshot_path,
+                            &g_runtime.buffer,
+                            g_runtime.config.process_batch_size,
+                            &snapshotted,
+                            snapshot_error,
+                            sizeof(snapshot_error))) {
+            set_last_error(snapshot_error);
         }
+    }
 
-        if (processed == 0) {
-            break;
-        }
+    size_t remaining = buffer_engine_queue_depth(&g_runtime.buffer);
+    size_t journaled = g_runtime.config.journal_enabled ? remaining : 0;
+    size_t dropped = g_runtime.config.journal_enabled ? 0 : remaining;
+
+    char flush_error[ENGINE_ERROR_BUFFER_SIZE] = {0};
+    if (!sink_flush(&g_runtime.sink, flush_error, sizeof(flush_error))) {
+        set_last_error(flush_error);
     }
 
-    persistence_close(&g_runtime.persistence);
+    queue_processor_shutdown(&g_runtime.processor);
+    dead_letter_close(&g_runtime.dead_letters);
+    sink_close(&g_runtime.sink);
     buffer_engine_shutdown(&g_runtime.buffer);
-    logger_log(&g_runtime.logger, LOGGER_INFO, "engine_api", "runtime shutdown completed");
+    spill_queue_close(&g_runtime.spill);
+    journal_close(&g_runtime.journal);
+    long long elapsed_ms = (long long)(log_entry_now_ms() - started_at);
+    snprintf(g_runtime.json_shutdown,
+             sizeof(g_runtime.json_shutdown),
+             "{\"drained\":%zu,\"snapshotted\":%zu,\"journaled\":%zu,\"dropped\":%zu,\"elapsed_ms\":%lld}",
+             drained,
+             snapshotted,
+             journaled,
+             dropped,
+             elapsed_ms);
+    logger_log(&g_runtime.logger,
+               dropped > 0 ? LOGGER_ERROR : LOGGER_INFO,
+               "engine_api",
+               "runtime shutdown completed drained=%zu snapshotted=%zu journaled=%zu dropped=%zu elapsed_ms=%lld",
+               drained,
+               snapshotted,
+               journaled,
+               dropped,
+               elapsed_ms);
     logger_close(&g_runtime.logger);
 
     g_runtime.initialized = 0;
-    pthread_mutex_unlock(&g_runtime.lock);
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
     return 1;
 }
 
+/* Inline mode has no timer thread, so the max linger is checked on ingest. */
+static int inline_linger_due(void) {
+    if (g_runtime.workers.initialized || g_runtime.config.process_max_linger_ms <= 0) {
+        return 0;
+    }
+
+    int64_t oldest_ms = buffer_engine_oldest_ingested_at_ms(&g_runtime.buffer);
+    return oldest_ms > 0 && log_entry_now_ms() - oldest_ms >= g_runtime.config.process_max_linger_ms;
+}
+
+/*
+ * With background workers the ingest path only wakes them; processing inline
+ * is kept for PROCESSOR_THREADS=0.
+ */
+static int auto_process_if_needed(char *error, size_t error_size) {
+    /* Adaptive batching lowers the threshold along with the batch size. */
+    size_t batch_size = queue_processor_batch_size(&g_runtime.processor);
+    size_t threshold = g_runtime.config.auto_process_threshold;
+    if (g_runtime.processor.adaptive && batch_size < threshold) {
+        threshold = batch_size;
+    }
+
+    if (buffer_engine_queue_depth(&g_runtime.buffer) < threshold && !inline_linger_due()) {
+        return 1;
+    }
+
+    if (g_runtime.workers.initialized) {
+        processor_workers_notify(&g_runtime.workers);
+        return 1;
+    }
+
+    /* Keep buffering while the sink is down; the breaker decides when to retry. */
+    if (!sink_available(&g_runtime.sink)) {
+        return 1;
+    }
+
+    size_t processed = 0;
+    double elapsed = 0.0;
+    return queue_processor_process(&g_runtime.processor,
+                                   batch_size,
+                                   &processed,
+                                   &elapsed,
+                                   error,
+                                   error_size);
+}
+
 int engine_add_log(const char *level, const char *message, const char *source) {
-    pthread_mutex_lock(&g_runtime.lock);
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
 
     if (!ensure_initialized()) {
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 0;
     }
 
@@ -183,62 +477,122 @@ int engine_add_log(const char *level, const char *message, const char *source) {
                                error,
                                sizeof(error))) {
         set_last_error(error);
-        pthread_mutex_unlock(&g_runtime.lock);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
         return 0;
     }
 
-    EngineMetrics metrics;
-    if (buffer_engine_get_metrics(&g_runtime.buffer, &metrics) &&
-        metrics.queue_depth >= g_runtime.config.auto_process_threshold) {
-        size_t processed = 0;
-        double elapsed = 0.0;
-        if (!queue_processor_process(&g_runtime.processor,
-                                     g_runtime.config.process_batch_size,
-                                     &processed,
-                                     &elapsed,
-                                     error,
-                                     sizeof(error))) {
-            set_last_error(error);
-            pthread_mutex_unlock(&g_runtime.lock);
-            return 0;
-        }
+    if (!auto_process_if_needed(error, sizeof(error))) {
+        set_last_error(error);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
     }
 
-    pthread_mutex_unlock(&g_runtime.lock);
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
     return 1;
 }
 
-const char *engine_get_pending_logs(void) {
-    pthread_mutex_lock(&g_runtime.lock);
+/*
+ * Batch ingest: one FFI call, one capacity reservation and one contiguous ID
+ * range for `count` logs. Per-item BufferEnqueueStatus codes are written to
+ * `statuses` when non-NULL. Returns the number of accepted logs, or -1 when
+ * the runtime is not initialized. Accepted logs stay accepted even if the
+ * follow-up auto-processing fails (reported through engine_last_error()).
+ */
+int engine_add_logs(const char **levels, const char **messages, const char **sources, size_t count, int *statuses) {
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
 
     if (!ensure_initialized()) {
-        snprintf(g_runtime.json_pending,
-                 sizeof(g_runtime.json_pending),
-                 "{\"error\":\"%s\"}",
-                 g_runtime.last_error);
-        pthread_mutex_unlock(&g_runtime.lock);
-        return g_runtime.json_pending;
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return -1;
     }
 
-    buffer_engine_pending_json(&g_runtime.buffer,
-                               g_runtime.config.pending_preview_limit,
-                               g_runtime.json_pending,
-                               sizeof(g_runtime.json_pending));
+    if (messages == NULL || count == 0) {
+        set_last_error("invalid log batch");
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
+    }
 
-    pthread_mutex_unlock(&g_runtime.lock);
-    return g_runtime.json_pending;
+    BufferLogInput *items = (BufferLogInput *)calloc(count, sizeof(BufferLogInput));
+    if (items == NULL) {
+        set_last_error("unable to allocate log batch");
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const char *level = levels != NULL ? levels[i] : NULL;
+        const char *source = sources != NULL ? sources[i] : NULL;
+        items[i].level = (level != NULL && level[0] != '\0') ? level : "INFO";
+        items[i].source = (source != NULL && source[0] != '\0') ? source : "api";
+        items[i].message = messages[i];
+    }
+
+    char error[ENGINE_ERROR_BUFFER_SIZE] = {0};
+    size_t accepted = buffer_engine_enqueue_batch(&g_runtime.buffer, items, count, statuses, error, sizeof(error));
+    free(items);
+
+    if (accepted < count) {
+        set_last_error(error);
+    }
+
+    if (accepted > 0 && !auto_process_if_needed(error, sizeof(error))) {
+        set_last_error(error);
+    }
+
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
+    return (int)accepted;
 }
 
-const char *engine_process_queue(size_t max_items) {
-    pthread_mutex_lock(&g_runtime.lock);
+/* Length of a response written with snprintf(), or 0 when it did not fit. */
+static size_t json_length(int written, char *buffer, size_t buffer_size) {
+    if (written < 0 || (size_t)written >= buffer_size) {
+        snprintf(buffer, buffer_size, "{\"error\":\"response buffer too small\"}");
+        return 0;
+    }
+
+    return (size_t)written;
+}
+
+size_t engine_get_pending_logs_into(char *buffer, size_t buffer_size) {
+    if (buffer == NULL || buffer_size == 0) {
+        return 0;
+    }
+
+    int written = 0;
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
+
+    if (!ensure_initialized()) {
+        written = snprintf(buffer,
+                           buffer_size,
+                           "{\"error\":\"%s\"}",
+                           t_last_error);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return json_length(written, buffer, buffer_size);
+    }
+
+    written = buffer_engine_pending_json(&g_runtime.buffer, g_runtime.config.pending_preview_limit, buffer, buffer_size)
+                  ? (int)strlen(buffer)
+                  : -1;
+
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
+    return json_length(written, buffer, buffer_size);
+}
+
+size_t engine_process_queue_into(size_t max_items, char *buffer, size_t buffer_size) {
+    if (buffer == NULL || buffer_size == 0) {
+        return 0;
+    }
+
+    int written = 0;
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
 
     if (!ensure_initialized()) {
-        snprintf(g_runtime.json_process,
-                 sizeof(g_runtime.json_process),
-                 "{\"status\":\"error\",\"error\":\"%s\"}",
-                 g_runtime.last_error);
-        pthread_mutex_unlock(&g_runtime.lock);
-        return g_runtime.json_process;
+        written = snprintf(buffer,
+                           buffer_size,
+                           "{\"status\":\"error\",\"error\":\"%s\"}",
+                           t_last_error);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return json_length(written, buffer, buffer_size);
     }
 
     size_t processed = 0;
@@ -252,104 +606,327 @@ const char *engine_process_queue(size_t max_items) {
                                  error,
                                  sizeof(error))) {
         set_last_error(error);
-        snprintf(g_runtime.json_process,
-                 sizeof(g_runtime.json_process),
-                 "{\"status\":\"error\",\"error\":\"%s\"}",
-                 g_runtime.last_error);
-        pthread_mutex_unlock(&g_runtime.lock);
-        return g_runtime.json_process;
-    }
-
-    snprintf(g_runtime.json_process,
-             sizeof(g_runtime.json_process),
-             "{\"status\":\"ok\",\"processed\":%zu,\"elapsed_ms\":%.3f}",
-             processed,
-             elapsed_ms);
+        written = snprintf(buffer,
+                           buffer_size,
+                           "{\"status\":\"error\",\"error\":\"%s\"}",
+                           t_last_error);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return json_length(written, buffer, buffer_size);
+    }
+
+    written = snprintf(buffer,
+                       buffer_size,
+                       "{\"status\":\"ok\",\"processed\":%zu,\"elapsed_ms\":%.3f}",
+                       processed,
+                       elapsed_ms);
 
-    pthread_mutex_unlock(&g_runtime.lock);
-    return g_runtime.json_process;
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
+    return json_length(written, buffer, buffer_size);
 }
 
-const char *engine_get_metrics(void) {
-    pthread_mutex_lock(&g_runtime.lock);
+/*
+ * Appends the lane schedule and each lane's depth, capacity, weight and
+ * rejections, keyed by lane name. Returns the total length, or -1 if it did
+ * not fit.
+ */
+static int append_lane_json(char *buffer, size_t buffer_size, int written, const EngineMetrics *metrics) {
+    if (written < 0 || (size_t)written >= buffer_size) {
+        return -1;
+    }
+
+    size_t offset = (size_t)written;
+    written = snprintf(buffer + offset,
+                       buffer_size - offset,
+                       ",\"lane_schedule\":\"%s\"",
+                       buffer_lane_schedule_to_string(g_runtime.config.buffer_lane_schedule));
+
+    for (size_t i = 0; i < metrics->lane_count; ++i) {
+        if (written < 0 || (size_t)written >= buffer_size - offset) {
+            return -1;
+        }
+        offset += (size_t)written;
+
+        const LaneMetrics *lane = &metrics->lanes[i];
+        written = snprintf(buffer + offset,
+                           buffer_size - offset,
+                           ",\"lane_%s_depth\":%zu,\"lane_%s_capacity\":%zu,\"lane_%s_weight\":%u,"
+                           "\"lane_%s_rejected\":%llu",
+                           lane->name,
+                           lane->depth,
+                           lane->name,
+                           lane->capacity,
+                           lane->name,
+                           lane->weight,
+                           lane->name,
+                           (unsigned long long)lane->rejected);
+    }
+
+    if (written < 0 || (size_t)written >= buffer_size - offset) {
+        return -1;
+    }
+    return (int)(offset + (size_t)written);
+}
+
+/*
+ * Closes the metrics object with the latency window: count, p50, p95, p99
+ * and max per histogram. Returns the total length, or -1 if it did not fit.
+ */
+static int append_latency_json(char *buffer,
+                               size_t buffer_size,
+                               int written,
+                               const EngineMetrics *metrics,
+                               int64_t now_ms) {
+    if (written < 0 || (size_t)written >= buffer_size) {
+        return -1;
+    }
+
+    size_t offset = (size_t)written;
+    int64_t window_ms = now_ms - metrics->latency_window_started_at_ms;
+    written = snprintf(buffer + offset,
+                       buffer_size - offset,
+                       ",\"latency_window_seconds\":%.3f",
+                       window_ms > 0 ? (double)window_ms / 1000.0 : 0.0);
+
+    for (size_t kind = 0; kind < ENGINE_LATENCY_KIND_COUNT; ++kind) {
+        if (written < 0 || (size_t)written >= buffer_size - offset) {
+            return -1;
+        }
+        offset += (size_t)written;
+
+        const char *name = buffer_engine_latency_kind_to_string((EngineLatencyKind)kind);
+        const LatencySummary *summary = &metrics->latency[kind];
+        written = snprintf(buffer + offset,
+                           buffer_size - offset,
+                           ",\"%s_count\":%llu,\"%s_ms_p50\":%.3f,\"%s_ms_p95\":%.3f,"
+                           "\"%s_ms_p99\":%.3f,\"%s_ms_max\":%.3f",
+                           name,
+                           (unsigned long long)summary->count,
+                           name,
+                           summary->p50_ms,
+                           name,
+                           summary->p95_ms,
+                           name,
+                           summary->p99_ms,
+                           name,
+                           summary->max_ms);
+    }
+
+    if (written < 0 || (size_t)written >= buffer_size - offset) {
+        return -1;
+    }
+    offset += (size_t)written;
+
+    written = snprintf(buffer + offset, buffer_size - offset, "}");
+    if (written < 0 || (size_t)written >= buffer_size - offset) {
+        return -1;
+    }
+    return (int)(offset + (size_t)written);
+}
+
+size_t engine_get_metrics_into(char *buffer, size_t buffer_size) {
+    if (buffer == NULL || buffer_size == 0) {
+        return 0;
+    }
+
+    int written = 0;
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
 
     if (!ensure_initialized()) {
-        snprintf(g_runtime.json_metrics,
-                 sizeof(g_runtime.json_metrics),
-                 "{\"error\":\"%s\"}",
-                 g_runtime.last_error);
-        pthread_mutex_unlock(&g_runtime.lock);
-        return g_runtime.json_metrics;
+        written = snprintf(buffer,
+                           buffer_size,
+                           "{\"error\":\"%s\"}",
+                           t_last_error);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return json_length(written, buffer, buffer_size);
     }
 
     EngineMetrics metrics;
     if (!buffer_engine_get_metrics(&g_runtime.buffer, &metrics)) {
         set_last_error("failed to read metrics");
-        snprintf(g_runtime.json_metrics,
-                 sizeof(g_runtime.json_metrics),
-                 "{\"error\":\"%s\"}",
-                 g_runtime.last_error);
-        pthread_mutex_unlock(&g_runtime.lock);
-        return g_runtime.json_metrics;
+        written = snprintf(buffer,
+                           buffer_size,
+                           "{\"error\":\"%s\"}",
+                           t_last_error);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return json_length(written, buffer, buffer_size);
     }
 
+    PersistenceStats persistence_stats;
+    persistence_get_stats(sink_persistence(&g_runtime.sink), &persistence_stats);
+
+    JournalStats journal_stats;
+    journal_get_stats(&g_runtime.journal, &journal_stats);
+
     int64_t now_ms = log_entry_now_ms();
+    int64_t oldest_ms = buffer_engine_oldest_ingested_at_ms(&g_runtime.buffer);
+    int64_t oldest_entry_age_ms = oldest_ms > 0 && now_ms > oldest_ms ? now_ms - oldest_ms : 0;
     double uptime_seconds = 0.0;
     if (now_ms > metrics.started_at_ms) {
         uptime_seconds = (double)(now_ms - metrics.started_at_ms) / 1000.0;
     }
 
-    snprintf(g_runtime.json_metrics,
-             sizeof(g_runtime.json_metrics),
-             "{\"total_ingested\":%llu,\"total_processed\":%llu,\"total_errors\":%llu,"
-             "\"queue_depth\":%zu,\"buffer_capacity\":%zu,\"memory_bytes_estimate\":%zu,"
-             "\"last_processing_ms\":%.3f,\"uptime_seconds\":%.3f}",
-             (unsigned long long)metrics.total_ingested,
-             (unsigned long long)metrics.total_processed,
-             (unsigned long long)metrics.total_errors,
-             metrics.queue_depth,
-             metrics.buffer_capacity,
-             metrics.memory_bytes_estimate,
-             metrics.last_processing_ms,
-             uptime_seconds);
-
-    pthread_mutex_unlock(&g_runtime.lock);
-    return g_runtime.json_metrics;
+    written = snprintf(buffer,
+                       buffer_size,
+                       "{\"total_ingested\":%llu,\"total_processed\":%llu,\"total_errors\":%llu,"
+                       "\"total_dead_lettered\":%llu,\"total_dropped\":%llu,\"queue_depth\":%zu,\"buffer_capacity\":%zu,\"memory_bytes_estimate\":%zu,"
+                       "\"last_processing_ms\":%.3f,\"uptime_seconds\":%.3f,"
+                       "\"arena_slots_total\":%zu,\"arena_slots_in_use\":%zu,\"arena_high_water\":%zu,"
+                       "\"arena_fallback_allocs\":%llu,\"pipeline_in_flight\":%zu,\"pipeline_in_flight_peak\":%zu,"
+                       "\"db_pool_size\":%zu,\"db_pool_busy\":%zu,\"db_pool_utilization\":%.3f,"
+                       "\"db_pool_wait_ms_avg\":%.3f,\"db_pool_wait_ms_max\":%.3f,"
+                       "\"journal_segments\":%zu,\"journal_bytes\":%zu,\"journal_syncs\":%llu,"
+                       "\"journal_records_per_sync\":%.3f,\"journal_append_ms_avg\":%.3f,\"journal_append_ms_max\":%.3f,"
+                       "\"journal_replayed\":%llu,\"journal_recovery_ms\":%.3f,\"snapshot_restored\":%zu,"
+                       "\"spilled_entries\":%zu,\"spilled_bytes\":%zu,\"spill_segments\":%zu,\"spilled_total\":%llu,"
+                       "\"paged_in_total\":%llu,\"spill_page_in_per_sec\":%.3f,"
+                       "\"batch_size_mode\":\"%s\",\"batch_size_current\":%zu,\"oldest_entry_age_ms\":%lld,"
+                       "\"max_linger_ms\":%d",
+                       (unsigned long long)metrics.total_ingested,
+                       (unsigned long long)metrics.total_processed,
+                       (unsigned long long)metrics.total_errors,
+                       (unsigned long long)metrics.total_dead_lettered,
+                       (unsigned long long)metrics.total_dropped,
+                       metrics.queue_depth,
+                       metrics.buffer_capacity,
+                       metrics.memory_bytes_estimate,
+                       metrics.last_processing_ms,
+                       uptime_seconds,
+                       metrics.arena_slots_total,
+                       metrics.arena_slots_in_use,
+                       metrics.arena_high_water,
+                       (unsigned long long)metrics.arena_fallback_allocs,
+                       persistence_stats.pipeline_in_flight,
+                       persistence_stats.pipeline_in_flight_peak,
+                       persistence_stats.pool_size,
+                       persistence_stats.pool_busy,
+                       persistence_stats.pool_size > 0
+                           ? (double)persistence_stats.pool_busy / (double)persistence_stats.pool_size
+                           : 0.0,
+                       persistence_stats.pool_wait_ms_avg,
+                       persistence_stats.pool_wait_ms_max,
+                       journal_stats.segments,
+                       journal_stats.segment_bytes_total,
+                       (unsigned long long)journal_stats.syncs,
+                       journal_stats.syncs > 0 ? (double)journal_stats.records / (double)journal_stats.syncs : 0.0,
+                       journal_stats.append_latency_ms_avg,
+                       journal_stats.append_latency_ms_max,
+                       (unsigned long long)journal_stats.replayed,
+                       journal_stats.recovery_ms,
+                       g_runtime.snapshot_restored,
+                       metrics.spilled_entries,
+                       metrics.spilled_bytes,
+                       metrics.spill_segments,
+                       (unsigned long long)metrics.spilled_total,
+                       (unsigned long long)metrics.paged_in_total,
+                       uptime_seconds > 0.0 ? (double)metrics.paged_in_total / uptime_seconds : 0.0,
+                       batch_size_mode_to_string(g_runtime.config.process_batch_mode),
+                       queue_processor_batch_size(&g_runtime.processor),
+                       (long long)oldest_entry_age_ms,
+                       g_runtime.config.process_max_linger_ms);
+    written = append_lane_json(buffer, buffer_size, written, &metrics);
+    written = append_latency_json(buffer, buffer_size, written, &metrics, now_ms);
+
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
+    return json_length(written, buffer, buffer_size);
 }
 
-const char *engine_health(void) {
-    pthread_mutex_lock(&g_runtime.lock);
+size_t engine_health_into(char *buffer, size_t buffer_size) {
+    if (buffer == NULL || buffer_size == 0) {
+        return 0;
+    }
+
+    int written = 0;
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
 
     if (!ensure_initialized()) {
-        snprintf(g_runtime.json_health,
-                 sizeof(g_runtime.json_health),
-                 "{\"status\":\"down\",\"error\":\"%s\"}",
-                 g_runtime.last_error);
-        pthread_mutex_unlock(&g_runtime.lock);
-        return g_runtime.json_health;
+        written = snprintf(buffer,
+                           buffer_size,
+                           "{\"status\":\"down\",\"error\":\"%s\"}",
+                           t_last_error);
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return json_length(written, buffer, buffer_size);
     }
 
     char error[ENGINE_ERROR_BUFFER_SIZE] = {0};
-    int db_ok = persistence_ping(&g_runtime.persistence, error, sizeof(error));
+    int db_ok = sink_health(&g_runtime.sink, error, sizeof(error));
 
     EngineMetrics metrics;
     buffer_engine_get_metrics(&g_runtime.buffer, &metrics);
 
-    snprintf(g_runtime.json_health,
-             sizeof(g_runtime.json_health),
-             "{\"status\":\"%s\",\"db\":\"%s\",\"queue_depth\":%zu}",
-             db_ok ? "ok" : "degraded",
-             db_ok ? "up" : "down",
-             metrics.queue_depth);
+    PersistenceStats persistence_stats;
+    persistence_get_stats(sink_persistence(&g_runtime.sink), &persistence_stats);
+
+    written = snprintf(buffer,
+                       buffer_size,
+                       "{\"status\":\"%s\",\"sink\":\"%s\",\"db\":\"%s\",\"queue_depth\":%zu,"
+                       "\"breaker\":\"%s\",\"breaker_failures\":%u,\"breaker_retry_in_ms\":%lld,"
+                       "\"db_reconnects\":%llu}",
+                       db_ok ? "ok" : "degraded",
+                       sink_name(&g_runtime.sink),
+                       db_ok ? "up" : "down",
+                       metrics.queue_depth,
+                       persistence_breaker_state_to_string(persistence_stats.breaker_state),
+                       persistence_stats.breaker_failures,
+                       (long long)persistence_stats.breaker_retry_in_ms,
+                       (unsigned long long)persistence_stats.reconnects);
 
     if (!db_ok) {
         set_last_error(error);
     }
 
-    pthread_mutex_unlock(&g_runtime.lock);
-    return g_runtime.json_health;
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
+    return json_length(written, buffer, buffer_size);
+}
+
+int engine_reset_latency_window(void) {
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
+
+    if (!ensure_initialized()) {
+        pthread_rwlock_unlock(&g_runtime.lifecycle);
+        return 0;
+    }
+
+    buffer_engine_reset_latency_window(&g_runtime.buffer);
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
+    return 1;
+}
+
+const char *engine_get_pending_logs(void) {
+    engine_get_pending_logs_into(t_json_pending, sizeof(t_json_pending));
+    return t_json_pending;
+}
+
+const char *engine_process_queue(size_t max_items) {
+    engine_process_queue_into(max_items, t_json_process, sizeof(t_json_process));
+    return t_json_process;
+}
+
+const char *engine_get_metrics(void) {
+    engine_get_metrics_into(t_json_metrics, sizeof(t_json_metrics));
+    return t_json_metrics;
+}
+
+const char *engine_health(void) {
+    engine_health_into(t_json_health, sizeof(t_json_health));
+    return t_json_health;
+}
+
+size_t engine_shutdown_report_into(char *buffer, size_t buffer_size) {
+    if (buffer == NULL || buffer_size == 0) {
+        return 0;
+    }
+
+    pthread_rwlock_rdlock(&g_runtime.lifecycle);
+    int written = snprintf(buffer, buffer_size, "%s", g_runtime.json_shutdown);
+    pthread_rwlock_unlock(&g_runtime.lifecycle);
+    return json_length(written, buffer, buffer_size);
+}
+
+const char *engine_shutdown_report(void) {
+    engine_shutdown_report_into(t_json_shutdown, sizeof(t_json_shutdown));
+    return t_json_shutdown;
 }
 
 const char *engine_last_error(void) {
-    return g_runtime.last_error;
+    return t_last_error;
 }
@@ -6,6 +6,21 @@ import os
 from typing import Any
 
 
+# Initial response buffer sizes for the *_into() calls; a call that does not
+# fit returns 0 and is retried with a doubled buffer up to RESPONSE_MAX_BYTES.
+RESPONSE_SMALL_BYTES = 4096
+RESPONSE_PENDING_BYTES = 262144
+RESPONSE_MAX_BYTES = 16 * 1024 * 1024
+
+ENQUEUE_STATUSES = {
+    0: "accepted",
+    1: "invalid",
+    2: "capacity",
+    3: "error",
+    4: "journal",
+}
+
+
 class EngineClient:
     def __init__(self, library_path: str | None = None) -> None:
         path = library_path or os.environ.get("ENGINE_LIB_PATH", "build/liblog_engine.so")
@@ -20,6 +35,15 @@ class EngineClient:
         self._lib.engine_add_log.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p]
         self._lib.engine_add_log.restype = ctypes.c_int
 
+        self._lib.engine_add_logs.argtypes = [
+            ctypes.POINTER(ctypes.c_char_p),
+            ctypes.POINTER(ctypes.c_char_p),
+            ctypes.POINTER(ctypes.c_char_p),
+            ctypes.c_size_t,
+            ctypes.POINTER(ctypes.c_int),
+        ]
+        self._lib.engine_add_logs.restype = ctypes.c_int
+
         self._lib.engine_get_pending_logs.argtypes = []
         self._lib.engine_get_pending_logs.restype = ctypes.c_char_p
 
@@ -32,6 +56,22 @@ class EngineClient:
         self._lib.engine_health.argtypes = []
         self._lib.engine_health.restype = ctypes.c_char_p
 
+        for name in (
+            "engine_get_pending_logs_into",
+            "engine_get_metrics_into",
+            "engine_health_into",
+            "engine_shutdown_report_into",
+        ):
+            function = getattr(self._lib, name)
+            function.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+            function.restype = ctypes.c_size_t
+
+        self._lib.engine_process_queue_into.argtypes = [ctypes.c_size_t, ctypes.c_char_p, ctypes.c_size_t]
+        self._lib.engine_process_queue_into.restype = ctypes.c_size_t
+
+        self._lib.engine_reset_latency_window.argtypes = []
+        self._lib.engine_reset_latency_window.restype = ctypes.c_int
+
         self._lib.engine_last_error.argtypes = []
         self._lib.engine_last_error.restype = ctypes.c_char_p
 
@@ -45,12 +85,24 @@ class EngineClient:
         except json.JSONDecodeError:
             return {"status": "error", "error": "invalid json response", "raw": text}
 
+    def _call_into(self, function: Any, size: int, *args: Any) -> dict[str, Any]:
+        """Call a *_into() function with a buffer owned by this call, so concurrent threads never share one."""
+        while True:
+            buffer = ctypes.create_string_buffer(size)
+            length = function(*args, buffer, size)
+            if length > 0 or size >= RESPONSE_MAX_BYTES:
+                return self._decode_json(buffer.raw[:length] if length > 0 else buffer.value)
+            size *= 2
+
     def initialize(self) -> bool:
         return bool(self._lib.engine_init())
 
     def shutdown(self) -> bool:
         return bool(self._lib.engine_shutdown())
 
+    def shutdown_report(self) -> dict[str, Any]:
+        return self._call_into(self._lib.engine_shutdown_report_into, RESPONSE_SMALL_BYTES)
+
     def last_error(self) -> str:
         payload = self._lib.engine_last_error()
         return payload.decode("utf-8", errors="replace") if payload else "unknown error"
@@ -64,14 +116,37 @@ class EngineClient:
             )
         )
 
+    def add_logs(self, logs: list[tuple[str, str, str]]) -> tuple[int, list[str]]:
+        """Enqueue (level, message, source) tuples in one call; returns (accepted, per-item status)."""
+        count = len(logs)
+        if count == 0:
+            return 0, []
+
+        levels = (ctypes.c_char_p * count)(*(level.encode("utf-8") for level, _, _ in logs))
+        messages = (ctypes.c_char_p * count)(*(message.encode("utf-8") for _, message, _ in logs))
+        sources = (ctypes.c_char_p * count)(*(source.encode("utf-8") for _, _, source in logs))
+        statuses = (ctypes.c_int * count)()
+
+        accepted = self._lib.engine_add_logs(levels, messages, sources, count, statuses)
+        if accepted < 0:
+            return accepted, []
+
+        return accepted, [ENQUEUE_STATUSES.get(code, "error") for code in statuses]
+
     def pending_logs(self) -> dict[str, Any]:
-        return self._decode_json(self._lib.engine_get_pending_logs())
+        return self._call_into(self._lib.engine_get_pending_logs_into, RESPONSE_PENDING_BYTES)
 
     def process_queue(self, max_items: int) -> dict[str, Any]:
-        return self._decode_json(self._lib.engine_process_queue(max_items))
+        # Not retried: the batch is processed even when the report does not fit.
+        buffer = ctypes.create_string_buffer(RESPONSE_SMALL_BYTES)
+        self._lib.engine_process_queue_into(max_items, buffer, RESPONSE_SMALL_BYTES)
+        return self._decode_json(buffer.value)
 
     def metrics(self) -> dict[str, Any]:
-        return self._decode_json(self._lib.engine_get_metrics())
+        return self._call_into(self._lib.engine_get_metrics_into, RESPONSE_SMALL_BYTES)
+
+    def reset_latency_window(self) -> bool:
+        return bool(self._lib.engine_reset_latency_window())
 
     def health(self) -> dict[str, Any]:
-        return self._decode_json(self._lib.engine_health())
+        return self._call_into(self._lib.engine_health_into, RESPONSE_SMALL_BYTES)
@@ -1,8 +1,11 @@
 #include "buffer_engine.h"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
 
 static void write_error(char *error, size_t error_size, const char *message) {
     if (error != NULL && error_size > 0) {
@@ -10,48 +13,788 @@ static void write_error(char *error, size_t error_size, const char *message) {
     }
 }
 
-static void free_entry(LogEntry *entry) {
-    free(entry);
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL);
 }
 
-static size_t estimate_memory_bytes(size_t queue_depth) {
-    return queue_depth * (sizeof(LogEntry) + sizeof(LinkedListNode));
+static LogEntry *allocate_entry(BufferEngine *engine, size_t entry_size) {
+    if (engine->arena.initialized) {
+        LogEntry *slot = entry_arena_alloc(&engine->arena, entry_size);
+        if (slot != NULL) {
+            return slot;
+        }
+        atomic_fetch_add_explicit(&engine->arena_fallback_allocs, 1, memory_order_relaxed);
+    }
+
+    return (LogEntry *)malloc(entry_size);
+}
+
+static void free_entry(BufferEngine *engine, LogEntry *entry) {
+    if (entry_arena_owns(&engine->arena, entry)) {
+        entry_arena_release(&engine->arena, entry);
+        return;
+    }
+
+    log_entry_free(entry);
+}
+
+static void count_error(BufferEngine *engine) {
+    atomic_fetch_add_explicit(&engine->total_errors, 1, memory_order_relaxed);
+}
+
+/*
+ * Entries are counted before they are published and uncounted if publishing
+ * fails, so no consumer can record an outcome for an entry that a metrics
+ * snapshot does not yet count as ingested.
+ */
+static void count_ingested(BufferEngine *engine, size_t count) {
+    atomic_fetch_add_explicit(&engine->total_ingested, count, memory_order_relaxed);
+}
+
+static void uncount_ingested(BufferEngine *engine, size_t count) {
+    atomic_fetch_sub_explicit(&engine->total_ingested, count, memory_order_relaxed);
+}
+
+static void release_lane_slots(BufferEngine *engine, size_t lane, size_t count) {
+    atomic_fetch_sub_explicit(&engine->lanes[lane].depth, count, memory_order_relaxed);
+}
+
+/*
+ * Makes a freshly built entry durable before it becomes visible to
+ * consumers, so a release can never precede its journal record. On failure
+ * the entry and its reserved slot are given back.
+ */
+static int journal_entry(BufferEngine *engine, LogEntry *entry, char *error, size_t error_size) {
+    if (engine->journal == NULL || journal_append(engine->journal, entry, error, error_size)) {
+        return 1;
+    }
+
+    release_lane_slots(engine, entry->lane, 1);
+    free_entry(engine, entry);
+    atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+    count_error(engine);
+    return 0;
+}
+
+/*
+ * Claims up to `wanted` units of capacity and returns how many were granted;
+ * never lets depth exceed capacity, even transiently. With `count_in_flight`
+ * dequeued batches keep their room too (dequeues raise `in_flight` before
+ * they lower `depth`, so the sum never dips mid-move).
+ */
+static size_t reserve_slots_held(BufferEngine *engine, size_t wanted, int count_in_flight) {
+    size_t depth = atomic_load_explicit(&engine->depth, memory_order_acquire);
+    size_t granted = 0;
+    do {
+        size_t held = depth;
+        if (count_in_flight) {
+            held += atomic_load_explicit(&engine->in_flight, memory_order_relaxed);
+        }
+        if (held >= engine->capacity) {
+            return 0;
+        }
+        granted = engine->capacity - held;
+        if (granted > wanted) {
+            granted = wanted;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&engine->depth,
+                                                    &depth,
+                                                    depth + granted,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire));
+    return granted;
+}
+
+/* Room for entries already owned by the engine: requeues and restores. */
+static size_t reserve_slots(BufferEngine *engine, size_t wanted) {
+    return reserve_slots_held(engine, wanted, 0);
+}
+
+static int reserve_slot(BufferEngine *engine) {
+    return reserve_slots(engine, 1) == 1;
+}
+
+/*
+ * Room for new entries. With a spill tier attached, new entries also leave
+ * the room of in-flight batches alone and overflow to disk instead, so a
+ * failed batch can always be requeued. Without one, a full buffer rejects
+ * new entries only once `depth` alone reaches capacity.
+ */
+static size_t reserve_new_slots(BufferEngine *engine, size_t wanted) {
+    return reserve_slots_held(engine, wanted, engine->spill != NULL);
+}
+
+static int reserve_new_slot(BufferEngine *engine) {
+    return reserve_new_slots(engine, 1) == 1;
+}
+
+static size_t list_bytes(const LogEntry *first) {
+    size_t bytes = 0;
+    for (const LogEntry *cursor = first; cursor != NULL; cursor = cursor->next) {
+        bytes += log_entry_size(cursor);
+    }
+    return bytes;
+}
+
+static void account_removed(BufferEngine *engine, const LogEntry *entry) {
+    atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+    release_lane_slots(engine, entry->lane, 1);
+    atomic_fetch_sub_explicit(&engine->memory_bytes, log_entry_size(entry), memory_order_relaxed);
+}
+
+static int level_in_list(const char *levels, const char *level) {
+    size_t level_len = strlen(level);
+    const char *cursor = levels;
+    while (*cursor != '\0') {
+        size_t token_len = strcspn(cursor, ",");
+        if (token_len == level_len && strncasecmp(cursor, level, level_len) == 0) {
+            return 1;
+        }
+        cursor += token_len;
+        if (*cursor == ',') {
+            cursor++;
+        }
+    }
+    return 0;
+}
+
+/* The first lane listing the level wins; anything unlisted goes to the catch-all lane. */
+static uint8_t lane_for_level(const BufferEngine *engine, const char *level) {
+    for (size_t i = 0; engine->lane_count > 1 && i < engine->lane_count; ++i) {
+        if (level_in_list(engine->lanes[i].options.levels, level)) {
+            return (uint8_t)i;
+        }
+    }
+    return (uint8_t)engine->catch_all_lane;
+}
+
+/* Claims room in the entry's lane for a new entry; a full lane counts a rejection. */
+static int reserve_lane_slot(BufferEngine *engine, size_t lane_index) {
+    BufferLane *lane = &engine->lanes[lane_index];
+    if (lane->options.capacity == 0) {
+        atomic_fetch_add_explicit(&lane->depth, 1, memory_order_relaxed);
+        return 1;
+    }
+
+    size_t depth = atomic_load_explicit(&lane->depth, memory_order_relaxed);
+    do {
+        if (depth >= lane->options.capacity) {
+            atomic_fetch_add_explicit(&lane->rejected, 1, memory_order_relaxed);
+            return 0;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(
+        &lane->depth, &depth, depth + 1, memory_order_relaxed, memory_order_relaxed));
+    return 1;
+}
+
+/* Once anything is spilled, new entries queue behind it on disk to keep FIFO order. */
+static int spill_pending(BufferEngine *engine) {
+    return engine->spill != NULL && spill_queue_size(engine->spill) > 0;
+}
+
+static void note_in_flight_done(BufferEngine *engine, size_t count) {
+    atomic_fetch_sub_explicit(&engine->in_flight, count, memory_order_relaxed);
+}
+
+/*
+ * Overflow path: the entry is journaled like any other, then written to the
+ * spill queue instead of memory. Without a spill queue this is the old
+ * capacity rejection.
+ */
+static int enqueue_spill(BufferEngine *engine,
+                         const char *level,
+                         const char *source,
+                         const char *message,
+                         char *error,
+                         size_t error_size) {
+    if (engine->spill == NULL) {
+        count_error(engine);
+        write_error(error, error_size, "Buffer capacity reached.");
+        return 0;
+    }
+
+    LogEntry *entry = log_entry_create(0, level, source, message, log_entry_now_ms());
+    if (entry == NULL) {
+        count_error(engine);
+        write_error(error, error_size, "Unable to allocate log entry.");
+        return 0;
+    }
+
+    if (engine->journal != NULL && !journal_append(engine->journal, entry, error, error_size)) {
+        log_entry_free(entry);
+        count_error(engine);
+        return 0;
+    }
+
+    count_ingested(engine, 1);
+    int ok = spill_queue_push(engine->spill, entry, error, error_size);
+    if (!ok) {
+        uncount_ingested(engine, 1);
+        journal_release(engine->journal, entry);
+        count_error(engine);
+    }
+    log_entry_free(entry);
+    return ok;
+}
+
+/* Queue backend dispatch; callers hold engine->mutex. Pushes go to the entry's own lane. */
+static int queue_push_back(BufferEngine *engine, LogEntry *entry) {
+    BufferLane *lane = &engine->lanes[entry->lane];
+    if (engine->backend == BUFFER_QUEUE_RING) {
+        return ring_queue_push_back(&lane->ring, entry);
+    }
+    return linked_list_push_back(&lane->queue, entry);
+}
+
+static int queue_push_front(BufferEngine *engine, LogEntry *entry) {
+    BufferLane *lane = &engine->lanes[entry->lane];
+    if (engine->backend == BUFFER_QUEUE_RING) {
+        return ring_queue_push_front(&lane->ring, entry);
+    }
+    return linked_list_push_front(&lane->queue, entry);
+}
+
+static LogEntry *queue_pop_front(BufferEngine *engine, size_t lane) {
+    if (engine->backend == BUFFER_QUEUE_RING) {
+        return ring_queue_pop_front(&engine->lanes[lane].ring);
+    }
+    return linked_list_pop_front(&engine->lanes[lane].queue);
+}
+
+static size_t queue_pop_front_batch(BufferEngine *engine, size_t lane, size_t max_items, LinkedList *out_list) {
+    if (engine->backend != BUFFER_QUEUE_RING) {
+        return linked_list_pop_front_batch(&engine->lanes[lane].queue, max_items, out_list);
+    }
+
+    size_t count = 0;
+    LogEntry *entry = NULL;
+    while (count < max_items && (entry = ring_queue_pop_front(&engine->lanes[lane].ring)) != NULL) {
+        linked_list_push_back(out_list, entry);
+        count++;
+    }
+    return count;
+}
+
+/* Appends every entry of `entries` to the tail of its lane, preserving their order. */
+static void queue_append_batch(BufferEngine *engine, LinkedList *entries) {
+    if (engine->backend != BUFFER_QUEUE_RING && engine->lane_count == 1) {
+        linked_list_append_list(&engine->lanes[0].queue, entries);
+        return;
+    }
+
+    LogEntry *entry = NULL;
+    while ((entry = linked_list_pop_front(entries)) != NULL) {
+        queue_push_back(engine, entry);
+    }
+}
+
+/* Puts every entry of `entries` back at the head of its lane, preserving their order. */
+static void queue_prepend_batch(BufferEngine *engine, LinkedList *entries) {
+    if (engine->backend != BUFFER_QUEUE_RING && engine->lane_count == 1) {
+        linked_list_prepend_list(&engine->lanes[0].queue, entries);
+        return;
+    }
+
+    LogEntry *cursor = entries->tail;
+    while (cursor != NULL) {
+        LogEntry *previous = cursor->prev;
+        queue_push_front(engine, cursor);
+        cursor = previous;
+    }
+    linked_list_init(entries);
+}
+
+/* Returns the entry at position `index` of a lane, given the entry at `index - 1` (NULL for the head). */
+static const LogEntry *queue_peek_next(const BufferEngine *engine,
+                                       size_t lane,
+                                       const LogEntry *previous,
+                                       size_t index) {
+    if (engine->backend == BUFFER_QUEUE_RING) {
+        return ring_queue_at(&engine->lanes[lane].ring, index);
+    }
+    return previous == NULL ? engine->lanes[lane].queue.head : previous->next;
+}
+
+static size_t lane_pop_batch_locked(BufferEngine *engine, size_t lane, size_t max_items, LinkedList *out_list) {
+    size_t count = queue_pop_front_batch(engine, lane, max_items, out_list);
+    release_lane_slots(engine, lane, count);
+    return count;
+}
+
+/*
+ * Pops up to `max_items` across lanes; callers hold engine->mutex. Strict
+ * drains lanes in priority order. Weighted gives each non-empty lane up to
+ * `weight` entries per turn; the turn carries over between calls, so small
+ * batches share lanes by weight too.
+ */
+static size_t lanes_pop_batch_locked(BufferEngine *engine, size_t max_items, LinkedList *out_list) {
+    size_t count = 0;
+    if (engine->lane_schedule == BUFFER_LANES_STRICT || engine->lane_count == 1) {
+        for (size_t lane = 0; lane < engine->lane_count && count < max_items; ++lane) {
+            count += lane_pop_batch_locked(engine, lane, max_items - count, out_list);
+        }
+        return count;
+    }
+
+    size_t idle_lanes = 0;
+    while (count < max_items && idle_lanes < engine->lane_count) {
+        if (engine->lane_credit == 0) {
+            engine->lane_credit = engine->lanes[engine->lane_cursor].options.weight;
+        }
+
+        size_t wanted = max_items - count;
+        if (wanted > engine->lane_credit) {
+            wanted = engine->lane_credit;
+        }
+        size_t taken = lane_pop_batch_locked(engine, engine->lane_cursor, wanted, out_list);
+        count += taken;
+        engine->lane_credit -= (unsigned int)taken;
+        idle_lanes = taken == 0 ? idle_lanes + 1 : 0;
+
+        if (taken < wanted || engine->lane_credit == 0) {
+            engine->lane_cursor = (engine->lane_cursor + 1) % engine->lane_count;
+            engine->lane_credit = 0;
+        }
+    }
+    return count;
+}
+
+static void destroy_lane_queues(BufferEngine *engine) {
+    for (size_t lane = 0; lane < BUFFER_MAX_LANES; ++lane) {
+        ring_queue_destroy(&engine->lanes[lane].ring);
+    }
+}
+
+/* Moves entries published by lock-free producers into the backend queue. */
+static void drain_inbox_locked(BufferEngine *engine) {
+    if (engine->ingest_mode != BUFFER_INGEST_LOCKFREE) {
+        return;
+    }
+
+    LogEntry *entry = NULL;
+    while ((entry = (LogEntry *)mpmc_queue_pop(&engine->inbox)) != NULL) {
+        if (!queue_push_back(engine, entry)) {
+            account_removed(engine, entry);
+            count_error(engine);
+            journal_release(engine->journal, entry);
+            free_entry(engine, entry);
+        }
+    }
+}
+
+/*
+ * Builds an entry from a recovered or paged-in record and appends it to the
+ * backend queue; the caller holds engine->mutex and has reserved the slot.
+ * On failure the slot is given back.
+ */
+static int push_restored_locked(BufferEngine *engine,
+                                const LogEntryRecord *record,
+                                uint32_t journal_segment,
+                                size_t entry_size) {
+    LogEntry *entry = allocate_entry(engine, entry_size);
+    if (entry == NULL) {
+        atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+        return 0;
+    }
+
+    log_entry_init(entry, entry_size, 0, record->level, record->source, record->message, record->ingested_at_ms);
+    entry->attempts = record->attempts;
+    entry->journal_segment = journal_segment;
+    entry->id = atomic_fetch_add_explicit(&engine->next_log_id, 1, memory_order_relaxed);
+    entry->lane = lane_for_level(engine, record->level);
+
+    if (!queue_push_back(engine, entry)) {
+        free_entry(engine, entry);
+        atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+        return 0;
+    }
+
+    atomic_fetch_add_explicit(&engine->lanes[entry->lane].depth, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&engine->memory_bytes, entry_size, memory_order_relaxed);
+    return 1;
+}
+
+/*
+ * Pages spilled entries back in, oldest first. Room held by in-flight
+ * entries is left alone so a failed batch can always be requeued.
+ */
+static void refill_from_spill_locked(BufferEngine *engine) {
+    if (!spill_pending(engine)) {
+        return;
+    }
+
+    unsigned char buffer[LOG_ENTRY_RECORD_MAX_SIZE];
+    while (spill_queue_size(engine->spill) > 0) {
+        size_t held = atomic_load_explicit(&engine->depth, memory_order_acquire) +
+                      atomic_load_explicit(&engine->in_flight, memory_order_relaxed);
+        if (held >= engine->capacity || !reserve_slot(engine)) {
+            return;
+        }
+
+        LogEntryRecord record;
+        uint32_t journal_segment = 0;
+        int popped = spill_queue_pop(engine->spill, buffer, sizeof(buffer), &record, &journal_segment);
+        if (popped == 0) {
+            atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+            return;
+        }
+
+        /* A frame that does not decode is already consumed: count it and release its journal record. */
+        size_t entry_size = popped > 0 ? log_entry_required_size(record.level, record.source, record.message) : 0;
+        if (entry_size == 0 || !push_restored_locked(engine, &record, journal_segment, entry_size)) {
+            if (entry_size == 0) {
+                atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+            }
+            journal_release_segment(engine->journal, journal_segment);
+            count_error(engine);
+        }
+    }
+}
+
+BufferQueueBackend buffer_queue_backend_from_string(const char *text) {
+    if (text != NULL && strcmp(text, "ring") == 0) {
+        return BUFFER_QUEUE_RING;
+    }
+
+    return BUFFER_QUEUE_LIST;
+}
+
+const char *buffer_queue_backend_to_string(BufferQueueBackend backend) {
+    return backend == BUFFER_QUEUE_RING ? "ring" : "list";
+}
+
+BufferIngestMode buffer_ingest_mode_from_string(const char *text) {
+    if (text != NULL && strcmp(text, "lockfree") == 0) {
+        return BUFFER_INGEST_LOCKFREE;
+    }
+
+    return BUFFER_INGEST_MUTEX;
+}
+
+const char *buffer_ingest_mode_to_string(BufferIngestMode mode) {
+    return mode == BUFFER_INGEST_LOCKFREE ? "lockfree" : "mutex";
+}
+
+BufferLaneSchedule buffer_lane_schedule_from_string(const char *text) {
+    if (text != NULL && strcmp(text, "strict") == 0) {
+        return BUFFER_LANES_STRICT;
+    }
+
+    return BUFFER_LANES_WEIGHTED;
+}
+
+const char *buffer_lane_schedule_to_string(BufferLaneSchedule schedule) {
+    return schedule == BUFFER_LANES_STRICT ? "strict" : "weighted";
+}
+
+/* Copies `text` without blanks; fails if nothing is left or it does not fit. */
+static int copy_trimmed(char *out, size_t out_size, const char *text, size_t length) {
+    size_t used = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (text[i] == ' ' || text[i] == '\t') {
+            continue;
+        }
+        if (used + 1 >= out_size) {
+            return 0;
+        }
+        out[used++] = text[i];
+    }
+    out[used] = '\0';
+    return used > 0;
+}
+
+/* Lane names become metrics keys, so they are limited to letters, digits and '_'. */
+static int valid_lane_name(const char *name) {
+    for (size_t i = 0; name[i] != '\0'; ++i) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Returns the next comma-separated field of `*cursor` as an unsigned value; blank or missing fields give 0. */
+static int next_list_value(const char **cursor, unsigned long *value) {
+    *value = 0;
+    if (*cursor == NULL || **cursor == '\0') {
+        return 1;
+    }
+
+    size_t length = strcspn(*cursor, ",");
+    char field[32] = {0};
+    if (copy_trimmed(field, sizeof(field), *cursor, length)) {
+        char *end = NULL;
+        *value = strtoul(field, &end, 10);
+        if (end == field || *end != '\0') {
+            return 0;
+        }
+    } else if (length >= sizeof(field)) {
+        return 0;
+    }
+
+    *cursor += length;
+    if (**cursor == ',') {
+        (*cursor)++;
+    }
+    return 1;
+}
+
+int buffer_engine_parse_lanes(BufferEngineOptions *options,
+                              const char *spec,
+                              const char *weights,
+                              const char *capacities,
+                              char *error,
+                              size_t error_size) {
+    if (options == NULL) {
+        write_error(error, error_size, "Buffer options are NULL.");
+        return 0;
+    }
+
+    options->lane_count = 0;
+    memset(options->lanes, 0, sizeof(options->lanes));
+    if (spec == NULL || spec[0] == '\0') {
+        return 1;
+    }
+
+    const char *cursor = spec;
+    while (*cursor != '\0') {
+        size_t length = strcspn(cursor, ";");
+        const char *separator = memchr(cursor, '=', length);
+        if (length > 0 && options->lane_count == BUFFER_MAX_LANES) {
+            write_error(error, error_size, "Too many buffer lanes.");
+            return 0;
+        }
+
+        if (length > 0) {
+            BufferLaneOptions *lane = &options->lanes[options->lane_count];
+            if (separator == NULL ||
+                !copy_trimmed(lane->name, sizeof(lane->name), cursor, (size_t)(separator - cursor)) ||
+                !valid_lane_name(lane->name) ||
+                !copy_trimmed(lane->levels, sizeof(lane->levels), separator + 1, length - (size_t)(separator - cursor) - 1)) {
+                write_error(error, error_size, "Invalid buffer lane; expected name=LEVEL[,LEVEL...].");
+                return 0;
+            }
+            options->lane_count++;
+        }
+
+        cursor += length;
+        if (*cursor == ';') {
+            cursor++;
+        }
+    }
+
+    for (size_t i = 0; i < options->lane_count; ++i) {
+        unsigned long weight = 0;
+        unsigned long capacity = 0;
+        if (!next_list_value(&weights, &weight) || !next_list_value(&capacities, &capacity)) {
+            write_error(error, error_size, "Invalid buffer lane weight or capacity.");
+            return 0;
+        }
+        options->lanes[i].weight = weight > 0 ? (unsigned int)weight : 1;
+        options->lanes[i].capacity = (size_t)capacity;
+    }
+
+    return 1;
+}
+
+const char *buffer_engine_latency_kind_to_string(EngineLatencyKind kind) {
+    switch (kind) {
+        case ENGINE_LATENCY_ENQUEUE:
+            return "enqueue";
+        case ENGINE_LATENCY_QUEUE_WAIT:
+            return "queue_wait";
+        case ENGINE_LATENCY_PERSIST_BATCH:
+            return "persist_batch";
+        case ENGINE_LATENCY_PERSIST_ROW:
+            return "persist_row";
+        case ENGINE_LATENCY_END_TO_END:
+            return "end_to_end";
+        default:
+            return "unknown";
+    }
+}
+
+void buffer_engine_default_options(BufferEngineOptions *options, size_t capacity) {
+    if (options == NULL) {
+        return;
+    }
+
+    memset(options, 0, sizeof(*options));
+    options->capacity = capacity;
+    options->queue_backend = BUFFER_QUEUE_LIST;
+    options->ingest_mode = BUFFER_INGEST_MUTEX;
+    options->use_arena = 0;
+    options->arena_slot_size = 0;
+    options->arena_headroom = 0;
+    options->arena_page_mode = ENTRY_ARENA_PAGES_DEFAULT;
+    options->arena_prefault = 0;
+    options->lane_count = 0;
+    options->lane_schedule = BUFFER_LANES_WEIGHTED;
 }
 
 int buffer_engine_init(BufferEngine *engine, size_t capacity, AppLogger *logger, char *error, size_t error_size) {
-    if (engine == NULL) {
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, capacity);
+    return buffer_engine_init_with_options(engine, &options, logger, error, error_size);
+}
+
+int buffer_engine_init_with_options(BufferEngine *engine,
+                                    const BufferEngineOptions *options,
+                                    AppLogger *logger,
+                                    char *error,
+                                    size_t error_size) {
+    if (engine == NULL || options == NULL) {
         write_error(error, error_size, "BufferEngine is NULL.");
         return 0;
     }
 
+    const size_t capacity = options->capacity;
     if (capacity == 0) {
         write_error(error, error_size, "Buffer capacity must be > 0.");
         return 0;
     }
 
+    if (options->lane_count > BUFFER_MAX_LANES) {
+        write_error(error, error_size, "Too many buffer lanes.");
+        return 0;
+    }
+
     memset(engine, 0, sizeof(*engine));
-    linked_list_init(&engine->queue);
+    engine->backend = options->queue_backend;
+    engine->ingest_mode = options->ingest_mode;
+    engine->lane_schedule = options->lane_schedule;
+    engine->lane_count = options->lane_count > 0 ? options->lane_count : 1;
+    engine->catch_all_lane = engine->lane_count - 1;
+
+    for (size_t i = engine->lane_count; i-- > 0;) {
+        BufferLane *lane = &engine->lanes[i];
+        if (options->lane_count > 0) {
+            lane->options = options->lanes[i];
+        } else {
+            snprintf(lane->options.name, sizeof(lane->options.name), "default");
+            snprintf(lane->options.levels, sizeof(lane->options.levels), "*");
+        }
+        if (lane->options.weight == 0) {
+            lane->options.weight = 1;
+        }
+        if (level_in_list(lane->options.levels, "*")) {
+            engine->catch_all_lane = i;
+        }
+        linked_list_init(&lane->queue);
+        atomic_init(&lane->depth, 0);
+        atomic_init(&lane->rejected, 0);
+    }
+
+    /* A lane can hold the whole buffer: requeues and page-ins ignore lane limits. */
+    for (size_t i = 0; engine->backend == BUFFER_QUEUE_RING && i < engine->lane_count; ++i) {
+        if (!ring_queue_init(&engine->lanes[i].ring, capacity)) {
+            destroy_lane_queues(engine);
+            write_error(error, error_size, "Unable to allocate ring queue.");
+            return 0;
+        }
+    }
+
+    if (engine->ingest_mode == BUFFER_INGEST_LOCKFREE && !mpmc_queue_init(&engine->inbox, capacity)) {
+        destroy_lane_queues(engine);
+        write_error(error, error_size, "Unable to allocate lock-free inbox.");
+        return 0;
+    }
+
+    if (options->use_arena) {
+        size_t slot_size = options->arena_slot_size;
+        if (slot_size == 0) {
+            slot_size = sizeof(LogEntry) + LOG_LEVEL_MAX_LEN + LOG_SOURCE_MAX_LEN + LOG_MESSAGE_MAX_LEN;
+        }
+
+        /* Dequeued entries keep their slot until released, so capacity alone runs dry under load. */
+        if (!entry_arena_init(&engine->arena,
+                              capacity + options->arena_headroom,
+                              slot_size,
+                              options->arena_page_mode,
+                              options->arena_prefault,
+                              error,
+                              error_size)) {
+            mpmc_queue_destroy(&engine->inbox);
+            destroy_lane_queues(engine);
+            return 0;
+        }
+    }
 
     if (pthread_mutex_init(&engine->mutex, NULL) != 0) {
+        entry_arena_destroy(&engine->arena);
+        mpmc_queue_destroy(&engine->inbox);
+        destroy_lane_queues(engine);
         write_error(error, error_size, "Failed to initialize buffer mutex.");
         return 0;
     }
 
-    engine->next_log_id = 1;
+    for (size_t kind = 0; kind < ENGINE_LATENCY_KIND_COUNT; ++kind) {
+        if (!latency_histogram_init(&engine->latency[kind])) {
+            while (kind > 0) {
+                latency_histogram_destroy(&engine->latency[--kind]);
+            }
+            pthread_mutex_destroy(&engine->mutex);
+            entry_arena_destroy(&engine->arena);
+            mpmc_queue_destroy(&engine->inbox);
+            destroy_lane_queues(engine);
+            write_error(error, error_size, "Failed to initialize latency histograms.");
+            return 0;
+        }
+    }
+
+    atomic_init(&engine->next_log_id, 1);
+    atomic_init(&engine->total_ingested, 0);
+    atomic_init(&engine->total_errors, 0);
+    atomic_init(&engine->arena_fallback_allocs, 0);
+    atomic_init(&engine->depth, 0);
+    atomic_init(&engine->memory_bytes, 0);
+    atomic_init(&engine->in_flight, 0);
+    atomic_init(&engine->total_processed, 0);
+    atomic_init(&engine->total_dead_lettered, 0);
+    atomic_init(&engine->total_dropped, 0);
+    atomic_init(&engine->last_processing_ms, 0.0);
+    atomic_init(&engine->last_processed_at_ms, 0);
     engine->capacity = capacity;
-    engine->metrics.buffer_capacity = capacity;
-    engine->metrics.started_at_ms = log_entry_now_ms();
-    engine->metrics.last_processed_at_ms = 0;
-    engine->metrics.last_processing_ms = 0.0;
-    engine->metrics.total_errors = 0;
-    engine->metrics.total_ingested = 0;
-    engine->metrics.total_processed = 0;
-    engine->metrics.queue_depth = 0;
-    engine->metrics.memory_bytes_estimate = 0;
+    engine->started_at_ms = log_entry_now_ms();
+    atomic_init(&engine->latency_window_started_at_ms, engine->started_at_ms);
     engine->logger = logger;
     engine->initialized = 1;
 
-    logger_log(logger, LOGGER_INFO, "buffer_engine", "initialized capacity=%zu", capacity);
+    if (engine->arena.initialized) {
+        logger_log(logger,
+                   LOGGER_INFO,
+                   "buffer_engine",
+                   "initialized capacity=%zu backend=%s ingest=%s arena_slots=%zu arena_slot_size=%zu arena_pages=%s",
+                   capacity,
+                   buffer_queue_backend_to_string(engine->backend),
+                   buffer_ingest_mode_to_string(engine->ingest_mode),
+                   engine->arena.slot_count,
+                   engine->arena.slot_size,
+                   entry_arena_page_mode_to_string(engine->arena.page_mode));
+    } else {
+        logger_log(logger,
+                   LOGGER_INFO,
+                   "buffer_engine",
+                   "initialized capacity=%zu backend=%s ingest=%s",
+                   capacity,
+                   buffer_queue_backend_to_string(engine->backend),
+                   buffer_ingest_mode_to_string(engine->ingest_mode));
+    }
+    for (size_t i = 0; engine->lane_count > 1 && i < engine->lane_count; ++i) {
+        const BufferLaneOptions *lane = &engine->lanes[i].options;
+        logger_log(logger,
+                   LOGGER_INFO,
+                   "buffer_engine",
+                   "lane %zu name=%s levels=%s capacity=%zu weight=%u schedule=%s",
+                   i,
+                   lane->name,
+                   lane->levels,
+                   lane->capacity,
+                   lane->weight,
+                   buffer_lane_schedule_to_string(engine->lane_schedule));
+    }
     return 1;
 }
 
@@ -60,22 +803,98 @@ void buffer_engine_shutdown(BufferEngine *engine) {
         return;
     }
 
+    /* Not released to the journal: whatever is still queued gets replayed next start. */
     pthread_mutex_lock(&engine->mutex);
-    linked_list_clear(&engine->queue, free_entry);
-    engine->metrics.queue_depth = 0;
-    engine->metrics.memory_bytes_estimate = 0;
+    drain_inbox_locked(engine);
+    for (size_t lane = 0; lane < engine->lane_count; ++lane) {
+        LogEntry *entry = NULL;
+        while ((entry = queue_pop_front(engine, lane)) != NULL) {
+            free_entry(engine, entry);
+        }
+        atomic_store(&engine->lanes[lane].depth, 0);
+    }
+    atomic_store(&engine->depth, 0);
+    atomic_store(&engine->memory_bytes, 0);
     pthread_mutex_unlock(&engine->mutex);
 
     pthread_mutex_destroy(&engine->mutex);
+    for (size_t kind = 0; kind < ENGINE_LATENCY_KIND_COUNT; ++kind) {
+        latency_histogram_destroy(&engine->latency[kind]);
+    }
+    entry_arena_destroy(&engine->arena);
+    mpmc_queue_destroy(&engine->inbox);
+    destroy_lane_queues(engine);
     engine->initialized = 0;
 }
 
-int buffer_engine_enqueue(BufferEngine *engine,
-                          const char *level,
-                          const char *source,
-                          const char *message,
-                          char *error,
-                          size_t error_size) {
+/*
+ * A full lane refuses new entries outright rather than spilling them, so a
+ * flood on one lane cannot take the room other lanes need.
+ */
+static int reject_lane_full(BufferEngine *engine, char *error, size_t error_size) {
+    count_error(engine);
+    write_error(error, error_size, "Lane capacity reached.");
+    return 0;
+}
+
+static int enqueue_lockfree(BufferEngine *engine,
+                            const char *level,
+                            const char *source,
+                            const char *message,
+                            size_t entry_size,
+                            char *error,
+                            size_t error_size) {
+    uint8_t lane = lane_for_level(engine, level);
+    if (!reserve_lane_slot(engine, lane)) {
+        return reject_lane_full(engine, error, error_size);
+    }
+
+    if (spill_pending(engine) || !reserve_new_slot(engine)) {
+        release_lane_slots(engine, lane, 1);
+        return enqueue_spill(engine, level, source, message, error, error_size);
+    }
+
+    LogEntry *entry = allocate_entry(engine, entry_size);
+    if (entry == NULL) {
+        release_lane_slots(engine, lane, 1);
+        atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+        count_error(engine);
+        write_error(error, error_size, "Unable to allocate log entry.");
+        return 0;
+    }
+
+    log_entry_init(entry, entry_size, 0, level, source, message, log_entry_now_ms());
+    entry->lane = lane;
+    if (!journal_entry(engine, entry, error, error_size)) {
+        return 0;
+    }
+    entry->id = atomic_fetch_add_explicit(&engine->next_log_id, 1, memory_order_relaxed);
+
+    /* Account before publishing: a consumer may pop the entry immediately. */
+    atomic_fetch_add_explicit(&engine->memory_bytes, entry_size, memory_order_relaxed);
+    count_ingested(engine, 1);
+
+    if (!mpmc_queue_push(&engine->inbox, entry)) {
+        atomic_fetch_sub_explicit(&engine->memory_bytes, entry_size, memory_order_relaxed);
+        uncount_ingested(engine, 1);
+        journal_release(engine->journal, entry);
+        free_entry(engine, entry);
+        release_lane_slots(engine, lane, 1);
+        atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+        count_error(engine);
+        write_error(error, error_size, "Unable to enqueue entry.");
+        return 0;
+    }
+
+    return 1;
+}
+
+static int enqueue_one(BufferEngine *engine,
+                       const char *level,
+                       const char *source,
+                       const char *message,
+                       char *error,
+                       size_t error_size) {
     if (engine == NULL || !engine->initialized) {
         write_error(error, error_size, "Buffer engine is not initialized.");
         return 0;
@@ -86,48 +905,345 @@ int buffer_engine_enqueue(BufferEngine *engine,
         return 0;
     }
 
-    pthread_mutex_lock(&engine->mutex);
-
-    if (engine->metrics.queue_depth >= engine->capacity) {
-        engine->metrics.total_errors++;
-        pthread_mutex_unlock(&engine->mutex);
-        write_error(error, error_size, "Buffer capacity reached.");
+    size_t entry_size = log_entry_required_size(level, source, message);
+    if (entry_size == 0) {
+        count_error(engine);
+        write_error(error, error_size, "Invalid log content lengths.");
         return 0;
     }
 
-    LogEntry *entry = (LogEntry *)calloc(1, sizeof(LogEntry));
+    if (engine->ingest_mode == BUFFER_INGEST_LOCKFREE) {
+        return enqueue_lockfree(engine, level, source, message, entry_size, error, error_size);
+    }
+
+    uint8_t lane = lane_for_level(engine, level);
+    if (!reserve_lane_slot(engine, lane)) {
+        return reject_lane_full(engine, error, error_size);
+    }
+
+    if (spill_pending(engine) || !reserve_new_slot(engine)) {
+        release_lane_slots(engine, lane, 1);
+        return enqueue_spill(engine, level, source, message, error, error_size);
+    }
+
+    LogEntry *entry = allocate_entry(engine, entry_size);
     if (entry == NULL) {
-        engine->metrics.total_errors++;
-        pthread_mutex_unlock(&engine->mutex);
+        release_lane_slots(engine, lane, 1);
+        atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+        count_error(engine);
         write_error(error, error_size, "Unable to allocate log entry.");
         return 0;
     }
 
-    if (!log_entry_init(entry, engine->next_log_id, level, source, message, log_entry_now_ms())) {
-        free(entry);
-        engine->metrics.total_errors++;
-        pthread_mutex_unlock(&engine->mutex);
-        write_error(error, error_size, "Invalid log content lengths.");
+    log_entry_init(entry, entry_size, 0, level, source, message, log_entry_now_ms());
+    entry->lane = lane;
+    if (!journal_entry(engine, entry, error, error_size)) {
         return 0;
     }
 
-    if (!linked_list_push_back(&engine->queue, entry)) {
-        free(entry);
-        engine->metrics.total_errors++;
+    /* IDs are assigned under the mutex so they follow queue order. */
+    pthread_mutex_lock(&engine->mutex);
+    uint64_t id = atomic_load_explicit(&engine->next_log_id, memory_order_relaxed);
+    entry->id = id;
+
+    if (!queue_push_back(engine, entry)) {
         pthread_mutex_unlock(&engine->mutex);
+        journal_release(engine->journal, entry);
+        free_entry(engine, entry);
+        release_lane_slots(engine, lane, 1);
+        atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+        count_error(engine);
         write_error(error, error_size, "Unable to enqueue entry.");
         return 0;
     }
 
-    engine->next_log_id++;
-    engine->metrics.total_ingested++;
-    engine->metrics.queue_depth = linked_list_size(&engine->queue);
-    engine->metrics.memory_bytes_estimate = estimate_memory_bytes(engine->metrics.queue_depth);
+    atomic_store_explicit(&engine->next_log_id, id + 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&engine->memory_bytes, entry_size, memory_order_relaxed);
+    count_ingested(engine, 1);
 
     pthread_mutex_unlock(&engine->mutex);
     return 1;
 }
 
+/*
+ * Puts a recovered record back at the tail without journaling it again: it
+ * is already on disk in `journal_segment`. Keeps the original ingest time
+ * and attempt count; the ID is new.
+ */
+int buffer_engine_restore(BufferEngine *engine,
+                          const LogEntryRecord *record,
+                          uint32_t journal_segment,
+                          char *error,
+                          size_t error_size) {
+    if (engine == NULL || !engine->initialized || record == NULL) {
+        write_error(error, error_size, "Invalid restore request.");
+        return 0;
+    }
+
+    size_t entry_size = log_entry_required_size(record->level, record->source, record->message);
+    if (entry_size == 0) {
+        write_error(error, error_size, "Invalid log content lengths.");
+        return 0;
+    }
+
+    if (spill_pending(engine) || !reserve_slot(engine)) {
+        LogEntry *spilled = NULL;
+        if (engine->spill != NULL) {
+            spilled = log_entry_create(0, record->level, record->source, record->message, record->ingested_at_ms);
+        }
+        if (spilled == NULL) {
+            write_error(error, error_size, "Buffer capacity reached.");
+            return 0;
+        }
+        spilled->attempts = record->attempts;
+        spilled->journal_segment = journal_segment;
+        int ok = spill_queue_push(engine->spill, spilled, error, error_size);
+        log_entry_free(spilled);
+        return ok;
+    }
+
+    pthread_mutex_lock(&engine->mutex);
+    drain_inbox_locked(engine);
+    int ok = push_restored_locked(engine, record, journal_segment, entry_size);
+    pthread_mutex_unlock(&engine->mutex);
+
+    if (!ok) {
+        write_error(error, error_size, "Unable to enqueue entry.");
+    }
+    return ok;
+}
+
+static size_t batch_item_size(const BufferLogInput *item) {
+    if (item->level == NULL || item->source == NULL || item->message == NULL || item->message[0] == '\0') {
+        return 0;
+    }
+
+    return log_entry_required_size(item->level, item->source, item->message);
+}
+
+static void set_status(int *statuses, size_t index, BufferEnqueueStatus status) {
+    if (statuses != NULL) {
+        statuses[index] = (int)status;
+    }
+}
+
+/* Journals and spills batch items that did not fit in memory; returns how many were spilled. */
+static size_t spill_batch(BufferEngine *engine, LinkedList *overflow, int *statuses, size_t *rejected) {
+    int journaled = engine->journal == NULL || journal_append_batch(engine->journal, overflow, NULL, 0);
+    size_t spilled = 0;
+
+    LogEntry *entry = NULL;
+    while ((entry = linked_list_pop_front(overflow)) != NULL) {
+        size_t index = (size_t)entry->id;
+        if (!journaled) {
+            set_status(statuses, index, BUFFER_ENQUEUE_JOURNAL_ERROR);
+            (*rejected)++;
+        } else if (!spill_queue_push(engine->spill, entry, NULL, 0)) {
+            journal_release(engine->journal, entry);
+            set_status(statuses, index, BUFFER_ENQUEUE_FULL);
+            (*rejected)++;
+        } else {
+            spilled++;
+        }
+        log_entry_free(entry);
+    }
+
+    return spilled;
+}
+
+/*
+ * Enqueues `count` items with a single capacity reservation and a contiguous
+ * ID range. Entries are built outside the queue mutex; per-item outcomes are
+ * written to `statuses` (BufferEnqueueStatus values) when it is non-NULL.
+ * Returns the number of accepted items.
+ */
+static size_t enqueue_many(BufferEngine *engine,
+                           const BufferLogInput *items,
+                           size_t count,
+                           int *statuses,
+                           char *error,
+                           size_t error_size) {
+    if (engine == NULL || !engine->initialized) {
+        write_error(error, error_size, "Buffer engine is not initialized.");
+        return 0;
+    }
+
+    if (items == NULL || count == 0) {
+        write_error(error, error_size, "Invalid log batch.");
+        return 0;
+    }
+
+    size_t valid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (batch_item_size(&items[i]) == 0) {
+            set_status(statuses, i, BUFFER_ENQUEUE_INVALID);
+            continue;
+        }
+        set_status(statuses, i, BUFFER_ENQUEUE_OK);
+        valid++;
+    }
+
+    size_t granted = spill_pending(engine) ? 0 : reserve_new_slots(engine, valid);
+    size_t rejected = count - valid;
+    size_t bytes = 0;
+    int64_t now_ms = log_entry_now_ms();
+
+    LinkedList built;
+    LinkedList overflow;
+    linked_list_init(&built);
+    linked_list_init(&overflow);
+
+    for (size_t i = 0; i < count; ++i) {
+        const BufferLogInput *item = &items[i];
+        size_t entry_size = batch_item_size(item);
+        if (entry_size == 0) {
+            continue;
+        }
+
+        if (linked_list_size(&built) >= granted) {
+            /* A full lane rejects overflow too; spilled entries do not hold their lane slot. */
+            uint8_t lane = lane_for_level(engine, item->level);
+            if (!reserve_lane_slot(engine, lane)) {
+                set_status(statuses, i, BUFFER_ENQUEUE_FULL);
+                rejected++;
+                continue;
+            }
+            release_lane_slots(engine, lane, 1);
+
+            /* Spilled after the in-memory part is published; the ID holds the item index until then. */
+            LogEntry *spilled = engine->spill != NULL ? log_entry_create(i, item->level, item->source, item->message, now_ms)
+                                                      : NULL;
+            if (spilled != NULL) {
+                linked_list_push_back(&overflow, spilled);
+                continue;
+            }
+            set_status(statuses, i, BUFFER_ENQUEUE_FULL);
+            rejected++;
+            continue;
+        }
+
+        /* Slots refused by a lane or the allocator are given back, not passed on. */
+        uint8_t lane = lane_for_level(engine, item->level);
+        if (!reserve_lane_slot(engine, lane)) {
+            set_status(statuses, i, BUFFER_ENQUEUE_FULL);
+            granted--;
+            atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+            rejected++;
+            continue;
+        }
+
+        LogEntry *entry = allocate_entry(engine, entry_size);
+        if (entry == NULL) {
+            set_status(statuses, i, BUFFER_ENQUEUE_NO_MEMORY);
+            release_lane_slots(engine, lane, 1);
+            granted--;
+            atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+            rejected++;
+            continue;
+        }
+
+        log_entry_init(entry, entry_size, 0, item->level, item->source, item->message, now_ms);
+        entry->lane = lane;
+        linked_list_push_back(&built, entry);
+        bytes += entry_size;
+    }
+
+    if (engine->journal != NULL && built.size > 0 &&
+        !journal_append_batch(engine->journal, &built, NULL, 0)) {
+        LogEntry *entry = NULL;
+        size_t index = 0;
+        while ((entry = linked_list_pop_front(&built)) != NULL) {
+            while (statuses != NULL && statuses[index] != BUFFER_ENQUEUE_OK) {
+                index++;
+            }
+            set_status(statuses, index++, BUFFER_ENQUEUE_JOURNAL_ERROR);
+            release_lane_slots(engine, entry->lane, 1);
+            free_entry(engine, entry);
+            atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
+            rejected++;
+        }
+        bytes = 0;
+    }
+
+    size_t accepted = linked_list_size(&built);
+
+    if (accepted > 0 && engine->ingest_mode == BUFFER_INGEST_LOCKFREE) {
+        uint64_t id = atomic_fetch_add_explicit(&engine->next_log_id, accepted, memory_order_relaxed);
+        atomic_fetch_add_explicit(&engine->memory_bytes, bytes, memory_order_relaxed);
+        count_ingested(engine, accepted);
+
+        /* The reservation above guarantees inbox room; the failure branch is defensive. */
+        LogEntry *entry = NULL;
+        while ((entry = linked_list_pop_front(&built)) != NULL) {
+            entry->id = id++;
+            if (!mpmc_queue_push(&engine->inbox, entry)) {
+                uncount_ingested(engine, 1);
+                account_removed(engine, entry);
+                journal_release(engine->journal, entry);
+                free_entry(engine, entry);
+                accepted--;
+                rejected++;
+            }
+        }
+    } else if (accepted > 0) {
+        pthread_mutex_lock(&engine->mutex);
+        uint64_t id = atomic_load_explicit(&engine->next_log_id, memory_order_relaxed);
+        for (LogEntry *cursor = built.head; cursor != NULL; cursor = cursor->next) {
+            cursor->id = id++;
+        }
+        atomic_store_explicit(&engine->next_log_id, id, memory_order_relaxed);
+        atomic_fetch_add_explicit(&engine->memory_bytes, bytes, memory_order_relaxed);
+        count_ingested(engine, accepted);
+
+        queue_append_batch(engine, &built);
+        pthread_mutex_unlock(&engine->mutex);
+    }
+
+    if (overflow.size > 0) {
+        size_t overflow_count = overflow.size;
+        count_ingested(engine, overflow_count);
+        size_t spilled = spill_batch(engine, &overflow, statuses, &rejected);
+        uncount_ingested(engine, overflow_count - spilled);
+        accepted += spilled;
+    }
+
+    if (rejected > 0) {
+        atomic_fetch_add_explicit(&engine->total_errors, rejected, memory_order_relaxed);
+        write_error(error, error_size, accepted > 0 ? "Some log entries were rejected." : "No log entries were accepted.");
+    }
+
+    return accepted;
+}
+
+/* Enqueue latency is the caller's view: one sample per accepted call, batches included. */
+int buffer_engine_enqueue(BufferEngine *engine,
+                          const char *level,
+                          const char *source,
+                          const char *message,
+                          char *error,
+                          size_t error_size) {
+    uint64_t started_us = monotonic_us();
+    int ok = enqueue_one(engine, level, source, message, error, error_size);
+    if (ok) {
+        buffer_engine_record_latency(engine, ENGINE_LATENCY_ENQUEUE, monotonic_us() - started_us, 1);
+    }
+    return ok;
+}
+
+size_t buffer_engine_enqueue_batch(BufferEngine *engine,
+                                   const BufferLogInput *items,
+                                   size_t count,
+                                   int *statuses,
+                                   char *error,
+                                   size_t error_size) {
+    uint64_t started_us = monotonic_us();
+    size_t accepted = enqueue_many(engine, items, count, statuses, error, error_size);
+    if (accepted > 0) {
+        buffer_engine_record_latency(engine, ENGINE_LATENCY_ENQUEUE, monotonic_us() - started_us, 1);
+    }
+    return accepted;
+}
+
 int buffer_engine_requeue_front(BufferEngine *engine, LogEntry *entry, char *error, size_t error_size) {
     if (engine == NULL || !engine->initialized || entry == NULL) {
         write_error(error, error_size, "Invalid requeue request.");
@@ -136,65 +1252,307 @@ int buffer_engine_requeue_front(BufferEngine *engine, LogEntry *entry, char *err
 
     pthread_mutex_lock(&engine->mutex);
 
-    if (engine->metrics.queue_depth >= engine->capacity) {
+    if (!reserve_slot(engine)) {
         pthread_mutex_unlock(&engine->mutex);
+        if (engine->spill != NULL && spill_queue_push(engine->spill, entry, NULL, 0)) {
+            free_entry(engine, entry);
+            note_in_flight_done(engine, 1);
+            return 1;
+        }
         write_error(error, error_size, "Cannot requeue: capacity reached.");
         return 0;
     }
 
-    if (!linked_list_push_front(&engine->queue, entry)) {
+    if (!queue_push_front(engine, entry)) {
+        atomic_fetch_sub_explicit(&engine->depth, 1, memory_order_acq_rel);
         pthread_mutex_unlock(&engine->mutex);
         write_error(error, error_size, "Cannot requeue: push_front failed.");
         return 0;
     }
 
-    engine->metrics.queue_depth = linked_list_size(&engine->queue);
-    engine->metrics.memory_bytes_estimate = estimate_memory_bytes(engine->metrics.queue_depth);
+    atomic_fetch_add_explicit(&engine->lanes[entry->lane].depth, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&engine->memory_bytes, log_entry_size(entry), memory_order_relaxed);
+    note_in_flight_done(engine, 1);
     pthread_mutex_unlock(&engine->mutex);
 
     return 1;
 }
 
-int buffer_engine_dequeue(BufferEngine *engine, LogEntry **entry_out) {
-    if (engine == NULL || !engine->initialized || entry_out == NULL) {
+int buffer_engine_requeue_front_batch(BufferEngine *engine, LinkedList *entries, char *error, size_t error_size) {
+    if (engine == NULL || !engine->initialized || entries == NULL) {
+        write_error(error, error_size, "Invalid requeue request.");
         return 0;
     }
 
+    if (entries->size == 0) {
+        return 1;
+    }
+
+    LinkedList fitting;
+    linked_list_init(&fitting);
+
     pthread_mutex_lock(&engine->mutex);
-    LogEntry *entry = linked_list_pop_front(&engine->queue);
-    engine->metrics.queue_depth = linked_list_size(&engine->queue);
-    engine->metrics.memory_bytes_estimate = estimate_memory_bytes(engine->metrics.queue_depth);
+    size_t granted = reserve_slots(engine, entries->size);
+    linked_list_pop_front_batch(entries, granted, &fitting);
+    for (const LogEntry *cursor = fitting.head; cursor != NULL; cursor = cursor->next) {
+        atomic_fetch_add_explicit(&engine->lanes[cursor->lane].depth, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&engine->memory_bytes, list_bytes(fitting.head), memory_order_relaxed);
+    note_in_flight_done(engine, granted);
+    queue_prepend_batch(engine, &fitting);
     pthread_mutex_unlock(&engine->mutex);
 
-    if (entry == NULL) {
+    /* Whatever no longer fits in memory goes behind the spilled backlog rather than being lost. */
+    size_t spilled = 0;
+    LogEntry *entry = NULL;
+    while (engine->spill != NULL && (entry = entries->head) != NULL &&
+           spill_queue_push(engine->spill, entry, NULL, 0)) {
+        free_entry(engine, linked_list_pop_front(entries));
+        spilled++;
+    }
+    note_in_flight_done(engine, spilled);
+
+    if (entries->size > 0) {
+        write_error(error, error_size, "Cannot requeue: capacity reached.");
         return 0;
     }
 
-    *entry_out = entry;
     return 1;
 }
 
-int buffer_engine_get_metrics(BufferEngine *engine, EngineMetrics *out_metrics) {
-    if (engine == NULL || !engine->initialized || out_metrics == NULL) {
+/* Goes through the lane schedule like a batch of one, so it also sees inbox entries for higher lanes. */
+int buffer_engine_dequeue(BufferEngine *engine, LogEntry **entry_out) {
+    if (entry_out == NULL) {
+        return 0;
+    }
+
+    LinkedList popped;
+    linked_list_init(&popped);
+    if (buffer_engine_dequeue_batch(engine, 1, &popped) == 0) {
+        return 0;
+    }
+
+    *entry_out = linked_list_pop_front(&popped);
+    return 1;
+}
+
+size_t buffer_engine_dequeue_batch(BufferEngine *engine, size_t max_items, LinkedList *out_list) {
+    if (engine == NULL || !engine->initialized || out_list == NULL || max_items == 0) {
         return 0;
     }
 
+    LogEntry *previous_tail = out_list->tail;
+
     pthread_mutex_lock(&engine->mutex);
-    *out_metrics = engine->metrics;
+    drain_inbox_locked(engine);
+    refill_from_spill_locked(engine);
+    size_t count = lanes_pop_batch_locked(engine, max_items, out_list);
+    if (count > 0) {
+        atomic_fetch_add_explicit(&engine->in_flight, count, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&engine->depth, count, memory_order_acq_rel);
+    }
     pthread_mutex_unlock(&engine->mutex);
-    return 1;
+
+    if (count > 0) {
+        size_t bytes = list_bytes(previous_tail != NULL ? previous_tail->next : out_list->head);
+        atomic_fetch_sub_explicit(&engine->memory_bytes, bytes, memory_order_relaxed);
+    }
+
+    return count;
 }
 
-void buffer_engine_mark_processed(BufferEngine *engine, double processing_ms) {
+void buffer_engine_release_entry(BufferEngine *engine, LogEntry *entry) {
+    if (engine == NULL || entry == NULL) {
+        return;
+    }
+
+    journal_release(engine->journal, entry);
+    free_entry(engine, entry);
+    note_in_flight_done(engine, 1);
+}
+
+void buffer_engine_release_batch(BufferEngine *engine, LinkedList *entries) {
+    if (engine == NULL || entries == NULL) {
+        return;
+    }
+
+    size_t released = 0;
+    LogEntry *entry = NULL;
+    while ((entry = linked_list_pop_front(entries)) != NULL) {
+        journal_release(engine->journal, entry);
+        free_entry(engine, entry);
+        released++;
+    }
+    note_in_flight_done(engine, released);
+}
+
+void buffer_engine_drop_batch(BufferEngine *engine, LinkedList *entries) {
+    if (engine == NULL || entries == NULL) {
+        return;
+    }
+
+    size_t dropped = 0;
+    LogEntry *entry = NULL;
+    while ((entry = linked_list_pop_front(entries)) != NULL) {
+        free_entry(engine, entry);
+        dropped++;
+    }
+    note_in_flight_done(engine, dropped);
+    atomic_fetch_add_explicit(&engine->total_dropped, dropped, memory_order_release);
+}
+
+void buffer_engine_detach_batch(BufferEngine *engine, const LinkedList *entries) {
+    if (engine == NULL || entries == NULL) {
+        return;
+    }
+
+    note_in_flight_done(engine, linked_list_size(entries));
+}
+
+void buffer_engine_reattach_batch(BufferEngine *engine, const LinkedList *entries) {
+    if (engine == NULL || entries == NULL) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&engine->in_flight, linked_list_size(entries), memory_order_relaxed);
+}
+
+/*
+ * Journals every later enqueue; entries released from then on truncate it.
+ * Attach after replay and before producers start.
+ */
+void buffer_engine_attach_journal(BufferEngine *engine, Journal *journal) {
+    if (engine == NULL || !engine->initialized) {
+        return;
+    }
+
+    engine->journal = journal;
+}
+
+/* Entries that find the queue full (or anything already spilled) go to `spill` from now on. */
+void buffer_engine_attach_spill(BufferEngine *engine, SpillQueue *spill) {
     if (engine == NULL || !engine->initialized) {
         return;
     }
 
+    engine->spill = spill;
+}
+
+size_t buffer_engine_queue_depth(BufferEngine *engine) {
+    if (engine == NULL || !engine->initialized) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&engine->depth, memory_order_acquire) + spill_queue_size(engine->spill);
+}
+
+int64_t buffer_engine_oldest_ingested_at_ms(BufferEngine *engine) {
+    if (engine == NULL || !engine->initialized || atomic_load_explicit(&engine->depth, memory_order_acquire) == 0) {
+        return 0;
+    }
+
+    /* Requeued entries go back to the head, so each lane's head is its oldest entry. */
+    int64_t ingested_at_ms = 0;
     pthread_mutex_lock(&engine->mutex);
-    engine->metrics.total_processed++;
-    engine->metrics.last_processing_ms = processing_ms;
-    engine->metrics.last_processed_at_ms = log_entry_now_ms();
+    drain_inbox_locked(engine);
+    for (size_t lane = 0; lane < engine->lane_count; ++lane) {
+        const LogEntry *head = queue_peek_next(engine, lane, NULL, 0);
+        if (head != NULL && (ingested_at_ms == 0 || head->ingested_at_ms < ingested_at_ms)) {
+            ingested_at_ms = head->ingested_at_ms;
+        }
+    }
     pthread_mutex_unlock(&engine->mutex);
+
+    return ingested_at_ms;
+}
+
+int buffer_engine_get_metrics(BufferEngine *engine, EngineMetrics *out_metrics) {
+    if (engine == NULL || !engine->initialized || out_metrics == NULL) {
+        return 0;
+    }
+
+    memset(out_metrics, 0, sizeof(*out_metrics));
+    out_metrics->buffer_capacity = engine->capacity;
+    out_metrics->started_at_ms = engine->started_at_ms;
+    out_metrics->arena_slots_total = engine->arena.slot_count;
+
+    /*
+     * Outcomes are read (acquire) before ingest: an entry is counted as
+     * ingested before it can be dequeued and outcomes are release updates,
+     * so a snapshot never shows more processed or dead-lettered entries than
+     * this process ingested (restored and replayed entries aside).
+     */
+    out_metrics->total_processed = atomic_load_explicit(&engine->total_processed, memory_order_acquire);
+    out_metrics->total_dead_lettered = atomic_load_explicit(&engine->total_dead_lettered, memory_order_acquire);
+    out_metrics->total_dropped = atomic_load_explicit(&engine->total_dropped, memory_order_acquire);
+    out_metrics->last_processing_ms = atomic_load_explicit(&engine->last_processing_ms, memory_order_relaxed);
+    out_metrics->last_processed_at_ms = atomic_load_explicit(&engine->last_processed_at_ms, memory_order_relaxed);
+    out_metrics->total_ingested = atomic_load_explicit(&engine->total_ingested, memory_order_acquire);
+    out_metrics->total_errors = atomic_load_explicit(&engine->total_errors, memory_order_relaxed);
+    out_metrics->queue_depth = atomic_load_explicit(&engine->depth, memory_order_acquire);
+    out_metrics->memory_bytes_estimate = atomic_load_explicit(&engine->memory_bytes, memory_order_relaxed);
+    out_metrics->arena_slots_in_use = entry_arena_in_use(&engine->arena);
+    out_metrics->arena_high_water = entry_arena_high_water(&engine->arena);
+    out_metrics->arena_fallback_allocs = atomic_load_explicit(&engine->arena_fallback_allocs, memory_order_relaxed);
+
+    SpillStats spill_stats;
+    spill_queue_get_stats(engine->spill, &spill_stats);
+    out_metrics->spilled_entries = spill_stats.entries;
+    out_metrics->spilled_bytes = spill_stats.bytes;
+    out_metrics->spill_segments = spill_stats.segments;
+    out_metrics->spilled_total = spill_stats.spilled_total;
+    out_metrics->paged_in_total = spill_stats.paged_in_total;
+
+    out_metrics->latency_window_started_at_ms =
+        atomic_load_explicit(&engine->latency_window_started_at_ms, memory_order_relaxed);
+    for (size_t kind = 0; kind < ENGINE_LATENCY_KIND_COUNT; ++kind) {
+        latency_histogram_summarize(&engine->latency[kind], &out_metrics->latency[kind]);
+    }
+
+    out_metrics->lane_count = engine->lane_count;
+    for (size_t i = 0; i < engine->lane_count; ++i) {
+        const BufferLane *lane = &engine->lanes[i];
+        LaneMetrics *lane_metrics = &out_metrics->lanes[i];
+        memcpy(lane_metrics->name, lane->options.name, sizeof(lane_metrics->name));
+        lane_metrics->depth = atomic_load_explicit(&lane->depth, memory_order_relaxed);
+        lane_metrics->capacity = lane->options.capacity;
+        lane_metrics->weight = lane->options.weight;
+        lane_metrics->rejected = atomic_load_explicit(&lane->rejected, memory_order_relaxed);
+    }
+    return 1;
+}
+
+void buffer_engine_mark_processed(BufferEngine *engine, double processing_ms) {
+    buffer_engine_mark_processed_batch(engine, 1, processing_ms);
+}
+
+void buffer_engine_mark_processed_batch(BufferEngine *engine, size_t count, double last_processing_ms) {
+    if (engine == NULL || !engine->initialized || count == 0) {
+        return;
+    }
+
+    atomic_store_explicit(&engine->last_processing_ms, last_processing_ms, memory_order_relaxed);
+    atomic_store_explicit(&engine->last_processed_at_ms, log_entry_now_ms(), memory_order_relaxed);
+    atomic_fetch_add_explicit(&engine->total_processed, count, memory_order_release);
+}
+
+void buffer_engine_record_latency(BufferEngine *engine, EngineLatencyKind kind, uint64_t micros, uint64_t count) {
+    if (engine == NULL || !engine->initialized || kind >= ENGINE_LATENCY_KIND_COUNT) {
+        return;
+    }
+
+    latency_histogram_record(&engine->latency[kind], micros, count);
+}
+
+void buffer_engine_reset_latency_window(BufferEngine *engine) {
+    if (engine == NULL || !engine->initialized) {
+        return;
+    }
+
+    for (size_t kind = 0; kind < ENGINE_LATENCY_KIND_COUNT; ++kind) {
+        latency_histogram_reset_window(&engine->latency[kind]);
+    }
+    atomic_store_explicit(&engine->latency_window_started_at_ms, log_entry_now_ms(), memory_order_relaxed);
 }
 
 void buffer_engine_mark_error(BufferEngine *engine) {
@@ -202,9 +1560,15 @@ void buffer_engine_mark_error(BufferEngine *engine) {
         return;
     }
 
-    pthread_mutex_lock(&engine->mutex);
-    engine->metrics.total_errors++;
-    pthread_mutex_unlock(&engine->mutex);
+    count_error(engine);
+}
+
+void buffer_engine_mark_dead_lettered(BufferEngine *engine) {
+    if (engine == NULL || !engine->initialized) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&engine->total_dead_lettered, 1, memory_order_release);
 }
 
 static int append_raw(char *buffer, size_t buffer_size, size_t *offset, const char *text) {
@@ -280,13 +1644,14 @@ int buffer_engine_pending_json(BufferEngine *engine,
     }
 
     pthread_mutex_lock(&engine->mutex);
+    drain_inbox_locked(engine);
 
     size_t offset = 0;
     char header[128] = {0};
     snprintf(header,
              sizeof(header),
              "{\"queue_depth\":%zu,\"items\":[",
-             engine->metrics.queue_depth);
+             atomic_load_explicit(&engine->depth, memory_order_acquire));
 
     if (!append_raw(buffer, buffer_size, &offset, header)) {
         pthread_mutex_unlock(&engine->mutex);
@@ -294,46 +1659,51 @@ int buffer_engine_pending_json(BufferEngine *engine,
         return 0;
     }
 
+    /* Lanes are listed in priority order, each oldest first. */
     size_t emitted = 0;
-    LinkedListNode *node = engine->queue.head;
-    while (node != NULL && emitted < max_items) {
-        if (emitted > 0 && !append_raw(buffer, buffer_size, &offset, ",")) {
-            pthread_mutex_unlock(&engine->mutex);
-            snprintf(buffer, buffer_size, "{\"error\":\"response buffer too small\"}");
-            return 0;
-        }
+    for (size_t lane = 0; lane < engine->lane_count && emitted < max_items; ++lane) {
+        size_t position = 0;
+        const LogEntry *cursor = queue_peek_next(engine, lane, NULL, 0);
+        while (cursor != NULL && emitted < max_items) {
+            if (emitted > 0 && !append_raw(buffer, buffer_size, &offset, ",")) {
+                pthread_mutex_unlock(&engine->mutex);
+                snprintf(buffer, buffer_size, "{\"error\":\"response buffer too small\"}");
+                return 0;
+            }
 
-        char prefix[128] = {0};
-        snprintf(prefix,
-                 sizeof(prefix),
-                 "{\"id\":%llu,\"level\":",
-                 (unsigned long long)node->entry->id);
-
-        if (!append_raw(buffer, buffer_size, &offset, prefix) ||
-            !append_escaped(buffer, buffer_size, &offset, node->entry->level) ||
-            !append_raw(buffer, buffer_size, &offset, ",\"source\":") ||
-            !append_escaped(buffer, buffer_size, &offset, node->entry->source) ||
-            !append_raw(buffer, buffer_size, &offset, ",\"message\":") ||
-            !append_escaped(buffer, buffer_size, &offset, node->entry->message)) {
-            pthread_mutex_unlock(&engine->mutex);
-            snprintf(buffer, buffer_size, "{\"error\":\"response buffer too small\"}");
-            return 0;
-        }
+            char prefix[128] = {0};
+            snprintf(prefix,
+                     sizeof(prefix),
+                     "{\"id\":%llu,\"level\":",
+                     (unsigned long long)cursor->id);
 
-        char suffix[128] = {0};
-        snprintf(suffix,
-                 sizeof(suffix),
-                 ",\"ingested_at_ms\":%lld}",
-                 (long long)node->entry->ingested_at_ms);
+            if (!append_raw(buffer, buffer_size, &offset, prefix) ||
+                !append_escaped(buffer, buffer_size, &offset, log_entry_level(cursor)) ||
+                !append_raw(buffer, buffer_size, &offset, ",\"source\":") ||
+                !append_escaped(buffer, buffer_size, &offset, log_entry_source(cursor)) ||
+                !append_raw(buffer, buffer_size, &offset, ",\"message\":") ||
+                !append_escaped(buffer, buffer_size, &offset, log_entry_message(cursor))) {
+                pthread_mutex_unlock(&engine->mutex);
+                snprintf(buffer, buffer_size, "{\"error\":\"response buffer too small\"}");
+                return 0;
+            }
 
-        if (!append_raw(buffer, buffer_size, &offset, suffix)) {
-            pthread_mutex_unlock(&engine->mutex);
-            snprintf(buffer, buffer_size, "{\"error\":\"response buffer too small\"}");
-            return 0;
-        }
+            char suffix[128] = {0};
+            snprintf(suffix,
+                     sizeof(suffix),
+                     ",\"ingested_at_ms\":%lld}",
+                     (long long)cursor->ingested_at_ms);
+
+            if (!append_raw(buffer, buffer_size, &offset, suffix)) {
+                pthread_mutex_unlock(&engine->mutex);
+                snprintf(buffer, buffer_size, "{\"error\":\"response buffer too small\"}");
+                return 0;
+            }
 
-        emitted++;
-        node = node->next;
+            emitted++;
+            position++;
+            cursor = queue_peek_next(engine, lane, cursor, position);
+        }
     }
 
     char footer[128] = {0};
@@ -0,0 +1,217 @@
+#include "entry_arena.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define ENTRY_ARENA_HUGE_PAGE_BYTES ((size_t)2 * 1024 * 1024)
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static size_t round_up(size_t value, size_t multiple) {
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+EntryArenaPageMode entry_arena_page_mode_from_string(const char *text) {
+    if (text == NULL) {
+        return ENTRY_ARENA_PAGES_DEFAULT;
+    }
+
+    if (strcmp(text, "transparent") == 0) {
+        return ENTRY_ARENA_PAGES_TRANSPARENT;
+    }
+    if (strcmp(text, "explicit") == 0) {
+        return ENTRY_ARENA_PAGES_EXPLICIT;
+    }
+
+    return ENTRY_ARENA_PAGES_DEFAULT;
+}
+
+const char *entry_arena_page_mode_to_string(EntryArenaPageMode mode) {
+    switch (mode) {
+        case ENTRY_ARENA_PAGES_TRANSPARENT:
+            return "transparent";
+        case ENTRY_ARENA_PAGES_EXPLICIT:
+            return "explicit";
+        case ENTRY_ARENA_PAGES_DEFAULT:
+        default:
+            return "default";
+    }
+}
+
+static void *map_region(size_t bytes, EntryArenaPageMode *page_mode, int prefault) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_POPULATE)
+    if (prefault) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
+#if defined(MAP_HUGETLB)
+    if (*page_mode == ENTRY_ARENA_PAGES_EXPLICIT) {
+        void *region = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        if (region != MAP_FAILED) {
+            return region;
+        }
+    }
+#endif
+
+    /* Explicit huge pages unavailable: degrade to transparent huge pages. */
+    if (*page_mode == ENTRY_ARENA_PAGES_EXPLICIT) {
+        *page_mode = ENTRY_ARENA_PAGES_TRANSPARENT;
+    }
+
+    void *region = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (region == MAP_FAILED) {
+        return NULL;
+    }
+
+#if defined(MADV_HUGEPAGE)
+    if (*page_mode == ENTRY_ARENA_PAGES_TRANSPARENT && madvise(region, bytes, MADV_HUGEPAGE) != 0) {
+        *page_mode = ENTRY_ARENA_PAGES_DEFAULT;
+    }
+#else
+    *page_mode = ENTRY_ARENA_PAGES_DEFAULT;
+#endif
+
+    return region;
+}
+
+int entry_arena_init(EntryArena *arena,
+                     size_t slot_count,
+                     size_t slot_size,
+                     EntryArenaPageMode page_mode,
+                     int prefault,
+                     char *error,
+                     size_t error_size) {
+    if (arena == NULL || slot_count == 0 || slot_size < sizeof(LogEntry)) {
+        write_error(error, error_size, "Invalid entry arena arguments.");
+        return 0;
+    }
+
+    memset(arena, 0, sizeof(*arena));
+
+    slot_size = round_up(slot_size, _Alignof(LogEntry));
+    if (slot_count > ((size_t)-1) / slot_size) {
+        write_error(error, error_size, "Entry arena size overflows.");
+        return 0;
+    }
+
+    size_t page_bytes = (size_t)sysconf(_SC_PAGESIZE);
+    if (page_mode != ENTRY_ARENA_PAGES_DEFAULT) {
+        page_bytes = ENTRY_ARENA_HUGE_PAGE_BYTES;
+    }
+
+    size_t mapped_bytes = round_up(slot_count * slot_size, page_bytes);
+    unsigned char *base = (unsigned char *)map_region(mapped_bytes, &page_mode, prefault);
+    if (base == NULL) {
+        write_error(error, error_size, "Unable to reserve entry arena memory.");
+        return 0;
+    }
+
+#if !defined(MAP_POPULATE)
+    if (prefault) {
+        size_t system_page = (size_t)sysconf(_SC_PAGESIZE);
+        for (size_t offset = 0; offset < mapped_bytes; offset += system_page) {
+            base[offset] = 0;
+        }
+    }
+#endif
+
+    if (!mpmc_queue_init(&arena->free_slots, slot_count)) {
+        munmap(base, mapped_bytes);
+        write_error(error, error_size, "Unable to allocate entry arena free list.");
+        return 0;
+    }
+
+    /* Queue slots in address order so a fresh arena hands them out sequentially. */
+    for (size_t i = 0; i < slot_count; ++i) {
+        mpmc_queue_push(&arena->free_slots, base + (i * slot_size));
+    }
+
+    arena->base = base;
+    arena->mapped_bytes = mapped_bytes;
+    arena->slot_size = slot_size;
+    arena->slot_count = slot_count;
+    atomic_init(&arena->in_use, 0);
+    atomic_init(&arena->high_water, 0);
+    arena->page_mode = page_mode;
+    arena->initialized = 1;
+    return 1;
+}
+
+LogEntry *entry_arena_alloc(EntryArena *arena, size_t entry_size) {
+    if (arena == NULL || !arena->initialized || entry_size > arena->slot_size) {
+        return NULL;
+    }
+
+    LogEntry *slot = (LogEntry *)mpmc_queue_pop(&arena->free_slots);
+    if (slot == NULL) {
+        return NULL;
+    }
+
+    size_t in_use = atomic_fetch_add_explicit(&arena->in_use, 1, memory_order_relaxed) + 1;
+    size_t high_water = atomic_load_explicit(&arena->high_water, memory_order_relaxed);
+    while (in_use > high_water &&
+           !atomic_compare_exchange_weak_explicit(&arena->high_water,
+                                                  &high_water,
+                                                  in_use,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+
+    return slot;
+}
+
+int entry_arena_owns(const EntryArena *arena, const LogEntry *entry) {
+    if (arena == NULL || !arena->initialized || entry == NULL) {
+        return 0;
+    }
+
+    const unsigned char *address = (const unsigned char *)entry;
+    return address >= arena->base && address < arena->base + (arena->slot_count * arena->slot_size);
+}
+
+void entry_arena_release(EntryArena *arena, LogEntry *entry) {
+    if (!entry_arena_owns(arena, entry)) {
+        return;
+    }
+
+    atomic_fetch_sub_explicit(&arena->in_use, 1, memory_order_relaxed);
+    mpmc_queue_push(&arena->free_slots, entry);
+}
+
+size_t entry_arena_in_use(const EntryArena *arena) {
+    if (arena == NULL || !arena->initialized) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&arena->in_use, memory_order_relaxed);
+}
+
+size_t entry_arena_high_water(const EntryArena *arena) {
+    if (arena == NULL || !arena->initialized) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&arena->high_water, memory_order_relaxed);
+}
+
+void entry_arena_destroy(EntryArena *arena) {
+    if (arena == NULL || !arena->initialized) {
+        return;
+    }
+
+    mpmc_queue_destroy(&arena->free_slots);
+    munmap(arena->base, arena->mapped_bytes);
+    memset(arena, 0, sizeof(*arena));
+}
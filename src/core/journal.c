@@ -0,0 +1,687 @@
+#include "journal.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define JOURNAL_FRAME_HEADER_SIZE 8
+#define JOURNAL_INITIAL_PENDING 65536
+#define JOURNAL_SEGMENT_PREFIX "segment-"
+#define JOURNAL_SEGMENT_SUFFIX ".log"
+
+/* Appends only grow the file, so the data (not the inode times) is what must be durable. */
+#if defined(__linux__)
+#define journal_sync_fd fdatasync
+#else
+#define journal_sync_fd fsync
+#endif
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL);
+}
+
+static uint32_t fnv1a32(const unsigned char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void put_u32(unsigned char *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void segment_path(const Journal *journal, uint32_t seq, char *path, size_t path_size) {
+    snprintf(path, path_size, "%s/" JOURNAL_SEGMENT_PREFIX "%010u" JOURNAL_SEGMENT_SUFFIX, journal->dir, seq);
+}
+
+static int parse_segment_name(const char *name, uint32_t *seq_out) {
+    size_t prefix_len = strlen(JOURNAL_SEGMENT_PREFIX);
+    size_t suffix_len = strlen(JOURNAL_SEGMENT_SUFFIX);
+    size_t len = strlen(name);
+    if (len <= prefix_len + suffix_len || strncmp(name, JOURNAL_SEGMENT_PREFIX, prefix_len) != 0 ||
+        strcmp(name + len - suffix_len, JOURNAL_SEGMENT_SUFFIX) != 0) {
+        return 0;
+    }
+
+    uint32_t seq = 0;
+    for (size_t i = prefix_len; i < len - suffix_len; ++i) {
+        if (name[i] < '0' || name[i] > '9') {
+            return 0;
+        }
+        seq = (seq * 10u) + (uint32_t)(name[i] - '0');
+    }
+
+    *seq_out = seq;
+    return seq > 0;
+}
+
+static JournalSegment *find_segment(Journal *journal, uint32_t seq) {
+    for (size_t i = 0; i < journal->segment_count; ++i) {
+        if (journal->segments[i].seq == seq) {
+            return &journal->segments[i];
+        }
+    }
+    return NULL;
+}
+
+static int add_segment(Journal *journal, uint32_t seq, size_t bytes) {
+    if (journal->segment_count == journal->segment_capacity) {
+        size_t capacity = journal->segment_capacity == 0 ? 8 : journal->segment_capacity * 2;
+        JournalSegment *grown = (JournalSegment *)realloc(journal->segments, capacity * sizeof(JournalSegment));
+        if (grown == NULL) {
+            return 0;
+        }
+        journal->segments = grown;
+        journal->segment_capacity = capacity;
+    }
+
+    JournalSegment *segment = &journal->segments[journal->segment_count++];
+    segment->seq = seq;
+    segment->outstanding = 0;
+    segment->bytes = bytes;
+    return 1;
+}
+
+static int compare_segments(const void *left, const void *right) {
+    uint32_t a = ((const JournalSegment *)left)->seq;
+    uint32_t b = ((const JournalSegment *)right)->seq;
+    return (a > b) - (a < b);
+}
+
+/* Drops a sealed segment from the table; the caller unlinks the file outside the mutex. */
+static int retire_segment_locked(Journal *journal, uint32_t seq) {
+    if (seq == journal->active_seq) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < journal->segment_count; ++i) {
+        if (journal->segments[i].seq == seq && journal->segments[i].outstanding == 0) {
+            memmove(&journal->segments[i],
+                    &journal->segments[i + 1],
+                    (journal->segment_count - i - 1) * sizeof(JournalSegment));
+            journal->segment_count--;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void unlink_segment(Journal *journal, uint32_t seq) {
+    char path[320];
+    segment_path(journal, seq, path, sizeof(path));
+    if (unlink(path) != 0 && errno != ENOENT) {
+        logger_log(journal->logger, LOGGER_ERROR, "journal", "failed to remove %s: %s", path, strerror(errno));
+    }
+}
+
+static int open_active_segment(Journal *journal, uint32_t seq) {
+    char path[320];
+    segment_path(journal, seq, path, sizeof(path));
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+
+    if (!add_segment(journal, seq, 0)) {
+        close(fd);
+        unlink(path);
+        return 0;
+    }
+
+    journal->fd = fd;
+    journal->active_seq = seq;
+    journal->active_bytes = 0;
+    return 1;
+}
+
+static int write_all(int fd, const unsigned char *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return 1;
+}
+
+/*
+ * Group-commit leader: takes everything buffered so far, writes and syncs it
+ * without holding the mutex, then wakes the appenders it covered. Called and
+ * returns with the mutex held.
+ */
+static void flush_locked(Journal *journal) {
+    unsigned char *data = journal->pending;
+    size_t capacity = journal->pending_capacity;
+    size_t size = journal->pending_len;
+    uint64_t ticket = journal->appended_ticket;
+
+    /* Appenders keep buffering into the spare while the leader owns `data`. */
+    journal->pending = journal->spare;
+    journal->pending_capacity = journal->spare_capacity;
+    journal->pending_len = 0;
+    journal->spare = NULL;
+    journal->spare_capacity = 0;
+    journal->flushing = 1;
+    int fd = journal->fd;
+    pthread_mutex_unlock(&journal->mutex);
+
+    int ok = write_all(fd, data, size);
+    if (ok && journal->fsync_enabled) {
+        ok = journal_sync_fd(fd) == 0;
+    }
+
+    pthread_mutex_lock(&journal->mutex);
+    journal->spare = data;
+    journal->spare_capacity = capacity;
+    journal->flushing = 0;
+    if (ok) {
+        journal->durable_ticket = ticket;
+        atomic_fetch_add_explicit(&journal->syncs, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&journal->bytes_written, size, memory_order_relaxed);
+    } else if (!journal->failed) {
+        journal->failed = 1;
+        logger_log(journal->logger, LOGGER_ERROR, "journal", "journal write failed: %s", strerror(errno));
+    }
+    pthread_cond_broadcast(&journal->flushed);
+}
+
+/* Flushes the active segment, then seals it and opens the next one. Mutex held. */
+static int rotate_locked(Journal *journal) {
+    while (journal->flushing || journal->pending_len > 0) {
+        if (journal->flushing) {
+            pthread_cond_wait(&journal->flushed, &journal->mutex);
+        } else {
+            flush_locked(journal);
+        }
+        if (journal->failed) {
+            return 0;
+        }
+    }
+
+    uint32_t sealed = journal->active_seq;
+    close(journal->fd);
+    journal->fd = -1;
+    if (!open_active_segment(journal, sealed + 1)) {
+        journal->failed = 1;
+        logger_log(journal->logger, LOGGER_ERROR, "journal", "unable to open segment %u", sealed + 1);
+        return 0;
+    }
+
+    if (retire_segment_locked(journal, sealed)) {
+        unlink_segment(journal, sealed);
+    }
+    return 1;
+}
+
+static int reserve_pending(Journal *journal, size_t extra) {
+    size_t needed = journal->pending_len + extra;
+    if (needed <= journal->pending_capacity) {
+        return 1;
+    }
+
+    size_t capacity = journal->pending_capacity == 0 ? JOURNAL_INITIAL_PENDING : journal->pending_capacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    unsigned char *grown = (unsigned char *)realloc(journal->pending, capacity);
+    if (grown == NULL) {
+        return 0;
+    }
+    journal->pending = grown;
+    journal->pending_capacity = capacity;
+    return 1;
+}
+
+/* Buffers one framed record in the active segment. Mutex held. */
+static int append_record_locked(Journal *journal, LogEntry *entry) {
+    size_t payload = log_entry_serialized_size(entry);
+    size_t frame = JOURNAL_FRAME_HEADER_SIZE + payload;
+
+    while (journal->active_bytes > 0 && journal->active_bytes + frame > journal->segment_limit) {
+        if (!rotate_locked(journal)) {
+            return 0;
+        }
+    }
+
+    if (!reserve_pending(journal, frame)) {
+        return 0;
+    }
+
+    unsigned char *out = journal->pending + journal->pending_len;
+    log_entry_serialize(entry, out + JOURNAL_FRAME_HEADER_SIZE, payload);
+    put_u32(out, (uint32_t)payload);
+    put_u32(out + 4, fnv1a32(out + JOURNAL_FRAME_HEADER_SIZE, payload));
+    journal->pending_len += frame;
+    journal->active_bytes += frame;
+
+    JournalSegment *segment = find_segment(journal, journal->active_seq);
+    segment->outstanding++;
+    segment->bytes += frame;
+    entry->journal_segment = journal->active_seq;
+    return 1;
+}
+
+static void note_append(Journal *journal, uint64_t started_us, size_t records) {
+    uint64_t elapsed = monotonic_us() - started_us;
+    atomic_fetch_add_explicit(&journal->appends, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&journal->records, records, memory_order_relaxed);
+    atomic_fetch_add_explicit(&journal->append_us_total, elapsed, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&journal->append_us_max, memory_order_relaxed);
+    while (elapsed > max &&
+           !atomic_compare_exchange_weak_explicit(&journal->append_us_max,
+                                                  &max,
+                                                  elapsed,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+/* Buffers `count` entries from `first`, then waits until a leader has made them durable. */
+static int append_entries(Journal *journal, LogEntry *first, size_t count, char *error, size_t error_size) {
+    if (journal == NULL || !journal->initialized) {
+        write_error(error, error_size, "Journal is not initialized.");
+        return 0;
+    }
+
+    uint64_t started_us = monotonic_us();
+    pthread_mutex_lock(&journal->mutex);
+
+    if (journal->failed) {
+        pthread_mutex_unlock(&journal->mutex);
+        write_error(error, error_size, "Journal is unavailable after a write failure.");
+        return 0;
+    }
+
+    size_t appended = 0;
+    for (LogEntry *entry = first; entry != NULL && appended < count; entry = entry->next) {
+        if (!append_record_locked(journal, entry)) {
+            break;
+        }
+        appended++;
+    }
+
+    uint64_t ticket = ++journal->appended_ticket;
+    while (journal->durable_ticket < ticket && !journal->failed) {
+        if (journal->flushing) {
+            pthread_cond_wait(&journal->flushed, &journal->mutex);
+        } else {
+            flush_locked(journal);
+        }
+    }
+
+    int ok = appended == count && !journal->failed;
+    pthread_mutex_unlock(&journal->mutex);
+
+    if (!ok) {
+        /* Rejected entries must not keep their segment alive. */
+        size_t released = 0;
+        for (LogEntry *entry = first; entry != NULL && released < appended; entry = entry->next) {
+            journal_release(journal, entry);
+            released++;
+        }
+        write_error(error, error_size, "Failed to write journal record.");
+        return 0;
+    }
+
+    note_append(journal, started_us, count);
+    return 1;
+}
+
+int journal_open(Journal *journal,
+                 const char *dir,
+                 size_t segment_limit,
+                 int fsync_enabled,
+                 AppLogger *logger,
+                 char *error,
+                 size_t error_size) {
+    if (journal == NULL || dir == NULL || dir[0] == '\0') {
+        write_error(error, error_size, "Invalid journal arguments.");
+        return 0;
+    }
+
+    memset(journal, 0, sizeof(*journal));
+    snprintf(journal->dir, sizeof(journal->dir), "%s", dir);
+    journal->segment_limit = segment_limit > 0 ? segment_limit : 1;
+    journal->fsync_enabled = fsync_enabled;
+    journal->fd = -1;
+    journal->logger = logger;
+
+    if (mkdir(journal->dir, 0755) != 0 && errno != EEXIST) {
+        write_error(error, error_size, "Unable to create journal directory.");
+        return 0;
+    }
+
+    DIR *handle = opendir(journal->dir);
+    if (handle == NULL) {
+        write_error(error, error_size, "Unable to open journal directory.");
+        return 0;
+    }
+
+    uint32_t max_seq = 0;
+    struct dirent *item = NULL;
+    while ((item = readdir(handle)) != NULL) {
+        uint32_t seq = 0;
+        if (!parse_segment_name(item->d_name, &seq)) {
+            continue;
+        }
+
+        char path[320];
+        struct stat info;
+        segment_path(journal, seq, path, sizeof(path));
+        if (stat(path, &info) != 0 || !add_segment(journal, seq, (size_t)info.st_size)) {
+            closedir(handle);
+            free(journal->segments);
+            write_error(error, error_size, "Unable to index journal segments.");
+            return 0;
+        }
+        if (seq > max_seq) {
+            max_seq = seq;
+        }
+    }
+    closedir(handle);
+    if (journal->segment_count > 1) {
+        qsort(journal->segments, journal->segment_count, sizeof(JournalSegment), compare_segments);
+    }
+
+    /* Recovered segments are never appended to: a torn tail stays where it is. */
+    if (!open_active_segment(journal, max_seq + 1)) {
+        free(journal->segments);
+        write_error(error, error_size, "Unable to open journal segment.");
+        return 0;
+    }
+
+    if (pthread_mutex_init(&journal->mutex, NULL) != 0) {
+        close(journal->fd);
+        free(journal->segments);
+        write_error(error, error_size, "Failed to initialize journal mutex.");
+        return 0;
+    }
+
+    if (pthread_cond_init(&journal->flushed, NULL) != 0) {
+        pthread_mutex_destroy(&journal->mutex);
+        close(journal->fd);
+        free(journal->segments);
+        write_error(error, error_size, "Failed to initialize journal condition.");
+        return 0;
+    }
+
+    atomic_init(&journal->appends, 0);
+    atomic_init(&journal->records, 0);
+    atomic_init(&journal->syncs, 0);
+    atomic_init(&journal->bytes_written, 0);
+    atomic_init(&journal->append_us_total, 0);
+    atomic_init(&journal->append_us_max, 0);
+    journal->initialized = 1;
+
+    logger_log(logger,
+               LOGGER_INFO,
+               "journal",
+               "opened dir=%s segments=%zu segment_limit=%zu fsync=%d",
+               journal->dir,
+               journal->segment_count - 1,
+               journal->segment_limit,
+               fsync_enabled);
+    return 1;
+}
+
+static size_t read_file(const char *path, unsigned char **data_out) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    size_t capacity = 0;
+    size_t size = 0;
+    unsigned char *data = NULL;
+    for (;;) {
+        if (size == capacity) {
+            capacity = capacity == 0 ? JOURNAL_INITIAL_PENDING : capacity * 2;
+            unsigned char *grown = (unsigned char *)realloc(data, capacity);
+            if (grown == NULL) {
+                free(data);
+                fclose(file);
+                return 0;
+            }
+            data = grown;
+        }
+
+        size_t read = fread(data + size, 1, capacity - size, file);
+        size += read;
+        if (read == 0) {
+            break;
+        }
+    }
+
+    fclose(file);
+    *data_out = data;
+    return size;
+}
+
+/*
+ * Feeds every intact record of the recovered segments to `fn`, oldest
+ * first. A segment is read up to its first torn or corrupt frame, which is
+ * where a crash interrupted the writer. Segments left with nothing
+ * outstanding are deleted.
+ */
+int journal_replay(Journal *journal, JournalReplayFn fn, void *context, char *error, size_t error_size) {
+    if (journal == NULL || !journal->initialized || fn == NULL) {
+        write_error(error, error_size, "Journal is not initialized.");
+        return 0;
+    }
+
+    uint64_t started_us = monotonic_us();
+
+    pthread_mutex_lock(&journal->mutex);
+    size_t recovered = journal->segment_count - 1;
+    uint32_t *seqs = (uint32_t *)calloc(recovered + 1, sizeof(uint32_t));
+    if (seqs == NULL) {
+        pthread_mutex_unlock(&journal->mutex);
+        write_error(error, error_size, "Unable to allocate journal replay state.");
+        return 0;
+    }
+    for (size_t i = 0; i < recovered; ++i) {
+        seqs[i] = journal->segments[i].seq;
+    }
+    pthread_mutex_unlock(&journal->mutex);
+
+    for (size_t i = 0; i < recovered; ++i) {
+        char path[320];
+        segment_path(journal, seqs[i], path, sizeof(path));
+
+        unsigned char *data = NULL;
+        size_t size = read_file(path, &data);
+        size_t offset = 0;
+        while (offset < size) {
+            if (size - offset < JOURNAL_FRAME_HEADER_SIZE) {
+                journal->replay_corrupt++;
+                break;
+            }
+
+            uint32_t payload = get_u32(data + offset);
+            uint32_t checksum = get_u32(data + offset + 4);
+            const unsigned char *body = data + offset + JOURNAL_FRAME_HEADER_SIZE;
+            LogEntryRecord record;
+
+            if (payload > size - offset - JOURNAL_FRAME_HEADER_SIZE || fnv1a32(body, payload) != checksum ||
+                log_entry_deserialize(body, payload, &record) != payload) {
+                journal->replay_corrupt++;
+                break;
+            }
+
+            pthread_mutex_lock(&journal->mutex);
+            find_segment(journal, seqs[i])->outstanding++;
+            pthread_mutex_unlock(&journal->mutex);
+
+            if (fn(context, &record, seqs[i])) {
+                journal->replayed++;
+            } else {
+                journal->replay_dropped++;
+                journal_release_segment(journal, seqs[i]);
+            }
+            offset += JOURNAL_FRAME_HEADER_SIZE + payload;
+        }
+        free(data);
+
+        pthread_mutex_lock(&journal->mutex);
+        int retired = retire_segment_locked(journal, seqs[i]);
+        pthread_mutex_unlock(&journal->mutex);
+        if (retired) {
+            unlink_segment(journal, seqs[i]);
+        }
+    }
+    free(seqs);
+
+    journal->recovery_ms = (double)(monotonic_us() - started_us) / 1000.0;
+    logger_log(journal->logger,
+               journal->replay_dropped > 0 ? LOGGER_ERROR : LOGGER_INFO,
+               "journal",
+               "replayed=%llu dropped=%llu torn_segments=%llu recovery_ms=%.3f",
+               (unsigned long long)journal->replayed,
+               (unsigned long long)journal->replay_dropped,
+               (unsigned long long)journal->replay_corrupt,
+               journal->recovery_ms);
+    return 1;
+}
+
+int journal_append(Journal *journal, LogEntry *entry, char *error, size_t error_size) {
+    if (entry == NULL) {
+        write_error(error, error_size, "Invalid journal record.");
+        return 0;
+    }
+
+    return append_entries(journal, entry, 1, error, error_size);
+}
+
+/* One durable write for the whole list; on failure no entry is journaled. */
+int journal_append_batch(Journal *journal, LinkedList *entries, char *error, size_t error_size) {
+    if (entries == NULL || entries->size == 0) {
+        return 1;
+    }
+
+    return append_entries(journal, entries->head, entries->size, error, error_size);
+}
+
+void journal_release(Journal *journal, const LogEntry *entry) {
+    if (entry != NULL) {
+        journal_release_segment(journal, entry->journal_segment);
+    }
+}
+
+void journal_release_segment(Journal *journal, uint32_t segment) {
+    if (journal == NULL || !journal->initialized || segment == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&journal->mutex);
+    JournalSegment *owner = find_segment(journal, segment);
+    int retired = 0;
+    if (owner != NULL && owner->outstanding > 0) {
+        owner->outstanding--;
+        retired = owner->outstanding == 0 && retire_segment_locked(journal, segment);
+    }
+    pthread_mutex_unlock(&journal->mutex);
+
+    if (retired) {
+        unlink_segment(journal, segment);
+    }
+}
+
+void journal_get_stats(Journal *journal, JournalStats *out_stats) {
+    if (out_stats == NULL) {
+        return;
+    }
+
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (journal == NULL || !journal->initialized) {
+        return;
+    }
+
+    out_stats->appends = atomic_load_explicit(&journal->appends, memory_order_relaxed);
+    out_stats->records = atomic_load_explicit(&journal->records, memory_order_relaxed);
+    out_stats->syncs = atomic_load_explicit(&journal->syncs, memory_order_relaxed);
+    out_stats->bytes_written = atomic_load_explicit(&journal->bytes_written, memory_order_relaxed);
+    uint64_t total_us = atomic_load_explicit(&journal->append_us_total, memory_order_relaxed);
+    out_stats->append_latency_ms_avg = out_stats->appends > 0 ? (double)total_us / (double)out_stats->appends / 1000.0 : 0.0;
+    out_stats->append_latency_ms_max =
+        (double)atomic_load_explicit(&journal->append_us_max, memory_order_relaxed) / 1000.0;
+
+    pthread_mutex_lock(&journal->mutex);
+    out_stats->segments = journal->segment_count;
+    for (size_t i = 0; i < journal->segment_count; ++i) {
+        out_stats->segment_bytes_total += journal->segments[i].bytes;
+    }
+    out_stats->active_segment = journal->active_seq;
+    out_stats->replayed = journal->replayed;
+    out_stats->replay_dropped = journal->replay_dropped;
+    out_stats->replay_corrupt = journal->replay_corrupt;
+    out_stats->recovery_ms = journal->recovery_ms;
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+/* Entries still outstanding stay on disk and are replayed by the next journal_open(). */
+void journal_close(Journal *journal) {
+    if (journal == NULL || !journal->initialized) {
+        return;
+    }
+
+    pthread_mutex_lock(&journal->mutex);
+    while (journal->flushing) {
+        pthread_cond_wait(&journal->flushed, &journal->mutex);
+    }
+    if (journal->pending_len > 0 && !journal->failed) {
+        flush_locked(journal);
+    }
+    pthread_mutex_unlock(&journal->mutex);
+
+    if (journal->fd >= 0) {
+        close(journal->fd);
+        journal->fd = -1;
+    }
+
+    /* An active segment nothing references is just noise for the next recovery. */
+    JournalSegment *active = find_segment(journal, journal->active_seq);
+    if (active != NULL && active->outstanding == 0) {
+        unlink_segment(journal, journal->active_seq);
+    }
+
+    pthread_cond_destroy(&journal->flushed);
+    pthread_mutex_destroy(&journal->mutex);
+    free(journal->pending);
+    free(journal->spare);
+    free(journal->segments);
+    journal->pending = NULL;
+    journal->spare = NULL;
+    journal->segments = NULL;
+    journal->initialized = 0;
+}
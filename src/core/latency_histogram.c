@@ -0,0 +1,135 @@
+#include "latency_histogram.h"
+
+#include <string.h>
+
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_COUNT (1u << LATENCY_SUB_BITS)
+#define LATENCY_LINEAR_LIMIT (2u * LATENCY_SUB_COUNT)
+#define LATENCY_MIN_MSB 4
+#define LATENCY_MAX_MSB 40
+
+static int highest_bit(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+static size_t bucket_index(uint64_t micros) {
+    if (micros < LATENCY_LINEAR_LIMIT) {
+        return (size_t)micros;
+    }
+
+    int msb = highest_bit(micros);
+    if (msb > LATENCY_MAX_MSB) {
+        return LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+
+    size_t sub = (size_t)((micros >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1));
+    return LATENCY_LINEAR_LIMIT + ((size_t)(msb - LATENCY_MIN_MSB) * LATENCY_SUB_COUNT) + sub;
+}
+
+/* Highest value that maps to `index`, the conservative answer for a percentile. */
+static uint64_t bucket_upper(size_t index) {
+    if (index < LATENCY_LINEAR_LIMIT) {
+        return (uint64_t)index;
+    }
+
+    size_t offset = index - LATENCY_LINEAR_LIMIT;
+    int shift = (int)(offset / LATENCY_SUB_COUNT) + LATENCY_MIN_MSB - LATENCY_SUB_BITS;
+    uint64_t lower = (uint64_t)(LATENCY_SUB_COUNT + (offset % LATENCY_SUB_COUNT)) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+int latency_histogram_init(LatencyHistogram *histogram) {
+    if (histogram == NULL) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        atomic_init(&histogram->buckets[i], 0);
+    }
+    atomic_init(&histogram->sum_us, 0);
+    atomic_init(&histogram->window_max_us, 0);
+    memset(histogram->baseline, 0, sizeof(histogram->baseline));
+    histogram->baseline_sum_us = 0;
+    return pthread_mutex_init(&histogram->window_mutex, NULL) == 0;
+}
+
+void latency_histogram_destroy(LatencyHistogram *histogram) {
+    if (histogram != NULL) {
+        pthread_mutex_destroy(&histogram->window_mutex);
+    }
+}
+
+void latency_histogram_record(LatencyHistogram *histogram, uint64_t micros, uint64_t count) {
+    if (histogram == NULL || count == 0) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&histogram->buckets[bucket_index(micros)], count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum_us, micros * count, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&histogram->window_max_us, memory_order_relaxed);
+    while (micros > max &&
+           !atomic_compare_exchange_weak_explicit(
+               &histogram->window_max_us, &max, micros, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void latency_histogram_summarize(LatencyHistogram *histogram, LatencySummary *out_summary) {
+    if (out_summary == NULL) {
+        return;
+    }
+    memset(out_summary, 0, sizeof(*out_summary));
+    if (histogram == NULL) {
+        return;
+    }
+
+    uint64_t window[LATENCY_HISTOGRAM_BUCKETS];
+    uint64_t total = 0;
+
+    pthread_mutex_lock(&histogram->window_mutex);
+    /* The total comes from the buckets read, so percentiles stay consistent mid-recording. */
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        window[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed) - histogram->baseline[i];
+        total += window[i];
+    }
+    uint64_t sum_us = atomic_load_explicit(&histogram->sum_us, memory_order_relaxed) - histogram->baseline_sum_us;
+    uint64_t max_us = atomic_load_explicit(&histogram->window_max_us, memory_order_relaxed);
+    pthread_mutex_unlock(&histogram->window_mutex);
+
+    if (total == 0) {
+        return;
+    }
+
+    const double quantiles[3] = {0.50, 0.95, 0.99};
+    double *targets[3] = {&out_summary->p50_ms, &out_summary->p95_ms, &out_summary->p99_ms};
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS && next < 3; ++i) {
+        seen += window[i];
+        while (next < 3 && seen > 0 && (double)seen >= quantiles[next] * (double)total) {
+            uint64_t value = bucket_upper(i);
+            if (max_us > 0 && value > max_us) {
+                value = max_us;
+            }
+            *targets[next++] = (double)value / 1000.0;
+        }
+    }
+
+    out_summary->count = total;
+    out_summary->mean_ms = ((double)sum_us / (double)total) / 1000.0;
+    out_summary->max_ms = (double)max_us / 1000.0;
+}
+
+void latency_histogram_reset_window(LatencyHistogram *histogram) {
+    if (histogram == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&histogram->window_mutex);
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        histogram->baseline[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+    }
+    histogram->baseline_sum_us = atomic_load_explicit(&histogram->sum_us, memory_order_relaxed);
+    atomic_store_explicit(&histogram->window_max_us, 0, memory_order_relaxed);
+    pthread_mutex_unlock(&histogram->window_mutex);
+}
@@ -1,7 +1,5 @@
 #include "linked_list.h"
 
-#include <stdlib.h>
-
 void linked_list_init(LinkedList *list) {
     if (list == NULL) {
         return;
@@ -12,33 +10,33 @@ void linked_list_init(LinkedList *list) {
     list->size = 0;
 }
 
-static int linked_list_attach_after(LinkedList *list, LinkedListNode *node, LinkedListNode *after) {
-    if (list == NULL || node == NULL) {
+static int linked_list_attach_after(LinkedList *list, LogEntry *entry, LogEntry *after) {
+    if (list == NULL || entry == NULL) {
         return 0;
     }
 
     if (after == NULL) {
-        node->prev = NULL;
-        node->next = list->head;
+        entry->prev = NULL;
+        entry->next = list->head;
         if (list->head != NULL) {
-            list->head->prev = node;
+            list->head->prev = entry;
         }
-        list->head = node;
+        list->head = entry;
         if (list->tail == NULL) {
-            list->tail = node;
+            list->tail = entry;
         }
         list->size++;
         return 1;
     }
 
-    node->prev = after;
-    node->next = after->next;
-    after->next = node;
+    entry->prev = after;
+    entry->next = after->next;
+    after->next = entry;
 
-    if (node->next != NULL) {
-        node->next->prev = node;
+    if (entry->next != NULL) {
+        entry->next->prev = entry;
     } else {
-        list->tail = node;
+        list->tail = entry;
     }
 
     list->size++;
@@ -50,13 +48,7 @@ int linked_list_push_back(LinkedList *list, LogEntry *entry) {
         return 0;
     }
 
-    LinkedListNode *node = (LinkedListNode *)calloc(1, sizeof(LinkedListNode));
-    if (node == NULL) {
-        return 0;
-    }
-
-    node->entry = entry;
-    return linked_list_attach_after(list, node, list->tail);
+    return linked_list_attach_after(list, entry, list->tail);
 }
 
 int linked_list_push_front(LinkedList *list, LogEntry *entry) {
@@ -64,13 +56,7 @@ int linked_list_push_front(LinkedList *list, LogEntry *entry) {
         return 0;
     }
 
-    LinkedListNode *node = (LinkedListNode *)calloc(1, sizeof(LinkedListNode));
-    if (node == NULL) {
-        return 0;
-    }
-
-    node->entry = entry;
-    return linked_list_attach_after(list, node, NULL);
+    return linked_list_attach_after(list, entry, NULL);
 }
 
 LogEntry *linked_list_pop_front(LinkedList *list) {
@@ -78,10 +64,9 @@ LogEntry *linked_list_pop_front(LinkedList *list) {
         return NULL;
     }
 
-    LinkedListNode *node = list->head;
-    LogEntry *entry = node->entry;
+    LogEntry *entry = list->head;
 
-    list->head = node->next;
+    list->head = entry->next;
     if (list->head != NULL) {
         list->head->prev = NULL;
     } else {
@@ -92,10 +77,112 @@ LogEntry *linked_list_pop_front(LinkedList *list) {
         list->size--;
     }
 
-    free(node);
+    entry->next = NULL;
+    entry->prev = NULL;
     return entry;
 }
 
+/* Unlinks an entry known to be in `list`, from any position. */
+void linked_list_remove(LinkedList *list, LogEntry *entry) {
+    if (list == NULL || entry == NULL) {
+        return;
+    }
+
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        list->head = entry->next;
+    }
+
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else {
+        list->tail = entry->prev;
+    }
+
+    if (list->size > 0) {
+        list->size--;
+    }
+
+    entry->next = NULL;
+    entry->prev = NULL;
+}
+
+/*
+ * Detaches up to max_items entries from the head of `list` and appends them to
+ * `out_list`. Walks the detached prefix once to find the cut point; the splice
+ * itself is constant time.
+ */
+size_t linked_list_pop_front_batch(LinkedList *list, size_t max_items, LinkedList *out_list) {
+    if (list == NULL || out_list == NULL || list->head == NULL || max_items == 0) {
+        return 0;
+    }
+
+    LogEntry *first = list->head;
+    LogEntry *last = first;
+    size_t count = 1;
+    while (count < max_items && last->next != NULL) {
+        last = last->next;
+        count++;
+    }
+
+    list->head = last->next;
+    if (list->head != NULL) {
+        list->head->prev = NULL;
+    } else {
+        list->tail = NULL;
+    }
+    list->size -= count;
+
+    last->next = NULL;
+    first->prev = out_list->tail;
+    if (out_list->tail != NULL) {
+        out_list->tail->next = first;
+    } else {
+        out_list->head = first;
+    }
+    out_list->tail = last;
+    out_list->size += count;
+
+    return count;
+}
+
+/* Moves every entry of `other` in front of `list`'s head, leaving `other` empty. */
+void linked_list_prepend_list(LinkedList *list, LinkedList *other) {
+    if (list == NULL || other == NULL || other->head == NULL) {
+        return;
+    }
+
+    other->tail->next = list->head;
+    if (list->head != NULL) {
+        list->head->prev = other->tail;
+    } else {
+        list->tail = other->tail;
+    }
+    list->head = other->head;
+    list->size += other->size;
+
+    linked_list_init(other);
+}
+
+/* Moves every entry of `other` after `list`'s tail, leaving `other` empty. */
+void linked_list_append_list(LinkedList *list, LinkedList *other) {
+    if (list == NULL || other == NULL || other->head == NULL) {
+        return;
+    }
+
+    other->head->prev = list->tail;
+    if (list->tail != NULL) {
+        list->tail->next = other->head;
+    } else {
+        list->head = other->head;
+    }
+    list->tail = other->tail;
+    list->size += other->size;
+
+    linked_list_init(other);
+}
+
 size_t linked_list_size(const LinkedList *list) {
     if (list == NULL) {
         return 0;
@@ -109,13 +196,12 @@ void linked_list_clear(LinkedList *list, void (*entry_free_fn)(LogEntry *)) {
         return;
     }
 
-    LinkedListNode *cursor = list->head;
+    LogEntry *cursor = list->head;
     while (cursor != NULL) {
-        LinkedListNode *next = cursor->next;
-        if (entry_free_fn != NULL && cursor->entry != NULL) {
-            entry_free_fn(cursor->entry);
+        LogEntry *next = cursor->next;
+        if (entry_free_fn != NULL) {
+            entry_free_fn(cursor);
         }
-        free(cursor);
         cursor = next;
     }
 
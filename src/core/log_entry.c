@@ -1,6 +1,6 @@
 #include "log_entry.h"
 
-#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -13,21 +13,40 @@ int64_t log_entry_now_ms(void) {
     return ((int64_t)ts.tv_sec * 1000LL) + (ts.tv_nsec / 1000000LL);
 }
 
-static int copy_text(char *dest, size_t dest_size, const char *value) {
-    if (dest == NULL || dest_size == 0 || value == NULL) {
+static int text_length(const char *value, size_t max_len, size_t *len_out) {
+    if (value == NULL) {
         return 0;
     }
 
-    size_t len = strnlen(value, dest_size);
-    if (len == dest_size) {
+    size_t len = strnlen(value, max_len);
+    if (len == max_len) {
         return 0;
     }
 
-    snprintf(dest, dest_size, "%s", value);
+    *len_out = len;
     return 1;
 }
 
+static size_t payload_size(size_t level_len, size_t source_len, size_t message_len) {
+    return sizeof(LogEntry) + level_len + source_len + message_len + 3;
+}
+
+size_t log_entry_required_size(const char *level, const char *source, const char *message) {
+    size_t level_len = 0;
+    size_t source_len = 0;
+    size_t message_len = 0;
+
+    if (!text_length(level, LOG_LEVEL_MAX_LEN, &level_len) ||
+        !text_length(source, LOG_SOURCE_MAX_LEN, &source_len) ||
+        !text_length(message, LOG_MESSAGE_MAX_LEN, &message_len)) {
+        return 0;
+    }
+
+    return payload_size(level_len, source_len, message_len);
+}
+
 int log_entry_init(LogEntry *entry,
+                   size_t entry_size,
                    uint64_t id,
                    const char *level,
                    const char *source,
@@ -37,19 +56,156 @@ int log_entry_init(LogEntry *entry,
         return 0;
     }
 
-    if (!copy_text(entry->level, sizeof(entry->level), level)) {
-        return 0;
-    }
+    size_t level_len = 0;
+    size_t source_len = 0;
+    size_t message_len = 0;
 
-    if (!copy_text(entry->source, sizeof(entry->source), source)) {
+    if (!text_length(level, LOG_LEVEL_MAX_LEN, &level_len) ||
+        !text_length(source, LOG_SOURCE_MAX_LEN, &source_len) ||
+        !text_length(message, LOG_MESSAGE_MAX_LEN, &message_len)) {
         return 0;
     }
 
-    if (!copy_text(entry->message, sizeof(entry->message), message)) {
+    if (payload_size(level_len, source_len, message_len) > entry_size) {
         return 0;
     }
 
+    char *cursor = entry->data;
+    memcpy(cursor, level, level_len + 1);
+    cursor += level_len + 1;
+    memcpy(cursor, source, source_len + 1);
+    cursor += source_len + 1;
+    memcpy(cursor, message, message_len + 1);
+
+    entry->attempts = 0;
+    entry->journal_segment = 0;
+    entry->lane = 0;
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->level_len = (uint16_t)level_len;
+    entry->source_len = (uint16_t)source_len;
+    entry->message_len = (uint16_t)message_len;
     entry->id = id;
     entry->ingested_at_ms = ingested_at_ms > 0 ? ingested_at_ms : log_entry_now_ms();
     return 1;
 }
+
+LogEntry *log_entry_create(uint64_t id,
+                           const char *level,
+                           const char *source,
+                           const char *message,
+                           int64_t ingested_at_ms) {
+    size_t size = log_entry_required_size(level, source, message);
+    if (size == 0) {
+        return NULL;
+    }
+
+    LogEntry *entry = (LogEntry *)malloc(size);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    if (!log_entry_init(entry, size, id, level, source, message, ingested_at_ms)) {
+        free(entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+void log_entry_free(LogEntry *entry) {
+    free(entry);
+}
+
+size_t log_entry_size(const LogEntry *entry) {
+    if (entry == NULL) {
+        return 0;
+    }
+
+    return payload_size(entry->level_len, entry->source_len, entry->message_len);
+}
+
+const char *log_entry_level(const LogEntry *entry) {
+    return entry->data;
+}
+
+const char *log_entry_source(const LogEntry *entry) {
+    return entry->data + entry->level_len + 1;
+}
+
+const char *log_entry_message(const LogEntry *entry) {
+    return entry->data + entry->level_len + 1 + entry->source_len + 1;
+}
+
+static void put_u16(unsigned char *out, uint16_t value) {
+    out[0] = (unsigned char)(value & 0xFFu);
+    out[1] = (unsigned char)(value >> 8);
+}
+
+static uint16_t get_u16(const unsigned char *in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+size_t log_entry_serialized_size(const LogEntry *entry) {
+    if (entry == NULL) {
+        return 0;
+    }
+
+    return LOG_ENTRY_RECORD_HEADER_SIZE + entry->level_len + entry->source_len + entry->message_len + 3;
+}
+
+/* Returns the bytes written, or 0 when `buffer` is too small. */
+size_t log_entry_serialize(const LogEntry *entry, unsigned char *buffer, size_t buffer_size) {
+    size_t size = log_entry_serialized_size(entry);
+    if (size == 0 || buffer == NULL || buffer_size < size) {
+        return 0;
+    }
+
+    uint64_t ingested = (uint64_t)entry->ingested_at_ms;
+    for (int i = 0; i < 8; ++i) {
+        buffer[i] = (unsigned char)(ingested >> (8 * i));
+    }
+    put_u16(buffer + 8, entry->attempts);
+    put_u16(buffer + 10, entry->level_len);
+    put_u16(buffer + 12, entry->source_len);
+    put_u16(buffer + 14, entry->message_len);
+    memcpy(buffer + LOG_ENTRY_RECORD_HEADER_SIZE, entry->data, size - LOG_ENTRY_RECORD_HEADER_SIZE);
+    return size;
+}
+
+/* Returns the bytes consumed, or 0 when the record is truncated or malformed. */
+size_t log_entry_deserialize(const unsigned char *buffer, size_t buffer_size, LogEntryRecord *record) {
+    if (buffer == NULL || record == NULL || buffer_size < LOG_ENTRY_RECORD_HEADER_SIZE) {
+        return 0;
+    }
+
+    size_t level_len = get_u16(buffer + 10);
+    size_t source_len = get_u16(buffer + 12);
+    size_t message_len = get_u16(buffer + 14);
+    if (level_len >= LOG_LEVEL_MAX_LEN || source_len >= LOG_SOURCE_MAX_LEN || message_len >= LOG_MESSAGE_MAX_LEN) {
+        return 0;
+    }
+
+    size_t size = LOG_ENTRY_RECORD_HEADER_SIZE + level_len + source_len + message_len + 3;
+    if (buffer_size < size) {
+        return 0;
+    }
+
+    const char *text = (const char *)(buffer + LOG_ENTRY_RECORD_HEADER_SIZE);
+    if (text[level_len] != '\0' || text[level_len + 1 + source_len] != '\0' ||
+        text[level_len + 1 + source_len + 1 + message_len] != '\0') {
+        return 0;
+    }
+
+    uint64_t ingested = 0;
+    for (int i = 0; i < 8; ++i) {
+        ingested |= (uint64_t)buffer[i] << (8 * i);
+    }
+
+    record->ingested_at_ms = (int64_t)ingested;
+    record->attempts = get_u16(buffer + 8);
+    record->level = text;
+    record->source = text + level_len + 1;
+    record->message = text + level_len + 1 + source_len + 1;
+    return size;
+}
@@ -0,0 +1,95 @@
+#include "mpmc_queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+int mpmc_queue_init(MpmcQueue *queue, size_t min_capacity) {
+    if (queue == NULL || min_capacity == 0) {
+        return 0;
+    }
+
+    size_t capacity = 2;
+    while (capacity < min_capacity) {
+        if (capacity > SIZE_MAX / 2) {
+            return 0;
+        }
+        capacity <<= 1;
+    }
+
+    queue->cells = (MpmcCell *)calloc(capacity, sizeof(MpmcCell));
+    if (queue->cells == NULL) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < capacity; ++i) {
+        atomic_init(&queue->cells[i].sequence, i);
+        queue->cells[i].value = NULL;
+    }
+
+    queue->mask = capacity - 1;
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+    return 1;
+}
+
+void mpmc_queue_destroy(MpmcQueue *queue) {
+    if (queue == NULL) {
+        return;
+    }
+
+    free(queue->cells);
+    queue->cells = NULL;
+    queue->mask = 0;
+}
+
+int mpmc_queue_push(MpmcQueue *queue, void *value) {
+    size_t position = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+
+    for (;;) {
+        MpmcCell *cell = &queue->cells[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos,
+                                                      &position,
+                                                      position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                cell->value = value;
+                atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            position = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+void *mpmc_queue_pop(MpmcQueue *queue) {
+    size_t position = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+
+    for (;;) {
+        MpmcCell *cell = &queue->cells[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(position + 1);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos,
+                                                      &position,
+                                                      position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                void *value = cell->value;
+                atomic_store_explicit(&cell->sequence, position + queue->mask + 1, memory_order_release);
+                return value;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            position = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,335 @@
+#include "processor_workers.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log_entry.h"
+
+#define PROCESSOR_WORKERS_ERROR_SIZE 256
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static struct timespec deadline_after_ms(int64_t delay_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)(delay_ms / 1000);
+    deadline.tv_nsec += (long)((delay_ms % 1000) * 1000000L);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+/*
+ * Sleeps up to delay_ms, or until notified when honor_notify is set (ignored
+ * while backing off after a failed batch). Returns 0 once the pool is stopping.
+ */
+static int wait_for_work(ProcessorWorkers *workers, int64_t delay_ms, int honor_notify, int *timed_out) {
+    struct timespec deadline = deadline_after_ms(delay_ms);
+
+    pthread_mutex_lock(&workers->mutex);
+    *timed_out = 0;
+    while (workers->running && !(honor_notify && atomic_load(&workers->notify_pending))) {
+        if (pthread_cond_timedwait(&workers->wake, &workers->mutex, &deadline) == ETIMEDOUT) {
+            *timed_out = 1;
+            break;
+        }
+    }
+    int running = workers->running;
+    atomic_store(&workers->notify_pending, 0);
+    pthread_mutex_unlock(&workers->mutex);
+
+    return running;
+}
+
+/* With adaptive batching the wake-up threshold follows the chosen batch size down. */
+static size_t current_batch_size(ProcessorWorkers *workers) {
+    return workers->processor->adaptive ? queue_processor_batch_size(workers->processor) : workers->batch_size;
+}
+
+static size_t current_threshold(ProcessorWorkers *workers, size_t batch_size) {
+    return workers->processor->adaptive && batch_size < workers->threshold ? batch_size : workers->threshold;
+}
+
+/* Without a max linger every timer wake-up flushes; with one, only an entry that old does. */
+static int linger_due(ProcessorWorkers *workers) {
+    if (workers->max_linger_ms <= 0) {
+        return 1;
+    }
+
+    int64_t oldest_ms = buffer_engine_oldest_ingested_at_ms(workers->engine);
+    return oldest_ms > 0 && log_entry_now_ms() - oldest_ms >= workers->max_linger_ms;
+}
+
+/*
+ * Time until the head entry reaches the max linger, capped at the idle
+ * period. An empty queue waits one full max linger: ingest below the
+ * threshold does not notify, so anything arriving meanwhile is due by then.
+ */
+static int64_t next_wait_ms(ProcessorWorkers *workers) {
+    if (workers->max_linger_ms <= 0) {
+        return workers->linger_ms;
+    }
+
+    int64_t oldest_ms = buffer_engine_oldest_ingested_at_ms(workers->engine);
+    int64_t wait_ms = workers->max_linger_ms;
+    if (oldest_ms > 0) {
+        wait_ms = oldest_ms + workers->max_linger_ms - log_entry_now_ms();
+    }
+    if (wait_ms < 0) {
+        return 0;
+    }
+    return wait_ms < workers->linger_ms ? wait_ms : workers->linger_ms;
+}
+
+static void *worker_main(void *arg) {
+    ProcessorWorkers *workers = (ProcessorWorkers *)arg;
+    /* Each worker prefers its own pool connection. */
+    const size_t slot = atomic_fetch_add(&workers->next_slot, 1);
+    int backing_off = 0;
+
+    for (;;) {
+        int timed_out = 0;
+        int64_t wait_ms = backing_off ? workers->linger_ms : next_wait_ms(workers);
+        if (!wait_for_work(workers, wait_ms, !backing_off, &timed_out)) {
+            break;
+        }
+
+        backing_off = 0;
+        size_t depth = buffer_engine_queue_depth(workers->engine);
+        if (depth == 0 ||
+            (depth < current_threshold(workers, current_batch_size(workers)) && !(timed_out && linger_due(workers)))) {
+            continue;
+        }
+
+        if (!sink_available(workers->processor->sink)) {
+            backing_off = 1;
+            continue;
+        }
+
+        /* Keep draining full batches while the backlog stays above the threshold. */
+        for (;;) {
+            size_t processed = 0;
+            double elapsed_ms = 0.0;
+            char error[PROCESSOR_WORKERS_ERROR_SIZE] = {0};
+            const size_t batch_size = current_batch_size(workers);
+
+            if (!queue_processor_process_slot(workers->processor,
+                                              slot,
+                                              batch_size,
+                                              &processed,
+                                              &elapsed_ms,
+                                              error,
+                                              sizeof(error))) {
+                logger_log(workers->logger, LOGGER_ERROR, "processor_workers", "batch failed: %s", error);
+                backing_off = 1;
+                break;
+            }
+
+            if (processed < batch_size ||
+                buffer_engine_queue_depth(workers->engine) < current_threshold(workers, batch_size)) {
+                break;
+            }
+
+            pthread_mutex_lock(&workers->mutex);
+            int running = workers->running;
+            pthread_mutex_unlock(&workers->mutex);
+            if (!running) {
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int processor_workers_start(ProcessorWorkers *workers,
+                            QueueProcessor *processor,
+                            BufferEngine *engine,
+                            AppLogger *logger,
+                            size_t thread_count,
+                            size_t threshold,
+                            size_t batch_size,
+                            int64_t linger_ms,
+                            int64_t max_linger_ms,
+                            char *error,
+                            size_t error_size) {
+    if (workers == NULL || processor == NULL || engine == NULL || thread_count == 0) {
+        write_error(error, error_size, "Invalid processor worker arguments.");
+        return 0;
+    }
+
+    memset(workers, 0, sizeof(*workers));
+    workers->processor = processor;
+    workers->engine = engine;
+    workers->logger = logger;
+    workers->thread_count = thread_count;
+    workers->threshold = threshold > 0 ? threshold : 1;
+    workers->batch_size = batch_size > 0 ? batch_size : 1;
+    workers->linger_ms = linger_ms > 0 ? linger_ms : 1000;
+    workers->max_linger_ms = max_linger_ms > 0 ? max_linger_ms : 0;
+    atomic_init(&workers->notify_pending, 0);
+    atomic_init(&workers->next_slot, 0);
+
+    workers->threads = (pthread_t *)calloc(thread_count, sizeof(pthread_t));
+    if (workers->threads == NULL) {
+        write_error(error, error_size, "Unable to allocate processor threads.");
+        return 0;
+    }
+
+    if (pthread_mutex_init(&workers->mutex, NULL) != 0) {
+        free(workers->threads);
+        workers->threads = NULL;
+        write_error(error, error_size, "Failed to initialize processor worker mutex.");
+        return 0;
+    }
+
+    if (pthread_cond_init(&workers->wake, NULL) != 0) {
+        pthread_mutex_destroy(&workers->mutex);
+        free(workers->threads);
+        workers->threads = NULL;
+        write_error(error, error_size, "Failed to initialize processor worker condition.");
+        return 0;
+    }
+
+    workers->running = 1;
+    workers->initialized = 1;
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        if (pthread_create(&workers->threads[i], NULL, worker_main, workers) != 0) {
+            processor_workers_stop(workers);
+            write_error(error, error_size, "Failed to start processor thread.");
+            return 0;
+        }
+        workers->started_count++;
+    }
+
+    logger_log(logger,
+               LOGGER_INFO,
+               "processor_workers",
+               "started threads=%zu threshold=%zu batch_size=%zu linger_ms=%lld max_linger_ms=%lld",
+               thread_count,
+               workers->threshold,
+               workers->batch_size,
+               (long long)workers->linger_ms,
+               (long long)workers->max_linger_ms);
+    return 1;
+}
+
+void processor_workers_notify(ProcessorWorkers *workers) {
+    if (workers == NULL || !workers->initialized) {
+        return;
+    }
+
+    /* Only the first notifier since the last wake-up pays for the lock. */
+    if (atomic_exchange(&workers->notify_pending, 1) != 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&workers->mutex);
+    pthread_cond_signal(&workers->wake);
+    pthread_mutex_unlock(&workers->mutex);
+}
+
+void processor_workers_stop(ProcessorWorkers *workers) {
+    if (workers == NULL || !workers->initialized) {
+        return;
+    }
+
+    pthread_mutex_lock(&workers->mutex);
+    workers->running = 0;
+    pthread_cond_broadcast(&workers->wake);
+    pthread_mutex_unlock(&workers->mutex);
+
+    for (size_t i = 0; i < workers->started_count; ++i) {
+        pthread_join(workers->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&workers->wake);
+    pthread_mutex_destroy(&workers->mutex);
+    free(workers->threads);
+    workers->threads = NULL;
+    workers->started_count = 0;
+    workers->initialized = 0;
+}
+
+typedef struct {
+    QueueProcessor *processor;
+    AppLogger *logger;
+    size_t batch_size;
+    int64_t deadline_ms;
+    atomic_size_t next_slot;
+    atomic_size_t drained;
+} DrainContext;
+
+static void *drain_main(void *arg) {
+    DrainContext *context = (DrainContext *)arg;
+    const size_t slot = atomic_fetch_add(&context->next_slot, 1);
+
+    while (log_entry_now_ms() < context->deadline_ms) {
+        size_t processed = 0;
+        char error[PROCESSOR_WORKERS_ERROR_SIZE] = {0};
+
+        if (!queue_processor_process_slot(context->processor,
+                                          slot,
+                                          context->batch_size,
+                                          &processed,
+                                          NULL,
+                                          error,
+                                          sizeof(error))) {
+            logger_log(context->logger, LOGGER_ERROR, "processor_workers", "drain batch failed: %s", error);
+            break;
+        }
+
+        atomic_fetch_add(&context->drained, processed);
+        if (processed == 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+size_t processor_workers_drain(QueueProcessor *processor,
+                               AppLogger *logger,
+                               size_t thread_count,
+                               size_t batch_size,
+                               int64_t deadline_ms) {
+    if (processor == NULL) {
+        return 0;
+    }
+
+    DrainContext context;
+    context.processor = processor;
+    context.logger = logger;
+    context.batch_size = batch_size > 0 ? batch_size : 1;
+    context.deadline_ms = deadline_ms;
+    atomic_init(&context.next_slot, 0);
+    atomic_init(&context.drained, 0);
+
+    size_t helpers = thread_count > 1 ? thread_count - 1 : 0;
+    pthread_t *threads = helpers > 0 ? (pthread_t *)calloc(helpers, sizeof(pthread_t)) : NULL;
+    size_t started = 0;
+    for (size_t i = 0; threads != NULL && i < helpers; ++i) {
+        if (pthread_create(&threads[i], NULL, drain_main, &context) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    drain_main(&context);
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    return atomic_load(&context.drained);
+}
@@ -1,8 +1,8 @@
 #include "queue_processor.h"
 
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "log_entry.h"
 
@@ -12,45 +12,190 @@ static void write_error(char *error, size_t error_size, const char *message) {
     }
 }
 
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL);
+}
+
+/* Ingest times are wall-clock milliseconds, so these samples have millisecond resolution. */
+static void record_since_ingest(BufferEngine *engine,
+                                EngineLatencyKind kind,
+                                const LinkedList *entries,
+                                int64_t now_ms) {
+    for (const LogEntry *entry = entries->head; entry != NULL; entry = entry->next) {
+        int64_t waited_ms = now_ms - entry->ingested_at_ms;
+        buffer_engine_record_latency(engine, kind, waited_ms > 0 ? (uint64_t)waited_ms * 1000ULL : 0, 1);
+    }
+}
+
 int queue_processor_init(QueueProcessor *processor,
                          BufferEngine *engine,
-                         Persistence *persistence,
+                         Sink *sink,
+                         DeadLetterStore *dead_letters,
                          AppLogger *logger,
                          size_t default_batch_size,
+                         unsigned int max_attempts,
                          char *error,
                          size_t error_size) {
-    if (processor == NULL || engine == NULL || persistence == NULL) {
+    if (processor == NULL || engine == NULL || sink == NULL) {
         write_error(error, error_size, "Invalid queue processor arguments.");
         return 0;
     }
 
     memset(processor, 0, sizeof(*processor));
     processor->engine = engine;
-    processor->persistence = persistence;
+    processor->sink = sink;
+    processor->dead_letters = dead_letters;
     processor->logger = logger;
     processor->default_batch_size = default_batch_size > 0 ? default_batch_size : 1;
+    processor->max_attempts = max_attempts;
+    atomic_init(&processor->batch_size, processor->default_batch_size);
+
+    if (pthread_mutex_init(&processor->dispatch_mutex, NULL) != 0) {
+        write_error(error, error_size, "Failed to initialize queue processor mutex.");
+        return 0;
+    }
+    processor->initialized = 1;
 
     logger_log(logger,
                LOGGER_INFO,
                "queue_processor",
-               "initialized batch_size=%zu",
-               processor->default_batch_size);
+               "initialized sink=%s batch_size=%zu max_attempts=%u dead_letter=%s",
+               sink_name(sink),
+               processor->default_batch_size,
+               processor->max_attempts,
+               dead_letters != NULL ? dead_letters->path : "off");
 
     return 1;
 }
 
+/*
+ * Moves entries that reached max_attempts out of `failed` into the
+ * dead-letter store so one poison record cannot block the queue head.
+ * Entries the store cannot take stay in `failed` and are requeued.
+ */
+static void divert_dead_letters(QueueProcessor *processor, LinkedList *failed, const char *reason) {
+    if (processor->dead_letters == NULL || processor->max_attempts == 0) {
+        return;
+    }
+
+    LogEntry *entry = failed->head;
+    while (entry != NULL) {
+        LogEntry *next = entry->next;
+
+        if (entry->attempts >= processor->max_attempts) {
+            char dead_letter_error[256] = {0};
+            if (dead_letter_write(processor->dead_letters,
+                                  entry,
+                                  reason,
+                                  dead_letter_error,
+                                  sizeof(dead_letter_error))) {
+                logger_log(processor->logger,
+                           LOGGER_ERROR,
+                           "queue_processor",
+                           "dead-lettered log_id=%llu attempts=%u",
+                           (unsigned long long)entry->id,
+                           (unsigned int)entry->attempts);
+                linked_list_remove(failed, entry);
+                buffer_engine_mark_dead_lettered(processor->engine);
+                buffer_engine_release_entry(processor->engine, entry);
+            } else {
+                logger_log(processor->logger,
+                           LOGGER_ERROR,
+                           "queue_processor",
+                           "failed to dead-letter log_id=%llu reason=%s",
+                           (unsigned long long)entry->id,
+                           dead_letter_error);
+            }
+        }
+
+        entry = next;
+    }
+}
+
+void queue_processor_set_adaptive(QueueProcessor *processor, size_t min_size, size_t max_size, double target_ms) {
+    if (processor == NULL || !processor->initialized) {
+        return;
+    }
+
+    processor->batch_min = min_size > 0 ? min_size : 1;
+    processor->batch_max = max_size > processor->batch_min ? max_size : processor->batch_min;
+    processor->batch_target_ms = target_ms > 0.0 ? target_ms : 1.0;
+
+    size_t start = processor->default_batch_size;
+    if (start < processor->batch_min) {
+        start = processor->batch_min;
+    } else if (start > processor->batch_max) {
+        start = processor->batch_max;
+    }
+    atomic_store(&processor->batch_size, start);
+    processor->adaptive = 1;
+
+    logger_log(processor->logger,
+               LOGGER_INFO,
+               "queue_processor",
+               "adaptive batching min=%zu max=%zu start=%zu target_ms=%.1f",
+               processor->batch_min,
+               processor->batch_max,
+               start,
+               processor->batch_target_ms);
+}
+
+size_t queue_processor_batch_size(QueueProcessor *processor) {
+    if (processor == NULL) {
+        return 1;
+    }
+
+    return atomic_load_explicit(&processor->batch_size, memory_order_relaxed);
+}
+
+/* Only batches sized by the controller itself feed it; see QueueProcessor. */
+static void adapt_batch_size(QueueProcessor *processor, size_t limit, size_t taken, int written, double write_ms) {
+    size_t current = atomic_load_explicit(&processor->batch_size, memory_order_relaxed);
+    size_t next = current;
+    do {
+        if (!written || write_ms > processor->batch_target_ms) {
+            next = current / 2;
+        } else if (taken >= limit) {
+            next = current + processor->batch_min;
+        } else {
+            next = current > processor->batch_min ? current - processor->batch_min : processor->batch_min;
+        }
+
+        if (next < processor->batch_min) {
+            next = processor->batch_min;
+        } else if (next > processor->batch_max) {
+            next = processor->batch_max;
+        }
+    } while (next != current &&
+             !atomic_compare_exchange_weak_explicit(
+                 &processor->batch_size, &current, next, memory_order_relaxed, memory_order_relaxed));
+}
+
 int queue_processor_process(QueueProcessor *processor,
                             size_t max_items,
                             size_t *processed_count,
                             double *elapsed_ms,
                             char *error,
                             size_t error_size) {
-    if (processor == NULL || processor->engine == NULL || processor->persistence == NULL) {
+    return queue_processor_process_slot(processor, 0, max_items, processed_count, elapsed_ms, error, error_size);
+}
+
+int queue_processor_process_slot(QueueProcessor *processor,
+                                 size_t slot,
+                                 size_t max_items,
+                                 size_t *processed_count,
+                                 double *elapsed_ms,
+                                 char *error,
+                                 size_t error_size) {
+    if (processor == NULL || !processor->initialized || processor->engine == NULL || processor->sink == NULL) {
         write_error(error, error_size, "Queue processor is not initialized.");
         return 0;
     }
 
-    size_t limit = max_items > 0 ? max_items : processor->default_batch_size;
+    const size_t chosen_size = queue_processor_batch_size(processor);
+    size_t limit = max_items > 0 ? max_items : chosen_size;
     if (limit == 0) {
         limit = 1;
     }
@@ -58,40 +203,84 @@ int queue_processor_process(QueueProcessor *processor,
     const int64_t started_at = log_entry_now_ms();
     size_t processed = 0;
 
-    while (processed < limit) {
-        LogEntry *entry = NULL;
-        if (!buffer_engine_dequeue(processor->engine, &entry)) {
-            break;
+    /* While the sink is known to be down, leave the queue alone instead of churning it. */
+    if (!sink_available(processor->sink)) {
+        if (processed_count != NULL) {
+            *processed_count = 0;
         }
+        if (elapsed_ms != NULL) {
+            *elapsed_ms = 0.0;
+        }
+        write_error(error, error_size, "Sink is unavailable (circuit breaker open).");
+        return 0;
+    }
 
-        int64_t processed_at = log_entry_now_ms();
-        double processing_cost = (double)(processed_at - entry->ingested_at_ms);
+    LinkedList batch;
+    LinkedList failed;
+    linked_list_init(&batch);
+    linked_list_init(&failed);
+    int written = 1;
+    int64_t processed_at = 0;
 
-        if (!persistence_insert_processed_log(processor->persistence,
-                                              entry,
-                                              processed_at,
-                                              processing_cost,
-                                              error,
-                                              error_size)) {
-            buffer_engine_mark_error(processor->engine);
+    void *reservation = NULL;
+    if (processor->sink->ordered) {
+        pthread_mutex_lock(&processor->dispatch_mutex);
+        if (buffer_engine_dequeue_batch(processor->engine, limit, &batch) > 0) {
+            reservation = sink_reserve(processor->sink, &batch);
+        }
+        pthread_mutex_unlock(&processor->dispatch_mutex);
+    } else {
+        buffer_engine_dequeue_batch(processor->engine, limit, &batch);
+    }
 
-            char requeue_error[256] = {0};
-            if (!buffer_engine_requeue_front(processor->engine, entry, requeue_error, sizeof(requeue_error))) {
-                logger_log(processor->logger,
-                           LOGGER_ERROR,
-                           "queue_processor",
-                           "failed to requeue log_id=%llu reason=%s",
-                           (unsigned long long)entry->id,
-                           requeue_error);
-                free(entry);
-            }
+    const size_t batch_size = linked_list_size(&batch);
+    processed_at = log_entry_now_ms();
+    record_since_ingest(processor->engine, ENGINE_LATENCY_QUEUE_WAIT, &batch, processed_at);
 
-            return 0;
+    /* An empty batch (another worker won the race, or the queue ran dry) never reaches the sink. */
+    if (batch_size > 0) {
+        const uint64_t write_started_us = monotonic_us();
+        written = sink_write_batch(processor->sink, slot, reservation, &batch, processed_at, &failed, error, error_size);
+        const uint64_t write_us = monotonic_us() - write_started_us;
+        buffer_engine_record_latency(processor->engine, ENGINE_LATENCY_PERSIST_BATCH, write_us, 1);
+        buffer_engine_record_latency(processor->engine, ENGINE_LATENCY_PERSIST_ROW, write_us / batch_size, batch_size);
+        if (processor->adaptive && limit == chosen_size) {
+            adapt_batch_size(processor, limit, batch_size, written, (double)write_us / 1000.0);
         }
+    }
+
+    /* Stored entries are what is left in `batch`; one metrics update covers them all. */
+    processed = linked_list_size(&batch);
+    if (processed > 0) {
+        record_since_ingest(processor->engine, ENGINE_LATENCY_END_TO_END, &batch, log_entry_now_ms());
+        buffer_engine_mark_processed_batch(processor->engine,
+                                           processed,
+                                           (double)(processed_at - batch.tail->ingested_at_ms));
+        buffer_engine_release_batch(processor->engine, &batch);
+    }
+
+    int requeued = 0;
+    if (failed.head != NULL) {
+        for (size_t i = 0; i < linked_list_size(&failed); ++i) {
+            buffer_engine_mark_error(processor->engine);
+        }
+
+        divert_dead_letters(processor, &failed, error);
 
-        free(entry);
-        buffer_engine_mark_processed(processor->engine, processing_cost);
-        processed++;
+        /* Entries that were not stored go back to the head, in their original order. */
+        char requeue_error[256] = {0};
+        requeued = failed.head != NULL;
+        if (requeued &&
+            !buffer_engine_requeue_front_batch(processor->engine, &failed, requeue_error, sizeof(requeue_error))) {
+            logger_log(processor->logger,
+                       LOGGER_ERROR,
+                       "queue_processor",
+                       "dropping %zu entries starting at log_id=%llu that could not be requeued: %s",
+                       linked_list_size(&failed),
+                       (unsigned long long)failed.head->id,
+                       requeue_error);
+            buffer_engine_drop_batch(processor->engine, &failed);
+        }
     }
 
     const int64_t finished_at = log_entry_now_ms();
@@ -108,7 +297,7 @@ int queue_processor_process(QueueProcessor *processor,
     EngineMetrics metrics;
     if (processed > 0 && buffer_engine_get_metrics(processor->engine, &metrics)) {
         char metric_error[256] = {0};
-        if (!persistence_insert_metrics(processor->persistence, &metrics, metric_error, sizeof(metric_error))) {
+        if (!sink_record_metrics(processor->sink, &metrics, metric_error, sizeof(metric_error))) {
             buffer_engine_mark_error(processor->engine);
             logger_log(processor->logger,
                        LOGGER_ERROR,
@@ -118,5 +307,15 @@ int queue_processor_process(QueueProcessor *processor,
         }
     }
 
-    return 1;
+    /* A batch whose only failures were dead-lettered still moved the queue forward. */
+    return written || !requeued;
+}
+
+void queue_processor_shutdown(QueueProcessor *processor) {
+    if (processor == NULL || !processor->initialized) {
+        return;
+    }
+
+    pthread_mutex_destroy(&processor->dispatch_mutex);
+    processor->initialized = 0;
 }
@@ -0,0 +1,90 @@
+#include "ring_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int ring_queue_init(RingQueue *ring, size_t capacity) {
+    if (ring == NULL || capacity == 0) {
+        return 0;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = (LogEntry **)calloc(capacity, sizeof(LogEntry *));
+    if (ring->slots == NULL) {
+        return 0;
+    }
+
+    ring->capacity = capacity;
+    return 1;
+}
+
+void ring_queue_destroy(RingQueue *ring) {
+    if (ring == NULL) {
+        return;
+    }
+
+    free(ring->slots);
+    memset(ring, 0, sizeof(*ring));
+}
+
+int ring_queue_push_back(RingQueue *ring, LogEntry *entry) {
+    if (ring == NULL || entry == NULL || ring->size >= ring->capacity) {
+        return 0;
+    }
+
+    size_t tail = ring->head + ring->size;
+    if (tail >= ring->capacity) {
+        tail -= ring->capacity;
+    }
+
+    ring->slots[tail] = entry;
+    ring->size++;
+    return 1;
+}
+
+int ring_queue_push_front(RingQueue *ring, LogEntry *entry) {
+    if (ring == NULL || entry == NULL || ring->size >= ring->capacity) {
+        return 0;
+    }
+
+    ring->head = ring->head == 0 ? ring->capacity - 1 : ring->head - 1;
+    ring->slots[ring->head] = entry;
+    ring->size++;
+    return 1;
+}
+
+LogEntry *ring_queue_pop_front(RingQueue *ring) {
+    if (ring == NULL || ring->size == 0) {
+        return NULL;
+    }
+
+    LogEntry *entry = ring->slots[ring->head];
+    ring->slots[ring->head] = NULL;
+    ring->head++;
+    if (ring->head == ring->capacity) {
+        ring->head = 0;
+    }
+    ring->size--;
+    return entry;
+}
+
+LogEntry *ring_queue_at(const RingQueue *ring, size_t index) {
+    if (ring == NULL || index >= ring->size) {
+        return NULL;
+    }
+
+    size_t position = ring->head + index;
+    if (position >= ring->capacity) {
+        position -= ring->capacity;
+    }
+
+    return ring->slots[position];
+}
+
+size_t ring_queue_size(const RingQueue *ring) {
+    if (ring == NULL) {
+        return 0;
+    }
+
+    return ring->size;
+}
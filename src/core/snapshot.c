@@ -0,0 +1,268 @@
+#include "snapshot.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SNAPSHOT_MAGIC "LGSNAP1\n"
+#define SNAPSHOT_MAGIC_SIZE 8
+#define SNAPSHOT_FRAME_HEADER_SIZE 4
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static void put_u32(unsigned char *out, uint32_t value) {
+    out[0] = (unsigned char)(value & 0xffu);
+    out[1] = (unsigned char)((value >> 8) & 0xffu);
+    out[2] = (unsigned char)((value >> 16) & 0xffu);
+    out[3] = (unsigned char)((value >> 24) & 0xffu);
+}
+
+static uint32_t get_u32(const unsigned char *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static int write_batch(FILE *file, const LinkedList *batch, unsigned char *frame) {
+    for (const LogEntry *entry = batch->head; entry != NULL; entry = entry->next) {
+        size_t payload = log_entry_serialize(entry, frame + SNAPSHOT_FRAME_HEADER_SIZE, LOG_ENTRY_RECORD_MAX_SIZE);
+        if (payload == 0) {
+            return 0;
+        }
+
+        put_u32(frame, (uint32_t)payload);
+        if (fwrite(frame, 1, SNAPSHOT_FRAME_HEADER_SIZE + payload, file) != SNAPSHOT_FRAME_HEADER_SIZE + payload) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Copies whole frames from `in` to `out` until the end of `in`, counting
+ * them. A torn frame at the end was never a whole record and is not copied.
+ */
+static int copy_frames(FILE *in, FILE *out, unsigned char *frame, size_t *copied) {
+    unsigned char header[SNAPSHOT_FRAME_HEADER_SIZE];
+    while (fread(header, 1, sizeof(header), in) == sizeof(header)) {
+        uint32_t payload = get_u32(header);
+        if (payload == 0 || payload > LOG_ENTRY_RECORD_MAX_SIZE || fread(frame, 1, payload, in) != payload) {
+            break;
+        }
+        if (fwrite(header, 1, sizeof(header), out) != sizeof(header) || fwrite(frame, 1, payload, out) != payload) {
+            return 0;
+        }
+        (*copied)++;
+    }
+    return 1;
+}
+
+/*
+ * Appends the records of a snapshot still on disk at `path` (left there by a
+ * start that could not load all of it), so writing a new one never loses them.
+ */
+static int carry_over(const char *path, FILE *out, unsigned char *frame, size_t *copied) {
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) {
+        return errno == ENOENT;
+    }
+
+    unsigned char magic[SNAPSHOT_MAGIC_SIZE];
+    int ok = fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+             memcmp(magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE) == 0 && copy_frames(in, out, frame, copied);
+    fclose(in);
+    return ok;
+}
+
+int snapshot_write(const char *path,
+                   BufferEngine *engine,
+                   size_t batch_size,
+                   size_t *written_count,
+                   char *error,
+                   size_t error_size) {
+    if (written_count != NULL) {
+        *written_count = 0;
+    }
+    if (path == NULL || path[0] == '\0' || engine == NULL) {
+        write_error(error, error_size, "Invalid snapshot arguments.");
+        return 0;
+    }
+
+    char tmp_path[320];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    unsigned char *frame = malloc(SNAPSHOT_FRAME_HEADER_SIZE + LOG_ENTRY_RECORD_MAX_SIZE);
+    FILE *file = frame != NULL ? fopen(tmp_path, "wb") : NULL;
+    if (file == NULL) {
+        free(frame);
+        write_error(error, error_size, "Unable to create snapshot file.");
+        return 0;
+    }
+
+    int ok = fwrite(SNAPSHOT_MAGIC, 1, SNAPSHOT_MAGIC_SIZE, file) == SNAPSHOT_MAGIC_SIZE;
+    LinkedList batch;
+    LinkedList written;
+    linked_list_init(&batch);
+    linked_list_init(&written);
+
+    /*
+     * Written batches are held until the file is in place. Detaching them
+     * lets spilled entries page back in behind them meanwhile.
+     */
+    while (ok && buffer_engine_dequeue_batch(engine, batch_size > 0 ? batch_size : 1, &batch) > 0) {
+        ok = write_batch(file, &batch, frame);
+        if (ok) {
+            buffer_engine_detach_batch(engine, &batch);
+            linked_list_append_list(&written, &batch);
+        }
+    }
+
+    size_t carried = 0;
+    ok = ok && carry_over(path, file, frame, &carried);
+    free(frame);
+
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    ok = ok && rename(tmp_path, path) == 0;
+
+    size_t written_total = linked_list_size(&written) + carried;
+    buffer_engine_reattach_batch(engine, &written);
+
+    if (!ok) {
+        /* Everything dequeued goes back ahead of what is still queued. */
+        linked_list_append_list(&written, &batch);
+        if (!buffer_engine_requeue_front_batch(engine, &written, NULL, 0)) {
+            buffer_engine_drop_batch(engine, &written);
+        }
+        unlink(tmp_path);
+        write_error(error, error_size, "Failed to write snapshot file.");
+        return 0;
+    }
+
+    buffer_engine_release_batch(engine, &written);
+    if (written_count != NULL) {
+        *written_count = written_total;
+    }
+    return 1;
+}
+
+/*
+ * Rewrites `path` with the frame that did not fit (still in `frame`) and
+ * every frame after it in `file`, through a temporary file and a rename.
+ */
+static int keep_remainder(FILE *file,
+                          const char *path,
+                          unsigned char *frame,
+                          uint32_t payload,
+                          size_t *kept_count) {
+    char tmp_path[320];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *out = fopen(tmp_path, "wb");
+    if (out == NULL) {
+        return 0;
+    }
+
+    unsigned char header[SNAPSHOT_FRAME_HEADER_SIZE];
+    put_u32(header, payload);
+    size_t kept = 1;
+    int ok = fwrite(SNAPSHOT_MAGIC, 1, SNAPSHOT_MAGIC_SIZE, out) == SNAPSHOT_MAGIC_SIZE &&
+             fwrite(header, 1, sizeof(header), out) == sizeof(header) && fwrite(frame, 1, payload, out) == payload &&
+             copy_frames(file, out, frame, &kept);
+
+    ok = ok && fflush(out) == 0 && fsync(fileno(out)) == 0;
+    ok = fclose(out) == 0 && ok;
+    ok = ok && rename(tmp_path, path) == 0;
+    if (!ok) {
+        unlink(tmp_path);
+        return 0;
+    }
+
+    *kept_count = kept;
+    return 1;
+}
+
+int snapshot_load(const char *path,
+                  SnapshotRestoreFn restore,
+                  void *context,
+                  size_t *loaded_count,
+                  size_t *kept_count,
+                  char *error,
+                  size_t error_size) {
+    if (loaded_count != NULL) {
+        *loaded_count = 0;
+    }
+    size_t kept = 0;
+    if (kept_count != NULL) {
+        *kept_count = 0;
+    }
+    if (path == NULL || path[0] == '\0' || restore == NULL) {
+        write_error(error, error_size, "Invalid snapshot arguments.");
+        return 0;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        if (errno == ENOENT) {
+            return 1;
+        }
+        write_error(error, error_size, "Unable to open snapshot file.");
+        return 0;
+    }
+
+    unsigned char *frame = malloc(LOG_ENTRY_RECORD_MAX_SIZE);
+    unsigned char magic[SNAPSHOT_MAGIC_SIZE];
+    if (frame == NULL || fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE) != 0) {
+        free(frame);
+        fclose(file);
+        write_error(error, error_size, "Snapshot file is not a buffer snapshot.");
+        return 0;
+    }
+
+    size_t loaded = 0;
+    int ok = 1;
+    for (;;) {
+        unsigned char header[SNAPSHOT_FRAME_HEADER_SIZE];
+        size_t got = fread(header, 1, sizeof(header), file);
+        if (got == 0 && feof(file)) {
+            break;
+        }
+
+        uint32_t payload = got == sizeof(header) ? get_u32(header) : 0;
+        LogEntryRecord record;
+        if (payload == 0 || payload > LOG_ENTRY_RECORD_MAX_SIZE || fread(frame, 1, payload, file) != payload ||
+            log_entry_deserialize(frame, payload, &record) != payload) {
+            write_error(error, error_size, "Snapshot file is corrupt.");
+            ok = 0;
+            break;
+        }
+
+        if (!restore(context, &record)) {
+            if (!keep_remainder(file, path, frame, payload, &kept)) {
+                write_error(error, error_size, "Unable to write back the snapshot entries that did not fit.");
+                ok = 0;
+            }
+            break;
+        }
+        loaded++;
+    }
+    free(frame);
+    fclose(file);
+
+    if (loaded_count != NULL) {
+        *loaded_count = loaded;
+    }
+    if (kept_count != NULL) {
+        *kept_count = kept;
+    }
+    if (ok && kept == 0 && unlink(path) != 0) {
+        write_error(error, error_size, "Unable to remove loaded snapshot file.");
+        return 0;
+    }
+    return ok;
+}
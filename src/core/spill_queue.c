@@ -0,0 +1,350 @@
+#include "spill_queue.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SPILL_FRAME_HEADER_SIZE 8
+#define SPILL_SEGMENT_PREFIX "spill-"
+#define SPILL_SEGMENT_SUFFIX ".seg"
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static void put_u32(unsigned char *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void segment_path(const SpillQueue *spill, uint32_t seq, char *path, size_t path_size) {
+    snprintf(path, path_size, "%s/" SPILL_SEGMENT_PREFIX "%010u" SPILL_SEGMENT_SUFFIX, spill->dir, seq);
+}
+
+static int is_segment_name(const char *name) {
+    size_t prefix_len = strlen(SPILL_SEGMENT_PREFIX);
+    size_t suffix_len = strlen(SPILL_SEGMENT_SUFFIX);
+    size_t len = strlen(name);
+    return len > prefix_len + suffix_len && strncmp(name, SPILL_SEGMENT_PREFIX, prefix_len) == 0 &&
+           strcmp(name + len - suffix_len, SPILL_SEGMENT_SUFFIX) == 0;
+}
+
+static void remove_leftovers(SpillQueue *spill) {
+    DIR *handle = opendir(spill->dir);
+    if (handle == NULL) {
+        return;
+    }
+
+    struct dirent *item = NULL;
+    while ((item = readdir(handle)) != NULL) {
+        if (is_segment_name(item->d_name)) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", spill->dir, item->d_name);
+            unlink(path);
+        }
+    }
+    closedir(handle);
+}
+
+static unsigned char *map_segment(SpillQueue *spill, uint32_t seq, int create) {
+    char path[320];
+    segment_path(spill, seq, path, sizeof(path));
+
+    int fd = open(path, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    /*
+     * Reserve real blocks up front: a store into a sparse page of a shared
+     * mapping raises SIGBUS when the disk is full, so running out of space
+     * must surface here, as a push error, instead.
+     */
+    if (create && posix_fallocate(fd, 0, (off_t)spill->segment_bytes) != 0) {
+        close(fd);
+        unlink(path);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, spill->segment_bytes, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        if (create) {
+            unlink(path);
+        }
+        return NULL;
+    }
+
+    return (unsigned char *)map;
+}
+
+/* Seals the write tail (unmapping it unless the reader shares it) and starts a new one. Mutex held. */
+static int open_write_segment(SpillQueue *spill) {
+    if (spill->segment_count == spill->segment_capacity) {
+        size_t capacity = spill->segment_capacity == 0 ? 8 : spill->segment_capacity * 2;
+        SpillSegment *grown = (SpillSegment *)realloc(spill->segments, capacity * sizeof(SpillSegment));
+        if (grown == NULL) {
+            return 0;
+        }
+        spill->segments = grown;
+        spill->segment_capacity = capacity;
+    }
+
+    unsigned char *map = map_segment(spill, spill->next_seq, 1);
+    if (map == NULL) {
+        return 0;
+    }
+
+    if (spill->write_map != NULL && spill->write_map != spill->read_map) {
+        munmap(spill->write_map, spill->segment_bytes);
+    }
+
+    spill->write_map = map;
+    spill->segments[spill->segment_count].seq = spill->next_seq++;
+    spill->segments[spill->segment_count].used = 0;
+    spill->segment_count++;
+    return 1;
+}
+
+/* Drops the fully read head segment. Mutex held; only called while a newer segment exists. */
+static void retire_head(SpillQueue *spill) {
+    if (spill->read_map != NULL && spill->read_map != spill->write_map) {
+        munmap(spill->read_map, spill->segment_bytes);
+    }
+
+    char path[320];
+    segment_path(spill, spill->segments[0].seq, path, sizeof(path));
+    unlink(path);
+
+    memmove(&spill->segments[0], &spill->segments[1], (spill->segment_count - 1) * sizeof(SpillSegment));
+    spill->segment_count--;
+    spill->read_map = NULL;
+    spill->read_offset = 0;
+}
+
+int spill_queue_open(SpillQueue *spill,
+                     const char *dir,
+                     size_t segment_bytes,
+                     size_t max_bytes,
+                     AppLogger *logger,
+                     char *error,
+                     size_t error_size) {
+    if (spill == NULL || dir == NULL || dir[0] == '\0') {
+        write_error(error, error_size, "Invalid spill queue arguments.");
+        return 0;
+    }
+
+    memset(spill, 0, sizeof(*spill));
+    snprintf(spill->dir, sizeof(spill->dir), "%s", dir);
+
+    /* Every segment must hold at least one maximal record. */
+    size_t minimum = SPILL_FRAME_HEADER_SIZE + LOG_ENTRY_RECORD_MAX_SIZE;
+    spill->segment_bytes = segment_bytes < minimum ? minimum : segment_bytes;
+    spill->max_bytes = max_bytes;
+    spill->next_seq = 1;
+    spill->logger = logger;
+
+    if (mkdir(spill->dir, 0755) != 0 && errno != EEXIST) {
+        write_error(error, error_size, "Unable to create spill directory.");
+        return 0;
+    }
+    remove_leftovers(spill);
+
+    if (pthread_mutex_init(&spill->mutex, NULL) != 0) {
+        write_error(error, error_size, "Failed to initialize spill mutex.");
+        return 0;
+    }
+
+    atomic_init(&spill->entries, 0);
+    atomic_init(&spill->spilled_total, 0);
+    atomic_init(&spill->spilled_bytes_total, 0);
+    atomic_init(&spill->paged_in_total, 0);
+    atomic_init(&spill->paged_in_bytes_total, 0);
+    spill->initialized = 1;
+
+    logger_log(logger,
+               LOGGER_INFO,
+               "spill_queue",
+               "opened dir=%s segment_bytes=%zu max_bytes=%zu",
+               spill->dir,
+               spill->segment_bytes,
+               spill->max_bytes);
+    return 1;
+}
+
+int spill_queue_push(SpillQueue *spill, const LogEntry *entry, char *error, size_t error_size) {
+    if (spill == NULL || !spill->initialized || entry == NULL) {
+        write_error(error, error_size, "Spill queue is not initialized.");
+        return 0;
+    }
+
+    size_t payload = log_entry_serialized_size(entry);
+    size_t frame = SPILL_FRAME_HEADER_SIZE + payload;
+
+    pthread_mutex_lock(&spill->mutex);
+
+    if (spill->max_bytes > 0 && spill->bytes + frame > spill->max_bytes) {
+        pthread_mutex_unlock(&spill->mutex);
+        write_error(error, error_size, "Buffer capacity reached and spill limit exceeded.");
+        return 0;
+    }
+
+    if (spill->segment_count == 0 ||
+        spill->segments[spill->segment_count - 1].used + frame > spill->segment_bytes) {
+        if (!open_write_segment(spill)) {
+            pthread_mutex_unlock(&spill->mutex);
+            write_error(error, error_size, "Unable to create spill segment.");
+            return 0;
+        }
+    }
+
+    SpillSegment *tail = &spill->segments[spill->segment_count - 1];
+    unsigned char *out = spill->write_map + tail->used;
+    put_u32(out, entry->journal_segment);
+    put_u32(out + 4, (uint32_t)payload);
+    log_entry_serialize(entry, out + SPILL_FRAME_HEADER_SIZE, payload);
+    tail->used += frame;
+    spill->bytes += frame;
+    atomic_fetch_add_explicit(&spill->entries, 1, memory_order_release);
+
+    pthread_mutex_unlock(&spill->mutex);
+
+    atomic_fetch_add_explicit(&spill->spilled_total, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&spill->spilled_bytes_total, frame, memory_order_relaxed);
+    return 1;
+}
+
+/*
+ * Copies the oldest record into `buffer` (at least LOG_ENTRY_RECORD_MAX_SIZE
+ * bytes) and points `record` into it. Returns 0 when nothing is spilled, and
+ * -1 when the frame was taken but does not decode; `journal_segment` is set
+ * either way so the caller can release it.
+ */
+int spill_queue_pop(SpillQueue *spill,
+                    unsigned char *buffer,
+                    size_t buffer_size,
+                    LogEntryRecord *record,
+                    uint32_t *journal_segment) {
+    if (spill == NULL || !spill->initialized || buffer == NULL || record == NULL ||
+        atomic_load_explicit(&spill->entries, memory_order_acquire) == 0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&spill->mutex);
+
+    while (spill->segment_count > 1 && spill->read_offset >= spill->segments[0].used) {
+        retire_head(spill);
+    }
+
+    if (spill->segment_count == 0 || spill->read_offset >= spill->segments[0].used) {
+        pthread_mutex_unlock(&spill->mutex);
+        return 0;
+    }
+
+    if (spill->read_map == NULL) {
+        spill->read_map = spill->segment_count == 1 ? spill->write_map : map_segment(spill, spill->segments[0].seq, 0);
+        if (spill->read_map == NULL) {
+            pthread_mutex_unlock(&spill->mutex);
+            logger_log(spill->logger, LOGGER_ERROR, "spill_queue", "unable to map spill segment %u", spill->segments[0].seq);
+            return 0;
+        }
+    }
+
+    const unsigned char *frame = spill->read_map + spill->read_offset;
+    uint32_t segment = get_u32(frame);
+    size_t payload = get_u32(frame + 4);
+    if (payload > buffer_size) {
+        pthread_mutex_unlock(&spill->mutex);
+        return 0;
+    }
+
+    memcpy(buffer, frame + SPILL_FRAME_HEADER_SIZE, payload);
+    spill->read_offset += SPILL_FRAME_HEADER_SIZE + payload;
+    spill->bytes -= SPILL_FRAME_HEADER_SIZE + payload;
+    atomic_fetch_sub_explicit(&spill->entries, 1, memory_order_release);
+
+    /* Let go of a finished segment right away rather than on the next pop. */
+    if (spill->segment_count > 1 && spill->read_offset >= spill->segments[0].used) {
+        retire_head(spill);
+    }
+
+    pthread_mutex_unlock(&spill->mutex);
+
+    atomic_fetch_add_explicit(&spill->paged_in_total, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&spill->paged_in_bytes_total, SPILL_FRAME_HEADER_SIZE + payload, memory_order_relaxed);
+
+    if (journal_segment != NULL) {
+        *journal_segment = segment;
+    }
+    return log_entry_deserialize(buffer, payload, record) == payload ? 1 : -1;
+}
+
+size_t spill_queue_size(SpillQueue *spill) {
+    if (spill == NULL || !spill->initialized) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&spill->entries, memory_order_acquire);
+}
+
+void spill_queue_get_stats(SpillQueue *spill, SpillStats *out_stats) {
+    if (out_stats == NULL) {
+        return;
+    }
+
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (spill == NULL || !spill->initialized) {
+        return;
+    }
+
+    pthread_mutex_lock(&spill->mutex);
+    out_stats->bytes = spill->bytes;
+    out_stats->segments = spill->segment_count;
+    pthread_mutex_unlock(&spill->mutex);
+
+    out_stats->entries = atomic_load_explicit(&spill->entries, memory_order_acquire);
+    out_stats->spilled_total = atomic_load_explicit(&spill->spilled_total, memory_order_relaxed);
+    out_stats->spilled_bytes_total = atomic_load_explicit(&spill->spilled_bytes_total, memory_order_relaxed);
+    out_stats->paged_in_total = atomic_load_explicit(&spill->paged_in_total, memory_order_relaxed);
+    out_stats->paged_in_bytes_total = atomic_load_explicit(&spill->paged_in_bytes_total, memory_order_relaxed);
+}
+
+/* Whatever is still spilled is discarded along with its files. */
+void spill_queue_close(SpillQueue *spill) {
+    if (spill == NULL || !spill->initialized) {
+        return;
+    }
+
+    if (spill->read_map != NULL && spill->read_map != spill->write_map) {
+        munmap(spill->read_map, spill->segment_bytes);
+    }
+    if (spill->write_map != NULL) {
+        munmap(spill->write_map, spill->segment_bytes);
+    }
+
+    for (size_t i = 0; i < spill->segment_count; ++i) {
+        char path[320];
+        segment_path(spill, spill->segments[i].seq, path, sizeof(path));
+        unlink(path);
+    }
+
+    pthread_mutex_destroy(&spill->mutex);
+    free(spill->segments);
+    spill->segments = NULL;
+    spill->read_map = NULL;
+    spill->write_map = NULL;
+    spill->initialized = 0;
+}
@@ -0,0 +1,112 @@
+#include "dead_letter.h"
+
+#include <string.h>
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static void write_json_string(FILE *file, const char *text) {
+    fputc('"', file);
+
+    for (const unsigned char *cursor = (const unsigned char *)text; *cursor != '\0'; ++cursor) {
+        switch (*cursor) {
+            case '\\':
+                fputs("\\\\", file);
+                break;
+            case '"':
+                fputs("\\\"", file);
+                break;
+            case '\n':
+                fputs("\\n", file);
+                break;
+            case '\r':
+                fputs("\\r", file);
+                break;
+            case '\t':
+                fputs("\\t", file);
+                break;
+            default:
+                if (*cursor < 0x20) {
+                    fprintf(file, "\\u%04x", *cursor);
+                } else {
+                    fputc(*cursor, file);
+                }
+                break;
+        }
+    }
+
+    fputc('"', file);
+}
+
+int dead_letter_open(DeadLetterStore *store, const char *path, char *error, size_t error_size) {
+    if (store == NULL || path == NULL || path[0] == '\0') {
+        write_error(error, error_size, "Invalid dead-letter store arguments.");
+        return 0;
+    }
+
+    memset(store, 0, sizeof(*store));
+    snprintf(store->path, sizeof(store->path), "%s", path);
+
+    store->file = fopen(store->path, "a");
+    if (store->file == NULL) {
+        write_error(error, error_size, "Unable to open dead-letter file.");
+        return 0;
+    }
+
+    if (pthread_mutex_init(&store->mutex, NULL) != 0) {
+        fclose(store->file);
+        store->file = NULL;
+        write_error(error, error_size, "Failed to initialize dead-letter mutex.");
+        return 0;
+    }
+
+    store->initialized = 1;
+    return 1;
+}
+
+/* One line per entry; flushed before returning so a crash cannot lose it after release. */
+int dead_letter_write(DeadLetterStore *store, const LogEntry *entry, const char *reason, char *error, size_t error_size) {
+    if (store == NULL || !store->initialized || entry == NULL) {
+        write_error(error, error_size, "Dead-letter store is not initialized.");
+        return 0;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+
+    fprintf(store->file,
+            "{\"id\":%llu,\"ingested_at_ms\":%lld,\"dead_lettered_at_ms\":%lld,\"attempts\":%u,\"level\":",
+            (unsigned long long)entry->id,
+            (long long)entry->ingested_at_ms,
+            (long long)log_entry_now_ms(),
+            (unsigned int)entry->attempts);
+    write_json_string(store->file, log_entry_level(entry));
+    fputs(",\"source\":", store->file);
+    write_json_string(store->file, log_entry_source(entry));
+    fputs(",\"message\":", store->file);
+    write_json_string(store->file, log_entry_message(entry));
+    fputs(",\"reason\":", store->file);
+    write_json_string(store->file, reason != NULL ? reason : "");
+    fputs("}\n", store->file);
+
+    int ok = fflush(store->file) == 0 && !ferror(store->file);
+    pthread_mutex_unlock(&store->mutex);
+
+    if (!ok) {
+        write_error(error, error_size, "Failed to write dead-letter entry.");
+    }
+    return ok;
+}
+
+void dead_letter_close(DeadLetterStore *store) {
+    if (store == NULL || !store->initialized) {
+        return;
+    }
+
+    fclose(store->file);
+    store->file = NULL;
+    pthread_mutex_destroy(&store->mutex);
+    store->initialized = 0;
+}
@@ -1,7 +1,27 @@
 #include "persistence.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+
+#define COPY_CHUNK_BYTES 32768
+/* Seconds between the Unix epoch and the PostgreSQL epoch (2000-01-01 UTC). */
+#define PG_EPOCH_OFFSET_S 946684800LL
+
+/* Built-in type OIDs used when preparing statements (see pg_type.dat). */
+#define PG_OID_INT8 20
+#define PG_OID_TEXT 25
+#define PG_OID_FLOAT8 701
+#define PG_OID_TIMESTAMPTZ 1184
+
+#define STMT_INSERT_PROCESSED_LOG "insert_processed_log"
+#define STMT_INSERT_METRICS "insert_metrics"
+
+typedef struct {
+    unsigned char data[COPY_CHUNK_BYTES];
+    size_t used;
+} CopyChunk;
 
 static void write_error(char *error, size_t error_size, const char *message) {
     if (error != NULL && error_size > 0) {
@@ -9,16 +29,30 @@ static void write_error(char *error, size_t error_size, const char *message) {
     }
 }
 
-static int exec_command(Persistence *persistence, const char *sql, char *error, size_t error_size) {
-    PGresult *result = PQexec(persistence->conn, sql);
+/*
+ * Records why the server rejected a statement. Only data exceptions (class
+ * 22) and constraint violations (class 23) are the rows' fault; anything
+ * else would fail every row alike, so it must not count against them.
+ */
+static void note_rejection(PersistenceConnection *connection, const PGresult *result) {
+    const char *sqlstate = result != NULL ? PQresultErrorField(result, PG_DIAG_SQLSTATE) : NULL;
+    if (sqlstate == NULL || (strncmp(sqlstate, "22", 2) != 0 && strncmp(sqlstate, "23", 2) != 0)) {
+        connection->refused = 1;
+    }
+}
+
+static int exec_command(PersistenceConnection *connection, const char *sql, char *error, size_t error_size) {
+    PGresult *result = PQexec(connection->conn, sql);
     if (result == NULL) {
+        note_rejection(connection, NULL);
         write_error(error, error_size, "PQexec returned NULL result.");
         return 0;
     }
 
     ExecStatusType status = PQresultStatus(result);
     if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK) {
-        write_error(error, error_size, PQerrorMessage(persistence->conn));
+        note_rejection(connection, result);
+        write_error(error, error_size, PQerrorMessage(connection->conn));
         PQclear(result);
         return 0;
     }
@@ -27,29 +61,94 @@ static int exec_command(Persistence *persistence, const char *sql, char *error,
     return 1;
 }
 
-int persistence_init(Persistence *persistence, const AppConfig *config, AppLogger *logger, char *error, size_t error_size) {
-    if (persistence == NULL || config == NULL) {
-        write_error(error, error_size, "Invalid persistence initialization arguments.");
+static int prepare_statement(PersistenceConnection *connection,
+                             const char *name,
+                             const char *sql,
+                             int param_count,
+                             const Oid *param_types,
+                             char *error,
+                             size_t error_size) {
+    PGresult *result = PQprepare(connection->conn, name, sql, param_count, param_types);
+    if (result == NULL) {
+        write_error(error, error_size, "PQprepare returned NULL result.");
         return 0;
     }
 
-    memset(persistence, 0, sizeof(*persistence));
-    persistence->logger = logger;
-
-    char conninfo[512] = {0};
-    if (!config_build_conninfo(config, conninfo, sizeof(conninfo))) {
-        write_error(error, error_size, "Failed to build PostgreSQL conninfo.");
+    if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+        write_error(error, error_size, PQerrorMessage(connection->conn));
+        PQclear(result);
         return 0;
     }
 
-    persistence->conn = PQconnectdb(conninfo);
-    if (persistence->conn == NULL || PQstatus(persistence->conn) != CONNECTION_OK) {
+    PQclear(result);
+    return 1;
+}
+
+/* Statements are planned once per connection and reused by every insert. */
+static int prepare_statements(PersistenceConnection *connection, char *error, size_t error_size) {
+    static const Oid log_types[7] = {
+        PG_OID_INT8,
+        PG_OID_TEXT,
+        PG_OID_TEXT,
+        PG_OID_TEXT,
+        PG_OID_TIMESTAMPTZ,
+        PG_OID_TIMESTAMPTZ,
+        PG_OID_FLOAT8,
+    };
+    static const Oid metrics_types[7] = {
+        PG_OID_INT8,
+        PG_OID_INT8,
+        PG_OID_INT8,
+        PG_OID_INT8,
+        PG_OID_INT8,
+        PG_OID_INT8,
+        PG_OID_FLOAT8,
+    };
+
+    const char *log_sql =
+        "INSERT INTO processed_logs "
+        "(log_id, level, source, message, ingested_at, processed_at, processing_ms) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7)";
+    const char *metrics_sql =
+        "INSERT INTO processing_metrics "
+        "(total_ingested, total_processed, total_errors, queue_depth, buffer_capacity, memory_bytes, last_processing_ms) "
+        "VALUES ($1, $2, $3, $4, $5, $6, $7)";
+
+    return prepare_statement(connection, STMT_INSERT_PROCESSED_LOG, log_sql, 7, log_types, error, error_size) &&
+           prepare_statement(connection, STMT_INSERT_METRICS, metrics_sql, 7, metrics_types, error, error_size);
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL);
+}
+
+static void close_connections(Persistence *persistence, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        PersistenceConnection *connection = &persistence->connections[i];
+        if (connection->conn != NULL) {
+            PQfinish(connection->conn);
+            connection->conn = NULL;
+        }
+        pthread_cond_destroy(&connection->turn);
+        pthread_mutex_destroy(&connection->mutex);
+    }
+}
+
+static int open_connection(PersistenceConnection *connection,
+                           const char *conninfo,
+                           int create_schema,
+                           char *error,
+                           size_t error_size) {
+    connection->conn = PQconnectdb(conninfo);
+    if (connection->conn == NULL || PQstatus(connection->conn) != CONNECTION_OK) {
         write_error(error,
                     error_size,
-                    persistence->conn != NULL ? PQerrorMessage(persistence->conn) : "PQconnectdb failed.");
-        if (persistence->conn != NULL) {
-            PQfinish(persistence->conn);
-            persistence->conn = NULL;
+                    connection->conn != NULL ? PQerrorMessage(connection->conn) : "PQconnectdb failed.");
+        if (connection->conn != NULL) {
+            PQfinish(connection->conn);
+            connection->conn = NULL;
         }
         return 0;
     }
@@ -77,31 +176,401 @@ int persistence_init(Persistence *persistence, const AppConfig *config, AppLogge
         " last_processing_ms DOUBLE PRECISION NOT NULL"
         ");";
 
-    if (!exec_command(persistence, schema_sql, error, error_size)) {
-        PQfinish(persistence->conn);
-        persistence->conn = NULL;
+    if ((create_schema && !exec_command(connection, schema_sql, error, error_size)) ||
+        !prepare_statements(connection, error, error_size)) {
+        PQfinish(connection->conn);
+        connection->conn = NULL;
+        return 0;
+    }
+
+    if (pthread_mutex_init(&connection->mutex, NULL) != 0) {
+        write_error(error, error_size, "Failed to initialize persistence mutex.");
+        PQfinish(connection->conn);
+        connection->conn = NULL;
+        return 0;
+    }
+
+    if (pthread_cond_init(&connection->turn, NULL) != 0) {
+        write_error(error, error_size, "Failed to initialize persistence condition.");
+        pthread_mutex_destroy(&connection->mutex);
+        PQfinish(connection->conn);
+        connection->conn = NULL;
+        return 0;
+    }
+
+    connection->next_ticket = 0;
+    connection->now_serving = 0;
+    atomic_init(&connection->pipeline_in_flight, 0);
+    return 1;
+}
+
+int persistence_init(Persistence *persistence, const AppConfig *config, AppLogger *logger, char *error, size_t error_size) {
+    if (persistence == NULL || config == NULL) {
+        write_error(error, error_size, "Invalid persistence initialization arguments.");
+        return 0;
+    }
+
+    memset(persistence, 0, sizeof(*persistence));
+    persistence->logger = logger;
+    persistence->write_mode = config->db_write_mode;
+    persistence->pipeline_depth = config->db_pipeline_depth > 0 ? config->db_pipeline_depth : 1;
+    persistence->source_affinity = config->db_source_affinity;
+    persistence->connection_count = config->db_pool_size;
+    if (persistence->connection_count == 0) {
+        persistence->connection_count = 1;
+    }
+    if (persistence->connection_count > PERSISTENCE_MAX_CONNECTIONS) {
+        persistence->connection_count = PERSISTENCE_MAX_CONNECTIONS;
+    }
+    atomic_init(&persistence->pipeline_in_flight_peak, 0);
+    atomic_init(&persistence->busy_connections, 0);
+    atomic_init(&persistence->acquisitions, 0);
+    atomic_init(&persistence->wait_us_total, 0);
+    atomic_init(&persistence->wait_us_max, 0);
+    atomic_init(&persistence->reconnects, 0);
+    persistence->breaker_state = PERSISTENCE_BREAKER_CLOSED;
+    persistence->breaker_threshold = config->db_breaker_failures > 0 ? (unsigned int)config->db_breaker_failures : 1;
+    persistence->reconnect_backoff_initial_ms = config->db_reconnect_backoff_ms > 0 ? config->db_reconnect_backoff_ms : 1;
+    persistence->reconnect_backoff_max_ms = config->db_reconnect_backoff_max_ms > persistence->reconnect_backoff_initial_ms
+                                                ? config->db_reconnect_backoff_max_ms
+                                                : persistence->reconnect_backoff_initial_ms;
+    persistence->breaker_backoff_ms = persistence->reconnect_backoff_initial_ms;
+
+    char conninfo[512] = {0};
+    if (!config_build_conninfo(config, conninfo, sizeof(conninfo))) {
+        write_error(error, error_size, "Failed to build PostgreSQL conninfo.");
+        return 0;
+    }
+
+    if (pthread_mutex_init(&persistence->breaker_mutex, NULL) != 0) {
+        write_error(error, error_size, "Failed to initialize circuit breaker mutex.");
         return 0;
     }
 
+    for (size_t i = 0; i < persistence->connection_count; ++i) {
+        if (!open_connection(&persistence->connections[i], conninfo, i == 0, error, error_size)) {
+            close_connections(persistence, i);
+            pthread_mutex_destroy(&persistence->breaker_mutex);
+            return 0;
+        }
+    }
+
     persistence->initialized = 1;
-    logger_log(logger, LOGGER_INFO, "persistence", "postgres connection initialized");
+    logger_log(logger,
+               LOGGER_INFO,
+               "persistence",
+               "postgres pool initialized connections=%zu write_mode=%s source_affinity=%d",
+               persistence->connection_count,
+               db_write_mode_to_string(persistence->write_mode),
+               persistence->source_affinity);
     return 1;
 }
 
+static void note_acquired(Persistence *persistence, uint64_t started_us) {
+    uint64_t waited = monotonic_us() - started_us;
+
+    atomic_fetch_add(&persistence->busy_connections, 1);
+    atomic_fetch_add(&persistence->acquisitions, 1);
+    atomic_fetch_add(&persistence->wait_us_total, waited);
+
+    uint64_t max = atomic_load(&persistence->wait_us_max);
+    while (waited > max && !atomic_compare_exchange_weak(&persistence->wait_us_max, &max, waited)) {
+    }
+}
+
+/*
+ * Takes the preferred connection if it is free, else any free one, else
+ * waits for the preferred one. With as many connections as processor
+ * threads, every worker effectively owns its own connection.
+ */
+static PersistenceConnection *acquire_connection(Persistence *persistence, size_t preferred) {
+    const uint64_t started = monotonic_us();
+    const size_t count = persistence->connection_count;
+
+    PersistenceConnection *connection = NULL;
+    for (size_t i = 0; i < count && connection == NULL; ++i) {
+        PersistenceConnection *candidate = &persistence->connections[(preferred + i) % count];
+        if (pthread_mutex_trylock(&candidate->mutex) == 0) {
+            connection = candidate;
+        }
+    }
+
+    if (connection == NULL) {
+        connection = &persistence->connections[preferred % count];
+        pthread_mutex_lock(&connection->mutex);
+    }
+
+    note_acquired(persistence, started);
+    return connection;
+}
+
+static void release_connection(Persistence *persistence, PersistenceConnection *connection) {
+    atomic_fetch_sub(&persistence->busy_connections, 1);
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+/* Waits until `ticket` is the next routed batch allowed on this connection. */
+static void acquire_turn(Persistence *persistence, PersistenceConnection *connection, uint64_t ticket) {
+    const uint64_t started = monotonic_us();
+
+    pthread_mutex_lock(&connection->mutex);
+    while (connection->now_serving != ticket) {
+        pthread_cond_wait(&connection->turn, &connection->mutex);
+    }
+
+    note_acquired(persistence, started);
+}
+
+static void release_turn(Persistence *persistence, PersistenceConnection *connection) {
+    connection->now_serving++;
+    pthread_cond_broadcast(&connection->turn);
+    release_connection(persistence, connection);
+}
+
+const char *persistence_breaker_state_to_string(PersistenceBreakerState state) {
+    switch (state) {
+        case PERSISTENCE_BREAKER_OPEN:
+            return "open";
+        case PERSISTENCE_BREAKER_HALF_OPEN:
+            return "half_open";
+        case PERSISTENCE_BREAKER_CLOSED:
+        default:
+            return "closed";
+    }
+}
+
+/*
+ * Circuit breaker. Closed: every call goes through. Open: calls fail fast
+ * until the backoff expires. Half-open: exactly one probe is let through;
+ * its outcome closes the breaker or reopens it with a doubled backoff.
+ */
+static int breaker_begin(Persistence *persistence, char *error, size_t error_size) {
+    int allowed = 1;
+
+    pthread_mutex_lock(&persistence->breaker_mutex);
+    if (persistence->breaker_state == PERSISTENCE_BREAKER_OPEN &&
+        (int64_t)(monotonic_us() / 1000ULL) >= persistence->breaker_retry_at_ms) {
+        persistence->breaker_state = PERSISTENCE_BREAKER_HALF_OPEN;
+    } else if (persistence->breaker_state != PERSISTENCE_BREAKER_CLOSED) {
+        allowed = 0;
+    }
+    pthread_mutex_unlock(&persistence->breaker_mutex);
+
+    if (!allowed) {
+        write_error(error, error_size, "Database circuit breaker is open.");
+    }
+    return allowed;
+}
+
+static void breaker_record(Persistence *persistence, int reachable) {
+    pthread_mutex_lock(&persistence->breaker_mutex);
+
+    if (reachable) {
+        if (persistence->breaker_state != PERSISTENCE_BREAKER_CLOSED) {
+            logger_log(persistence->logger, LOGGER_INFO, "persistence", "database reachable again, breaker closed");
+        }
+        persistence->breaker_state = PERSISTENCE_BREAKER_CLOSED;
+        persistence->breaker_failures = 0;
+        persistence->breaker_backoff_ms = persistence->reconnect_backoff_initial_ms;
+        pthread_mutex_unlock(&persistence->breaker_mutex);
+        return;
+    }
+
+    persistence->breaker_failures++;
+    if (persistence->breaker_state == PERSISTENCE_BREAKER_HALF_OPEN ||
+        persistence->breaker_failures >= persistence->breaker_threshold) {
+        int64_t backoff = persistence->breaker_backoff_ms;
+        persistence->breaker_state = PERSISTENCE_BREAKER_OPEN;
+        persistence->breaker_retry_at_ms = (int64_t)(monotonic_us() / 1000ULL) + backoff;
+        persistence->breaker_backoff_ms = backoff * 2 < persistence->reconnect_backoff_max_ms
+                                              ? backoff * 2
+                                              : persistence->reconnect_backoff_max_ms;
+        logger_log(persistence->logger,
+                   LOGGER_ERROR,
+                   "persistence",
+                   "database unreachable, breaker open retry_in_ms=%lld failures=%u",
+                   (long long)backoff,
+                   persistence->breaker_failures);
+    }
+
+    pthread_mutex_unlock(&persistence->breaker_mutex);
+}
+
+int persistence_breaker_allows(Persistence *persistence) {
+    if (persistence == NULL || !persistence->initialized) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&persistence->breaker_mutex);
+    int allows = persistence->breaker_state == PERSISTENCE_BREAKER_CLOSED ||
+                 (persistence->breaker_state == PERSISTENCE_BREAKER_OPEN &&
+                  (int64_t)(monotonic_us() / 1000ULL) >= persistence->breaker_retry_at_ms);
+    pthread_mutex_unlock(&persistence->breaker_mutex);
+    return allows;
+}
+
+/* Re-opens a dropped session with PQreset; prepared statements must be recreated. */
+static int ensure_connected(Persistence *persistence, PersistenceConnection *connection, char *error, size_t error_size) {
+    if (PQstatus(connection->conn) == CONNECTION_OK) {
+        return 1;
+    }
+
+    PQreset(connection->conn);
+    if (PQstatus(connection->conn) != CONNECTION_OK) {
+        write_error(error, error_size, PQerrorMessage(connection->conn));
+        return 0;
+    }
+
+    atomic_fetch_add(&persistence->reconnects, 1);
+    logger_log(persistence->logger, LOGGER_INFO, "persistence", "connection re-established");
+    return prepare_statements(connection, error, error_size);
+}
+
+/*
+ * Breaker check, pool acquire and reconnect in one step. Returns NULL when
+ * the breaker rejects the call or the connection cannot be restored.
+ */
+static PersistenceConnection *checkout_connection(Persistence *persistence,
+                                                  size_t preferred,
+                                                  char *error,
+                                                  size_t error_size) {
+    if (!breaker_begin(persistence, error, error_size)) {
+        return NULL;
+    }
+
+    PersistenceConnection *connection = acquire_connection(persistence, preferred);
+    if (!ensure_connected(persistence, connection, error, error_size)) {
+        breaker_record(persistence, 0);
+        release_connection(persistence, connection);
+        return NULL;
+    }
+
+    connection->refused = 0;
+    return connection;
+}
+
+/* A row the server rejected still proves the database is reachable; a refused write does not. */
+static int connection_reachable(const PersistenceConnection *connection) {
+    return PQstatus(connection->conn) == CONNECTION_OK && !connection->refused;
+}
+
+static void checkin_connection(Persistence *persistence, PersistenceConnection *connection) {
+    breaker_record(persistence, connection_reachable(connection));
+    release_connection(persistence, connection);
+}
+
 int persistence_ping(Persistence *persistence, char *error, size_t error_size) {
-    if (persistence == NULL || !persistence->initialized || persistence->conn == NULL) {
+    if (persistence == NULL || !persistence->initialized) {
         write_error(error, error_size, "Persistence layer is not initialized.");
         return 0;
     }
 
-    PGresult *result = PQexec(persistence->conn, "SELECT 1");
+    PersistenceConnection *connection = checkout_connection(persistence, 0, error, error_size);
+    if (connection == NULL) {
+        return 0;
+    }
+
+    PGresult *result = PQexec(connection->conn, "SELECT 1");
     if (result == NULL) {
+        checkin_connection(persistence, connection);
         write_error(error, error_size, "Ping query returned NULL result.");
         return 0;
     }
 
     if (PQresultStatus(result) != PGRES_TUPLES_OK) {
-        write_error(error, error_size, PQerrorMessage(persistence->conn));
+        write_error(error, error_size, PQerrorMessage(connection->conn));
+        PQclear(result);
+        checkin_connection(persistence, connection);
+        return 0;
+    }
+
+    PQclear(result);
+    checkin_connection(persistence, connection);
+    return 1;
+}
+
+static void encode_be64(unsigned char *out, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        out[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+/* timestamptz travels as microseconds since the PostgreSQL epoch. */
+static uint64_t pg_timestamp_from_ms(int64_t unix_ms) {
+    return (uint64_t)((unix_ms - (PG_EPOCH_OFFSET_S * 1000)) * 1000);
+}
+
+static uint64_t float8_bits(double value) {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/* Binary parameter set for one processed-log row; values point into the entry and the buffers. */
+typedef struct {
+    unsigned char id[8];
+    unsigned char ingested_at[8];
+    unsigned char processed_at[8];
+    unsigned char latency[8];
+    const char *values[7];
+    int lengths[7];
+} ProcessedLogParams;
+
+static const int processed_log_formats[7] = {1, 1, 1, 1, 1, 1, 1};
+
+static void bind_processed_log(ProcessedLogParams *params,
+                               const LogEntry *entry,
+                               int64_t processed_at_ms,
+                               double processing_ms) {
+    encode_be64(params->id, entry->id);
+    encode_be64(params->ingested_at, pg_timestamp_from_ms(entry->ingested_at_ms));
+    encode_be64(params->processed_at, pg_timestamp_from_ms(processed_at_ms));
+    encode_be64(params->latency, float8_bits(processing_ms));
+
+    params->values[0] = (const char *)params->id;
+    params->values[1] = log_entry_level(entry);
+    params->values[2] = log_entry_source(entry);
+    params->values[3] = log_entry_message(entry);
+    params->values[4] = (const char *)params->ingested_at;
+    params->values[5] = (const char *)params->processed_at;
+    params->values[6] = (const char *)params->latency;
+
+    params->lengths[0] = 8;
+    params->lengths[1] = entry->level_len;
+    params->lengths[2] = entry->source_len;
+    params->lengths[3] = entry->message_len;
+    params->lengths[4] = 8;
+    params->lengths[5] = 8;
+    params->lengths[6] = 8;
+}
+
+/* Runs the prepared processed-log insert; caller holds the mutex. */
+static int exec_insert_processed_log(PersistenceConnection *connection,
+                                     const LogEntry *entry,
+                                     int64_t processed_at_ms,
+                                     double processing_ms,
+                                     char *error,
+                                     size_t error_size) {
+    ProcessedLogParams params;
+    bind_processed_log(&params, entry, processed_at_ms, processing_ms);
+
+    PGresult *result = PQexecPrepared(connection->conn,
+                                      STMT_INSERT_PROCESSED_LOG,
+                                      7,
+                                      params.values,
+                                      params.lengths,
+                                      processed_log_formats,
+                                      0);
+    if (result == NULL) {
+        note_rejection(connection, NULL);
+        write_error(error, error_size, "Processed log insert returned NULL result.");
+        return 0;
+    }
+
+    if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+        note_rejection(connection, result);
+        write_error(error, error_size, PQerrorMessage(connection->conn));
         PQclear(result);
         return 0;
     }
@@ -121,48 +590,619 @@ int persistence_insert_processed_log(Persistence *persistence,
         return 0;
     }
 
-    char id_buf[32] = {0};
-    char ingested_buf[64] = {0};
-    char processed_buf[64] = {0};
-    char latency_buf[64] = {0};
+    PersistenceConnection *connection = checkout_connection(persistence, 0, error, error_size);
+    if (connection == NULL) {
+        return 0;
+    }
 
-    snprintf(id_buf, sizeof(id_buf), "%llu", (unsigned long long)entry->id);
-    snprintf(ingested_buf, sizeof(ingested_buf), "%.6f", ((double)entry->ingested_at_ms) / 1000.0);
-    snprintf(processed_buf, sizeof(processed_buf), "%.6f", ((double)processed_at_ms) / 1000.0);
-    snprintf(latency_buf, sizeof(latency_buf), "%.3f", processing_ms);
+    int ok = exec_insert_processed_log(connection, entry, processed_at_ms, processing_ms, error, error_size);
+    checkin_connection(persistence, connection);
+    return ok;
+}
 
-    const char *params[7] = {
-        id_buf,
-        entry->level,
-        entry->source,
-        entry->message,
-        ingested_buf,
-        processed_buf,
-        latency_buf,
-    };
+static void copy_put_u16(CopyChunk *chunk, uint16_t value) {
+    chunk->data[chunk->used++] = (unsigned char)(value >> 8);
+    chunk->data[chunk->used++] = (unsigned char)value;
+}
+
+static void copy_put_u32(CopyChunk *chunk, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        chunk->data[chunk->used++] = (unsigned char)(value >> shift);
+    }
+}
+
+static void copy_put_u64(CopyChunk *chunk, uint64_t value) {
+    encode_be64(chunk->data + chunk->used, value);
+    chunk->used += 8;
+}
 
+static void copy_put_int8_field(CopyChunk *chunk, uint64_t value) {
+    copy_put_u32(chunk, 8);
+    copy_put_u64(chunk, value);
+}
+
+static void copy_put_float8_field(CopyChunk *chunk, double value) {
+    copy_put_int8_field(chunk, float8_bits(value));
+}
+
+static void copy_put_timestamp_field(CopyChunk *chunk, int64_t unix_ms) {
+    copy_put_int8_field(chunk, pg_timestamp_from_ms(unix_ms));
+}
+
+static void copy_put_text_field(CopyChunk *chunk, const char *text, size_t length) {
+    copy_put_u32(chunk, (uint32_t)length);
+    memcpy(chunk->data + chunk->used, text, length);
+    chunk->used += length;
+}
+
+static size_t copy_row_size(const LogEntry *entry) {
+    /* field count + 7 length words + 4 eight-byte values + the three texts */
+    return 2 + (7 * 4) + (4 * 8) + entry->level_len + entry->source_len + entry->message_len;
+}
+
+static int copy_flush(PersistenceConnection *connection, CopyChunk *chunk, char *error, size_t error_size) {
+    if (chunk->used == 0) {
+        return 1;
+    }
+
+    if (PQputCopyData(connection->conn, (const char *)chunk->data, (int)chunk->used) != 1) {
+        write_error(error, error_size, PQerrorMessage(connection->conn));
+        return 0;
+    }
+
+    chunk->used = 0;
+    return 1;
+}
+
+/* Collects every pending result so the connection is idle again; 1 only if COPY committed. */
+static int copy_finish(PersistenceConnection *connection, const char *abort_reason, char *error, size_t error_size) {
+    int ok = 1;
+
+    if (PQputCopyEnd(connection->conn, abort_reason) != 1) {
+        write_error(error, error_size, PQerrorMessage(connection->conn));
+        ok = 0;
+    }
+
+    PGresult *result = NULL;
+    while ((result = PQgetResult(connection->conn)) != NULL) {
+        if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+            note_rejection(connection, result);
+            if (ok && abort_reason == NULL) {
+                write_error(error, error_size, PQresultErrorMessage(result));
+            }
+            ok = 0;
+        }
+        PQclear(result);
+    }
+
+    return ok && abort_reason == NULL;
+}
+
+/* Streams the batch as one binary COPY; a single statement, so all-or-nothing. */
+static int write_copy(PersistenceConnection *connection,
+                      const LinkedList *batch,
+                      int64_t processed_at_ms,
+                      char *error,
+                      size_t error_size) {
+    static const unsigned char signature[11] = {'P', 'G', 'C', 'O', 'P', 'Y', '\n', 0xFF, '\r', '\n', '\0'};
     const char *sql =
-        "INSERT INTO processed_logs "
+        "COPY processed_logs "
         "(log_id, level, source, message, ingested_at, processed_at, processing_ms) "
-        "VALUES ($1::BIGINT, $2, $3, $4, to_timestamp($5::DOUBLE PRECISION), "
-        "to_timestamp($6::DOUBLE PRECISION), $7::DOUBLE PRECISION)";
+        "FROM STDIN WITH (FORMAT binary)";
+
+    CopyChunk chunk;
+    chunk.used = 0;
 
-    PGresult *result = PQexecParams(persistence->conn, sql, 7, NULL, params, NULL, NULL, 0);
+    PGresult *result = PQexec(connection->conn, sql);
+    if (result == NULL || PQresultStatus(result) != PGRES_COPY_IN) {
+        note_rejection(connection, result);
+        write_error(error, error_size, PQerrorMessage(connection->conn));
+        PQclear(result);
+        return 0;
+    }
+    PQclear(result);
+
+    memcpy(chunk.data, signature, sizeof(signature));
+    chunk.used = sizeof(signature);
+    copy_put_u32(&chunk, 0);
+    copy_put_u32(&chunk, 0);
+
+    for (const LogEntry *entry = batch->head; entry != NULL; entry = entry->next) {
+        if (COPY_CHUNK_BYTES - chunk.used < copy_row_size(entry) &&
+            !copy_flush(connection, &chunk, error, error_size)) {
+            copy_finish(connection, "client write failed", NULL, 0);
+            return 0;
+        }
+
+        copy_put_u16(&chunk, 7);
+        copy_put_int8_field(&chunk, entry->id);
+        copy_put_text_field(&chunk, log_entry_level(entry), entry->level_len);
+        copy_put_text_field(&chunk, log_entry_source(entry), entry->source_len);
+        copy_put_text_field(&chunk, log_entry_message(entry), entry->message_len);
+        copy_put_timestamp_field(&chunk, entry->ingested_at_ms);
+        copy_put_timestamp_field(&chunk, processed_at_ms);
+        copy_put_float8_field(&chunk, (double)(processed_at_ms - entry->ingested_at_ms));
+    }
+
+    if (COPY_CHUNK_BYTES - chunk.used < 2 && !copy_flush(connection, &chunk, error, error_size)) {
+        copy_finish(connection, "client write failed", NULL, 0);
+        return 0;
+    }
+    copy_put_u16(&chunk, 0xFFFF);
+
+    if (!copy_flush(connection, &chunk, error, error_size)) {
+        copy_finish(connection, "client write failed", NULL, 0);
+        return 0;
+    }
+
+    return copy_finish(connection, NULL, error, error_size);
+}
+
+/* One BEGIN/COMMIT around repeated prepared inserts: one commit (and fsync) per batch. */
+static int write_transaction(PersistenceConnection *connection,
+                             const LinkedList *batch,
+                             int64_t processed_at_ms,
+                             char *error,
+                             size_t error_size) {
+    if (!exec_command(connection, "BEGIN", error, error_size)) {
+        return 0;
+    }
+
+    for (const LogEntry *entry = batch->head; entry != NULL; entry = entry->next) {
+        if (!exec_insert_processed_log(connection,
+                                       entry,
+                                       processed_at_ms,
+                                       (double)(processed_at_ms - entry->ingested_at_ms),
+                                       error,
+                                       error_size)) {
+            exec_command(connection, "ROLLBACK", NULL, 0);
+            return 0;
+        }
+    }
+
+    return exec_command(connection, "COMMIT", error, error_size);
+}
+
+/* Moves [from, until) out of `batch` to the tail of `out`, in order; `until` NULL means to the end. */
+static void move_range(LinkedList *batch, LogEntry *from, LogEntry *until, LinkedList *out) {
+    while (from != NULL && from != until) {
+        LogEntry *next = from->next;
+        linked_list_remove(batch, from);
+        linked_list_push_back(out, from);
+        from = next;
+    }
+}
+
+static void move_to_failed(LinkedList *batch, LogEntry *from, LinkedList *failed) {
+    move_range(batch, from, NULL, failed);
+}
+
+static void note_in_flight(Persistence *persistence, PersistenceConnection *connection, size_t in_flight) {
+    atomic_store(&connection->pipeline_in_flight, in_flight);
+
+    size_t peak = atomic_load(&persistence->pipeline_in_flight_peak);
+    while (in_flight > peak &&
+           !atomic_compare_exchange_weak(&persistence->pipeline_in_flight_peak, &peak, in_flight)) {
+    }
+}
+
+/*
+ * Autocommitted single-row inserts. Each row the server rejects as bad data
+ * has its attempt count raised; if the connection drops or the server
+ * refuses the write outright, the rest fail uncounted.
+ */
+static int write_rows(PersistenceConnection *connection,
+                      LinkedList *batch,
+                      int64_t processed_at_ms,
+                      LinkedList *failed,
+                      char *error,
+                      size_t error_size) {
+    const size_t failed_before = linked_list_size(failed);
+    LogEntry *entry = batch->head;
+
+    while (entry != NULL) {
+        LogEntry *next = entry->next;
+
+        if (!exec_insert_processed_log(connection,
+                                       entry,
+                                       processed_at_ms,
+                                       (double)(processed_at_ms - entry->ingested_at_ms),
+                                       error,
+                                       error_size)) {
+            if (!connection_reachable(connection)) {
+                move_to_failed(batch, entry, failed);
+                break;
+            }
+
+            entry->attempts++;
+            linked_list_remove(batch, entry);
+            linked_list_push_back(failed, entry);
+        }
+
+        entry = next;
+    }
+
+    return linked_list_size(failed) == failed_before;
+}
+
+typedef enum {
+    PIPELINE_ROW_STORED,
+    PIPELINE_ROW_FAILED,
+    PIPELINE_SYNCED,
+} PipelineResult;
+
+/*
+ * Consumes the next pipelined result: a row's insert result and its
+ * end-of-query NULL, or a sync marker. Returns 0 if the stream is broken, in
+ * which case the outcome of everything still in flight is unknown.
+ */
+static int read_pipelined_result(PersistenceConnection *connection,
+                                 PipelineResult *outcome,
+                                 char *error,
+                                 size_t error_size) {
+    PGresult *result = PQgetResult(connection->conn);
     if (result == NULL) {
-        write_error(error, error_size, "Processed log insert returned NULL result.");
+        write_error(error, error_size, PQerrorMessage(connection->conn));
         return 0;
     }
 
-    if (PQresultStatus(result) != PGRES_COMMAND_OK) {
-        write_error(error, error_size, PQerrorMessage(persistence->conn));
+    ExecStatusType status = PQresultStatus(result);
+    if (status == PGRES_PIPELINE_SYNC) {
         PQclear(result);
-        return 0;
+        *outcome = PIPELINE_SYNCED;
+        return 1;
     }
 
+    *outcome = status == PGRES_COMMAND_OK ? PIPELINE_ROW_STORED : PIPELINE_ROW_FAILED;
+    if (status != PGRES_COMMAND_OK && status != PGRES_PIPELINE_ABORTED) {
+        note_rejection(connection, result);
+        write_error(error, error_size, PQresultErrorMessage(result));
+    }
     PQclear(result);
+
+    result = PQgetResult(connection->conn);
+    if (result != NULL) {
+        write_error(error, error_size, "Unexpected extra result in pipeline.");
+        PQclear(result);
+        return 0;
+    }
     return 1;
 }
 
+/*
+ * Keeps up to `pipeline_depth` inserts in flight on the connection and sends
+ * a sync after every `pipeline_depth` rows and at the end of the batch, so
+ * each group commits as one implicit transaction rather than one commit per
+ * row. An error rolls back its whole group; once the pipeline is done those
+ * rows are retried one by one so only the bad ones fail. Results come back
+ * in send order, which is how they are matched to entries.
+ *
+ * The server only flushes results at a sync, so a row is read only once its
+ * group's sync has been sent: reads happen when the window is full (a full
+ * group is synced first) or when nothing more will be sent (the open group
+ * is synced first).
+ */
+static int write_pipeline(Persistence *persistence,
+                          PersistenceConnection *connection,
+                          LinkedList *batch,
+                          int64_t processed_at_ms,
+                          LinkedList *failed,
+                          char *error,
+                          size_t error_size) {
+    if (PQenterPipelineMode(connection->conn) != 1) {
+        write_error(error, error_size, PQerrorMessage(connection->conn));
+        linked_list_append_list(failed, batch);
+        return 0;
+    }
+
+    const size_t failed_before = linked_list_size(failed);
+    const size_t depth = persistence->pipeline_depth;
+    LinkedList retry;
+    linked_list_init(&retry);
+    LogEntry *next_to_send = batch->head;
+    LogEntry *oldest_pending = batch->head;
+    LogEntry *group_first = batch->head;
+    size_t in_flight = 0;
+    size_t unsynced = 0;
+    size_t syncs_pending = 0;
+    int group_failed = 0;
+    int broken = 0;
+
+    /* Once the server refuses a write, nothing more is sent; what is in flight is still read back. */
+    for (;;) {
+        if (unsynced > 0 && (unsynced == depth || next_to_send == NULL || connection->refused)) {
+            if (PQpipelineSync(connection->conn) != 1) {
+                write_error(error, error_size, PQerrorMessage(connection->conn));
+                broken = 1;
+                break;
+            }
+            unsynced = 0;
+            syncs_pending++;
+            continue;
+        }
+
+        if (next_to_send != NULL && in_flight < depth && !connection->refused) {
+            ProcessedLogParams params;
+            bind_processed_log(&params,
+                               next_to_send,
+                               processed_at_ms,
+                               (double)(processed_at_ms - next_to_send->ingested_at_ms));
+
+            if (PQsendQueryPrepared(connection->conn,
+                                    STMT_INSERT_PROCESSED_LOG,
+                                    7,
+                                    params.values,
+                                    params.lengths,
+                                    processed_log_formats,
+                                    0) != 1) {
+                write_error(error, error_size, PQerrorMessage(connection->conn));
+                broken = 1;
+                break;
+            }
+
+            next_to_send = next_to_send->next;
+            unsynced++;
+            note_in_flight(persistence, connection, ++in_flight);
+            continue;
+        }
+
+        if (in_flight == 0 && syncs_pending == 0) {
+            break;
+        }
+
+        PipelineResult outcome = PIPELINE_ROW_STORED;
+        if (!read_pipelined_result(connection, &outcome, error, error_size)) {
+            broken = 1;
+            break;
+        }
+
+        if (outcome == PIPELINE_SYNCED) {
+            if (group_failed) {
+                move_range(batch, group_first, oldest_pending, &retry);
+            }
+            group_first = oldest_pending;
+            group_failed = 0;
+            syncs_pending--;
+            continue;
+        }
+
+        oldest_pending = oldest_pending->next;
+        note_in_flight(persistence, connection, --in_flight);
+        group_failed |= outcome == PIPELINE_ROW_FAILED;
+    }
+
+    if (broken || connection->refused) {
+        linked_list_append_list(failed, &retry);
+        move_to_failed(batch, group_first, failed);
+    }
+
+    note_in_flight(persistence, connection, 0);
+    if (PQexitPipelineMode(connection->conn) != 1) {
+        logger_log(persistence->logger,
+                   LOGGER_ERROR,
+                   "persistence",
+                   "failed to leave pipeline mode: %s",
+                   PQerrorMessage(connection->conn));
+    }
+
+    if (retry.head != NULL) {
+        write_rows(connection, &retry, processed_at_ms, failed, error, error_size);
+        linked_list_append_list(batch, &retry);
+    }
+
+    return linked_list_size(failed) == failed_before;
+}
+
+/* Writes on an already acquired connection; unstored entries move to `failed`. */
+static int write_on_connection(Persistence *persistence,
+                               PersistenceConnection *connection,
+                               LinkedList *batch,
+                               int64_t processed_at_ms,
+                               LinkedList *failed,
+                               char *error,
+                               size_t error_size) {
+    connection->refused = 0;
+    if (persistence->write_mode == DB_WRITE_PIPELINE) {
+        return write_pipeline(persistence, connection, batch, processed_at_ms, failed, error, error_size);
+    }
+
+    int ok = persistence->write_mode == DB_WRITE_TRANSACTION
+                 ? write_transaction(connection, batch, processed_at_ms, error, error_size)
+                 : write_copy(connection, batch, processed_at_ms, error, error_size);
+    if (ok) {
+        return 1;
+    }
+
+    /* The server rejected a row: retry row by row so only the poison rows fail. */
+    if (connection_reachable(connection)) {
+        return write_rows(connection, batch, processed_at_ms, failed, error, error_size);
+    }
+
+    linked_list_append_list(failed, batch);
+    return 0;
+}
+
+int persistence_write_batch(Persistence *persistence,
+                            size_t slot,
+                            LinkedList *batch,
+                            int64_t processed_at_ms,
+                            LinkedList *failed,
+                            char *error,
+                            size_t error_size) {
+    if (batch == NULL || failed == NULL) {
+        write_error(error, error_size, "Invalid processed log batch arguments.");
+        return 0;
+    }
+
+    if (batch->head == NULL) {
+        return 1;
+    }
+
+    if (persistence == NULL || !persistence->initialized) {
+        write_error(error, error_size, "Persistence layer is not initialized.");
+        linked_list_append_list(failed, batch);
+        return 0;
+    }
+
+    PersistenceConnection *connection = checkout_connection(persistence, slot, error, error_size);
+    if (connection == NULL) {
+        linked_list_append_list(failed, batch);
+        return 0;
+    }
+
+    int ok = write_on_connection(persistence, connection, batch, processed_at_ms, failed, error, error_size);
+    checkin_connection(persistence, connection);
+    return ok;
+}
+
+/* FNV-1a over the source name: the same source always maps to the same connection. */
+static size_t source_connection(const Persistence *persistence, const LogEntry *entry) {
+    uint32_t hash = 2166136261u;
+    const unsigned char *source = (const unsigned char *)log_entry_source(entry);
+    for (uint16_t i = 0; i < entry->source_len; ++i) {
+        hash ^= source[i];
+        hash *= 16777619u;
+    }
+
+    return hash % persistence->connection_count;
+}
+
+void persistence_route_batch(Persistence *persistence, LinkedList *batch, PersistenceRoute *route) {
+    if (persistence == NULL || batch == NULL || route == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < PERSISTENCE_MAX_CONNECTIONS; ++i) {
+        linked_list_init(&route->parts[i]);
+        route->tickets[i] = 0;
+    }
+
+    if (!persistence->initialized) {
+        linked_list_append_list(&route->parts[0], batch);
+        return;
+    }
+
+    while (batch->head != NULL) {
+        LogEntry *entry = linked_list_pop_front(batch);
+        linked_list_push_back(&route->parts[source_connection(persistence, entry)], entry);
+    }
+
+    for (size_t i = 0; i < persistence->connection_count; ++i) {
+        if (route->parts[i].head != NULL) {
+            route->tickets[i] = persistence->connections[i].next_ticket++;
+        }
+    }
+}
+
+int persistence_write_routed(Persistence *persistence,
+                             PersistenceRoute *route,
+                             int64_t processed_at_ms,
+                             LinkedList *stored,
+                             LinkedList *failed,
+                             char *error,
+                             size_t error_size) {
+    if (route == NULL || stored == NULL || failed == NULL) {
+        write_error(error, error_size, "Invalid routed batch arguments.");
+        return 0;
+    }
+
+    if (persistence == NULL || !persistence->initialized) {
+        write_error(error, error_size, "Persistence layer is not initialized.");
+        for (size_t i = 0; i < PERSISTENCE_MAX_CONNECTIONS; ++i) {
+            linked_list_append_list(failed, &route->parts[i]);
+        }
+        return 0;
+    }
+
+    /* Like persistence_write_batch: nothing to write must not spend the half-open probe. */
+    int empty = 1;
+    for (size_t i = 0; i < persistence->connection_count && empty; ++i) {
+        empty = route->parts[i].head == NULL;
+    }
+    if (empty) {
+        return 1;
+    }
+
+    /*
+     * Parts are visited in connection order, so ticket waits can never form a
+     * cycle. Every reserved turn is taken and released even when the breaker
+     * rejects the batch, or later batches on that connection would wait forever.
+     */
+    char part_error[256] = {0};
+    int allowed = breaker_begin(persistence, part_error, sizeof(part_error));
+    int ok = 1;
+
+    for (size_t i = 0; i < persistence->connection_count; ++i) {
+        if (route->parts[i].head == NULL) {
+            continue;
+        }
+
+        PersistenceConnection *connection = &persistence->connections[i];
+        int part_ok = 0;
+
+        acquire_turn(persistence, connection, route->tickets[i]);
+        if (!allowed) {
+            linked_list_append_list(failed, &route->parts[i]);
+        } else if (!ensure_connected(persistence, connection, part_error, sizeof(part_error))) {
+            linked_list_append_list(failed, &route->parts[i]);
+            breaker_record(persistence, 0);
+        } else {
+            part_ok = write_on_connection(persistence,
+                                          connection,
+                                          &route->parts[i],
+                                          processed_at_ms,
+                                          failed,
+                                          part_error,
+                                          sizeof(part_error));
+            breaker_record(persistence, connection_reachable(connection));
+        }
+        release_turn(persistence, connection);
+
+        if (!part_ok && ok) {
+            write_error(error, error_size, part_error);
+            ok = 0;
+        }
+        linked_list_append_list(stored, &route->parts[i]);
+    }
+
+    return ok;
+}
+
+void persistence_get_stats(Persistence *persistence, PersistenceStats *stats) {
+    if (stats == NULL) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if (persistence == NULL || !persistence->initialized) {
+        return;
+    }
+
+    for (size_t i = 0; i < persistence->connection_count; ++i) {
+        stats->pipeline_in_flight += atomic_load(&persistence->connections[i].pipeline_in_flight);
+    }
+    stats->pipeline_in_flight_peak = atomic_load(&persistence->pipeline_in_flight_peak);
+
+    stats->pool_size = persistence->connection_count;
+    stats->pool_busy = atomic_load(&persistence->busy_connections);
+    stats->pool_acquisitions = atomic_load(&persistence->acquisitions);
+    if (stats->pool_acquisitions > 0) {
+        stats->pool_wait_ms_avg =
+            ((double)atomic_load(&persistence->wait_us_total) / (double)stats->pool_acquisitions) / 1000.0;
+    }
+    stats->pool_wait_ms_max = (double)atomic_load(&persistence->wait_us_max) / 1000.0;
+    stats->reconnects = atomic_load(&persistence->reconnects);
+
+    pthread_mutex_lock(&persistence->breaker_mutex);
+    stats->breaker_state = persistence->breaker_state;
+    stats->breaker_failures = persistence->breaker_failures;
+    if (persistence->breaker_state == PERSISTENCE_BREAKER_OPEN) {
+        int64_t remaining = persistence->breaker_retry_at_ms - (int64_t)(monotonic_us() / 1000ULL);
+        stats->breaker_retry_in_ms = remaining > 0 ? remaining : 0;
+    }
+    pthread_mutex_unlock(&persistence->breaker_mutex);
+}
+
 int persistence_insert_metrics(Persistence *persistence,
                                const EngineMetrics *metrics,
                                char *error,
@@ -198,24 +1238,27 @@ int persistence_insert_metrics(Persistence *persistence,
         last_processing_buf,
     };
 
-    const char *sql =
-        "INSERT INTO processing_metrics "
-        "(total_ingested, total_processed, total_errors, queue_depth, buffer_capacity, memory_bytes, last_processing_ms) "
-        "VALUES ($1::BIGINT, $2::BIGINT, $3::BIGINT, $4::BIGINT, $5::BIGINT, $6::BIGINT, $7::DOUBLE PRECISION)";
+    PersistenceConnection *connection = checkout_connection(persistence, 0, error, error_size);
+    if (connection == NULL) {
+        return 0;
+    }
 
-    PGresult *result = PQexecParams(persistence->conn, sql, 7, NULL, params, NULL, NULL, 0);
+    PGresult *result = PQexecPrepared(connection->conn, STMT_INSERT_METRICS, 7, params, NULL, NULL, 0);
     if (result == NULL) {
+        checkin_connection(persistence, connection);
         write_error(error, error_size, "Metrics insert returned NULL result.");
         return 0;
     }
 
     if (PQresultStatus(result) != PGRES_COMMAND_OK) {
-        write_error(error, error_size, PQerrorMessage(persistence->conn));
+        write_error(error, error_size, PQerrorMessage(connection->conn));
         PQclear(result);
+        checkin_connection(persistence, connection);
         return 0;
     }
 
     PQclear(result);
+    checkin_connection(persistence, connection);
     return 1;
 }
 
@@ -224,9 +1267,9 @@ void persistence_close(Persistence *persistence) {
         return;
     }
 
-    if (persistence->conn != NULL) {
-        PQfinish(persistence->conn);
-        persistence->conn = NULL;
+    if (persistence->initialized) {
+        close_connections(persistence, persistence->connection_count);
+        pthread_mutex_destroy(&persistence->breaker_mutex);
     }
 
     persistence->initialized = 0;
@@ -0,0 +1,180 @@
+#include "sink.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static int sink_ready(const Sink *sink) {
+    return sink != NULL && sink->initialized && sink->ops != NULL;
+}
+
+int sink_open(Sink *sink, const AppConfig *config, AppLogger *logger, char *error, size_t error_size) {
+    if (sink == NULL || config == NULL) {
+        write_error(error, error_size, "Invalid sink arguments.");
+        return 0;
+    }
+
+    memset(sink, 0, sizeof(*sink));
+    sink->kind = config->sink_kind;
+    switch (config->sink_kind) {
+        case SINK_FILE:
+            sink->ops = &SINK_FILE_OPS;
+            break;
+        case SINK_NULL:
+            sink->ops = &SINK_NULL_OPS;
+            break;
+        case SINK_POSTGRES:
+        default:
+            sink->ops = &SINK_POSTGRES_OPS;
+            break;
+    }
+
+    if (!sink->ops->open(sink, config, logger, error, error_size)) {
+        sink->ops = NULL;
+        return 0;
+    }
+
+    sink->initialized = 1;
+    logger_log(logger, LOGGER_INFO, "sink", "opened sink=%s ordered=%d", sink->ops->name, sink->ordered);
+    return 1;
+}
+
+const char *sink_name(const Sink *sink) {
+    return sink_ready(sink) ? sink->ops->name : "none";
+}
+
+void *sink_reserve(Sink *sink, LinkedList *batch) {
+    if (!sink_ready(sink) || sink->ops->reserve == NULL) {
+        return NULL;
+    }
+
+    return sink->ops->reserve(sink, batch);
+}
+
+int sink_write_batch(Sink *sink,
+                     size_t slot,
+                     void *reservation,
+                     LinkedList *batch,
+                     int64_t processed_at_ms,
+                     LinkedList *failed,
+                     char *error,
+                     size_t error_size) {
+    if (!sink_ready(sink) || batch == NULL || failed == NULL) {
+        write_error(error, error_size, "Sink is not initialized.");
+        return 0;
+    }
+
+    return sink->ops->write_batch(sink, slot, reservation, batch, processed_at_ms, failed, error, error_size);
+}
+
+int sink_flush(Sink *sink, char *error, size_t error_size) {
+    if (!sink_ready(sink)) {
+        write_error(error, error_size, "Sink is not initialized.");
+        return 0;
+    }
+
+    return sink->ops->flush(sink, error, error_size);
+}
+
+int sink_health(Sink *sink, char *error, size_t error_size) {
+    if (!sink_ready(sink)) {
+        write_error(error, error_size, "Sink is not initialized.");
+        return 0;
+    }
+
+    return sink->ops->health(sink, error, error_size);
+}
+
+int sink_available(Sink *sink) {
+    if (!sink_ready(sink)) {
+        return 0;
+    }
+
+    return sink->ops->available == NULL || sink->ops->available(sink);
+}
+
+int sink_record_metrics(Sink *sink, const EngineMetrics *metrics, char *error, size_t error_size) {
+    if (!sink_ready(sink)) {
+        write_error(error, error_size, "Sink is not initialized.");
+        return 0;
+    }
+
+    return sink->ops->record_metrics == NULL || sink->ops->record_metrics(sink, metrics, error, error_size);
+}
+
+Persistence *sink_persistence(Sink *sink) {
+    if (!sink_ready(sink) || sink->ops != &SINK_POSTGRES_OPS) {
+        return NULL;
+    }
+
+    return (Persistence *)sink->state;
+}
+
+void sink_close(Sink *sink) {
+    if (!sink_ready(sink)) {
+        return;
+    }
+
+    sink->ops->close(sink);
+    sink->ops = NULL;
+    sink->state = NULL;
+    sink->initialized = 0;
+}
+
+/* Null sink: every batch is accepted and discarded, which measures the engine on its own. */
+
+static int null_open(Sink *sink, const AppConfig *config, AppLogger *logger, char *error, size_t error_size) {
+    (void)sink;
+    (void)config;
+    (void)logger;
+    (void)error;
+    (void)error_size;
+    return 1;
+}
+
+static int null_write_batch(Sink *sink,
+                            size_t slot,
+                            void *reservation,
+                            LinkedList *batch,
+                            int64_t processed_at_ms,
+                            LinkedList *failed,
+                            char *error,
+                            size_t error_size) {
+    (void)sink;
+    (void)slot;
+    (void)reservation;
+    (void)batch;
+    (void)processed_at_ms;
+    (void)failed;
+    (void)error;
+    (void)error_size;
+    return 1;
+}
+
+static int null_flush(Sink *sink, char *error, size_t error_size) {
+    (void)sink;
+    (void)error;
+    (void)error_size;
+    return 1;
+}
+
+static void null_close(Sink *sink) {
+    (void)sink;
+}
+
+const SinkOps SINK_NULL_OPS = {
+    .name = "null",
+    .open = null_open,
+    .reserve = NULL,
+    .write_batch = null_write_batch,
+    .flush = null_flush,
+    .health = null_flush,
+    .available = NULL,
+    .record_metrics = NULL,
+    .close = null_close,
+};
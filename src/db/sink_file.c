@@ -0,0 +1,384 @@
+#include "sink.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log_entry.h"
+
+/*
+ * File sink: processed entries are appended as JSON lines to
+ * `SINK_FILE_DIR/sink-%010u.jsonl`, rolling to a new segment once the
+ * current one reaches SINK_FILE_SEGMENT_BYTES. Each batch is formatted
+ * outside the lock and written with a single write(2), so workers only
+ * serialize on the append itself. Segments are output, not scratch space:
+ * they are never removed, and a restart continues after the highest one.
+ */
+
+#define FILE_SINK_PREFIX "sink-"
+#define FILE_SINK_SUFFIX ".jsonl"
+
+#if defined(__linux__)
+#define file_sink_sync_fd fdatasync
+#else
+#define file_sink_sync_fd fsync
+#endif
+
+typedef struct {
+    char dir[256];
+    size_t segment_bytes;
+    int fsync_enabled;
+    int fd;
+    uint32_t seq;
+    size_t segment_used;
+    pthread_mutex_t mutex;
+    AppLogger *logger;
+} FileSinkState;
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} LineBuffer;
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static int reserve_buffer(LineBuffer *buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) {
+        return 1;
+    }
+
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity : 4096;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+
+    char *data = realloc(buffer->data, capacity);
+    if (data == NULL) {
+        return 0;
+    }
+
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+/* Worst case every byte becomes a \u00XX escape. */
+static void append_json_string(LineBuffer *buffer, const char *text) {
+    char *out = buffer->data + buffer->length;
+    *out++ = '"';
+
+    for (const unsigned char *cursor = (const unsigned char *)text; *cursor != '\0'; ++cursor) {
+        switch (*cursor) {
+            case '\\':
+                *out++ = '\\';
+                *out++ = '\\';
+                break;
+            case '"':
+                *out++ = '\\';
+                *out++ = '"';
+                break;
+            case '\n':
+                *out++ = '\\';
+                *out++ = 'n';
+                break;
+            case '\r':
+                *out++ = '\\';
+                *out++ = 'r';
+                break;
+            case '\t':
+                *out++ = '\\';
+                *out++ = 't';
+                break;
+            default:
+                if (*cursor < 0x20) {
+                    out += sprintf(out, "\\u%04x", *cursor);
+                } else {
+                    *out++ = (char)*cursor;
+                }
+                break;
+        }
+    }
+
+    *out++ = '"';
+    buffer->length = (size_t)(out - buffer->data);
+}
+
+static int append_entry(LineBuffer *buffer, const LogEntry *entry, int64_t processed_at_ms) {
+    const char *level = log_entry_level(entry);
+    const char *source = log_entry_source(entry);
+    const char *message = log_entry_message(entry);
+    size_t strings = strlen(level) + strlen(source) + strlen(message);
+
+    if (!reserve_buffer(buffer, 192 + (strings * 6))) {
+        return 0;
+    }
+
+    buffer->length += (size_t)sprintf(buffer->data + buffer->length,
+                                      "{\"id\":%llu,\"ingested_at_ms\":%lld,\"processed_at_ms\":%lld,"
+                                      "\"processing_ms\":%lld,\"level\":",
+                                      (unsigned long long)entry->id,
+                                      (long long)entry->ingested_at_ms,
+                                      (long long)processed_at_ms,
+                                      (long long)(processed_at_ms - entry->ingested_at_ms));
+    append_json_string(buffer, level);
+    memcpy(buffer->data + buffer->length, ",\"source\":", 10);
+    buffer->length += 10;
+    append_json_string(buffer, source);
+    memcpy(buffer->data + buffer->length, ",\"message\":", 11);
+    buffer->length += 11;
+    append_json_string(buffer, message);
+    memcpy(buffer->data + buffer->length, "}\n", 2);
+    buffer->length += 2;
+    return 1;
+}
+
+static int parse_segment_name(const char *name, uint32_t *seq_out) {
+    size_t prefix_len = strlen(FILE_SINK_PREFIX);
+    size_t suffix_len = strlen(FILE_SINK_SUFFIX);
+    size_t len = strlen(name);
+    if (len <= prefix_len + suffix_len || strncmp(name, FILE_SINK_PREFIX, prefix_len) != 0 ||
+        strcmp(name + len - suffix_len, FILE_SINK_SUFFIX) != 0) {
+        return 0;
+    }
+
+    uint32_t seq = 0;
+    for (size_t i = prefix_len; i < len - suffix_len; ++i) {
+        if (name[i] < '0' || name[i] > '9') {
+            return 0;
+        }
+        seq = (seq * 10u) + (uint32_t)(name[i] - '0');
+    }
+
+    *seq_out = seq;
+    return seq > 0;
+}
+
+static int open_segment(FileSinkState *state, uint32_t seq) {
+    char path[320];
+    snprintf(path, sizeof(path), "%s/" FILE_SINK_PREFIX "%010u" FILE_SINK_SUFFIX, state->dir, seq);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+
+    state->fd = fd;
+    state->seq = seq;
+    state->segment_used = 0;
+    return 1;
+}
+
+static int write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return 1;
+}
+
+static int file_open(Sink *sink, const AppConfig *config, AppLogger *logger, char *error, size_t error_size) {
+    if (config->sink_file_dir[0] == '\0') {
+        write_error(error, error_size, "SINK_FILE_DIR must not be empty.");
+        return 0;
+    }
+
+    FileSinkState *state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        write_error(error, error_size, "Out of memory while allocating file sink.");
+        return 0;
+    }
+
+    snprintf(state->dir, sizeof(state->dir), "%s", config->sink_file_dir);
+    state->segment_bytes = config->sink_file_segment_bytes > 0 ? config->sink_file_segment_bytes : 1;
+    state->fsync_enabled = config->sink_file_fsync;
+    state->fd = -1;
+    state->logger = logger;
+
+    if (mkdir(state->dir, 0755) != 0 && errno != EEXIST) {
+        free(state);
+        write_error(error, error_size, "Unable to create file sink directory.");
+        return 0;
+    }
+
+    DIR *handle = opendir(state->dir);
+    if (handle == NULL) {
+        free(state);
+        write_error(error, error_size, "Unable to open file sink directory.");
+        return 0;
+    }
+
+    uint32_t max_seq = 0;
+    struct dirent *item = NULL;
+    while ((item = readdir(handle)) != NULL) {
+        uint32_t seq = 0;
+        if (parse_segment_name(item->d_name, &seq) && seq > max_seq) {
+            max_seq = seq;
+        }
+    }
+    closedir(handle);
+
+    if (!open_segment(state, max_seq + 1)) {
+        free(state);
+        write_error(error, error_size, "Unable to open file sink segment.");
+        return 0;
+    }
+
+    if (pthread_mutex_init(&state->mutex, NULL) != 0) {
+        close(state->fd);
+        free(state);
+        write_error(error, error_size, "Failed to initialize file sink mutex.");
+        return 0;
+    }
+
+    sink->state = state;
+    logger_log(logger,
+               LOGGER_INFO,
+               "sink",
+               "file sink dir=%s segment=%u segment_bytes=%zu fsync=%d",
+               state->dir,
+               state->seq,
+               state->segment_bytes,
+               state->fsync_enabled);
+    return 1;
+}
+
+/*
+ * A batch goes to one segment in one write, so it is stored or failed as a
+ * whole: a write or sync that fails is truncated back to where it started.
+ */
+static int file_write_batch(Sink *sink,
+                            size_t slot,
+                            void *reservation,
+                            LinkedList *batch,
+                            int64_t processed_at_ms,
+                            LinkedList *failed,
+                            char *error,
+                            size_t error_size) {
+    (void)slot;
+    (void)reservation;
+    FileSinkState *state = (FileSinkState *)sink->state;
+    if (batch->head == NULL) {
+        return 1;
+    }
+
+    LineBuffer buffer = {0};
+    int ok = 1;
+    for (LogEntry *entry = batch->head; entry != NULL && ok; entry = entry->next) {
+        ok = append_entry(&buffer, entry, processed_at_ms);
+    }
+    if (!ok) {
+        write_error(error, error_size, "Out of memory while formatting file sink batch.");
+    }
+
+    if (ok) {
+        pthread_mutex_lock(&state->mutex);
+        if (state->segment_used > 0 && state->segment_used + buffer.length > state->segment_bytes) {
+            int previous = state->fd;
+            if (open_segment(state, state->seq + 1)) {
+                close(previous);
+            } else {
+                logger_log(state->logger,
+                           LOGGER_ERROR,
+                           "sink",
+                           "failed to roll file sink segment: %s",
+                           strerror(errno));
+            }
+        }
+
+        size_t start = state->segment_used;
+        ok = write_all(state->fd, buffer.data, buffer.length) &&
+             (!state->fsync_enabled || file_sink_sync_fd(state->fd) == 0);
+        if (ok) {
+            state->segment_used += buffer.length;
+        } else if (ftruncate(state->fd, (off_t)start) != 0) {
+            /*
+             * The failed batch is retried, so its bytes must not stay in the
+             * segment. If they cannot be cut back off, leave the torn tail
+             * behind and continue in a new segment.
+             */
+            int previous = state->fd;
+            if (open_segment(state, state->seq + 1)) {
+                close(previous);
+            } else {
+                logger_log(state->logger,
+                           LOGGER_ERROR,
+                           "sink",
+                           "failed to truncate or roll torn file sink segment: %s",
+                           strerror(errno));
+            }
+        }
+        pthread_mutex_unlock(&state->mutex);
+
+        if (!ok) {
+            write_error(error, error_size, "Failed to write file sink segment.");
+        }
+    }
+    free(buffer.data);
+
+    if (!ok) {
+        while (batch->head != NULL) {
+            linked_list_push_back(failed, linked_list_pop_front(batch));
+        }
+    }
+    return ok;
+}
+
+static int file_flush(Sink *sink, char *error, size_t error_size) {
+    FileSinkState *state = (FileSinkState *)sink->state;
+
+    pthread_mutex_lock(&state->mutex);
+    int ok = file_sink_sync_fd(state->fd) == 0;
+    pthread_mutex_unlock(&state->mutex);
+
+    if (!ok) {
+        write_error(error, error_size, "Failed to sync file sink segment.");
+    }
+    return ok;
+}
+
+static int file_health(Sink *sink, char *error, size_t error_size) {
+    FileSinkState *state = (FileSinkState *)sink->state;
+    if (access(state->dir, W_OK) != 0) {
+        write_error(error, error_size, "File sink directory is not writable.");
+        return 0;
+    }
+    return 1;
+}
+
+static void file_close(Sink *sink) {
+    FileSinkState *state = (FileSinkState *)sink->state;
+    file_sink_sync_fd(state->fd);
+    close(state->fd);
+    pthread_mutex_destroy(&state->mutex);
+    free(state);
+}
+
+const SinkOps SINK_FILE_OPS = {
+    .name = "file",
+    .open = file_open,
+    .reserve = NULL,
+    .write_batch = file_write_batch,
+    .flush = file_flush,
+    .health = file_health,
+    .available = NULL,
+    .record_metrics = NULL,
+    .close = file_close,
+};
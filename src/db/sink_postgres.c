@@ -0,0 +1,102 @@
+#include "sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* PostgreSQL sink: a thin adapter over the pooled persistence layer. */
+
+static void write_error(char *error, size_t error_size, const char *message) {
+    if (error != NULL && error_size > 0) {
+        snprintf(error, error_size, "%s", message);
+    }
+}
+
+static int postgres_open(Sink *sink, const AppConfig *config, AppLogger *logger, char *error, size_t error_size) {
+    Persistence *persistence = calloc(1, sizeof(*persistence));
+    if (persistence == NULL) {
+        write_error(error, error_size, "Out of memory while allocating persistence.");
+        return 0;
+    }
+
+    if (!persistence_init(persistence, config, logger, error, error_size)) {
+        free(persistence);
+        return 0;
+    }
+
+    sink->state = persistence;
+    sink->ordered = persistence->source_affinity;
+    return 1;
+}
+
+/* Routes are taken under the processor's dispatch lock so tickets follow dequeue order. */
+static void *postgres_reserve(Sink *sink, LinkedList *batch) {
+    Persistence *persistence = (Persistence *)sink->state;
+    if (!persistence->source_affinity) {
+        return NULL;
+    }
+
+    PersistenceRoute *route = malloc(sizeof(*route));
+    if (route == NULL) {
+        return NULL;
+    }
+
+    persistence_route_batch(persistence, batch, route);
+    return route;
+}
+
+static int postgres_write_batch(Sink *sink,
+                                size_t slot,
+                                void *reservation,
+                                LinkedList *batch,
+                                int64_t processed_at_ms,
+                                LinkedList *failed,
+                                char *error,
+                                size_t error_size) {
+    Persistence *persistence = (Persistence *)sink->state;
+    if (reservation == NULL) {
+        return persistence_write_batch(persistence, slot, batch, processed_at_ms, failed, error, error_size);
+    }
+
+    PersistenceRoute *route = (PersistenceRoute *)reservation;
+    int written = persistence_write_routed(persistence, route, processed_at_ms, batch, failed, error, error_size);
+    free(route);
+    return written;
+}
+
+/* Every committed batch is already durable in PostgreSQL. */
+static int postgres_flush(Sink *sink, char *error, size_t error_size) {
+    (void)sink;
+    (void)error;
+    (void)error_size;
+    return 1;
+}
+
+static int postgres_health(Sink *sink, char *error, size_t error_size) {
+    return persistence_ping((Persistence *)sink->state, error, error_size);
+}
+
+static int postgres_available(Sink *sink) {
+    return persistence_breaker_allows((Persistence *)sink->state);
+}
+
+static int postgres_record_metrics(Sink *sink, const EngineMetrics *metrics, char *error, size_t error_size) {
+    return persistence_insert_metrics((Persistence *)sink->state, metrics, error, error_size);
+}
+
+static void postgres_close(Sink *sink) {
+    Persistence *persistence = (Persistence *)sink->state;
+    persistence_close(persistence);
+    free(persistence);
+}
+
+const SinkOps SINK_POSTGRES_OPS = {
+    .name = "postgres",
+    .open = postgres_open,
+    .reserve = postgres_reserve,
+    .write_batch = postgres_write_batch,
+    .flush = postgres_flush,
+    .health = postgres_health,
+    .available = postgres_available,
+    .record_metrics = postgres_record_metrics,
+    .close = postgres_close,
+};
@@ -97,6 +97,6 @@ int main(void) {
         return 1;
     }
 
-    printf("Shutdown complete.\n");
+    printf("Shutdown complete: %s\n", engine_shutdown_report());
     return 0;
 }
@@ -54,19 +54,71 @@ int config_load_from_env(AppConfig *config, char *error, size_t error_size) {
         return 0;
     }
 
+    config->sink_kind = sink_kind_from_string(env_or_default("SINK", "postgres"));
+    snprintf(config->sink_file_dir, sizeof(config->sink_file_dir), "%s", env_or_default("SINK_FILE_DIR", "sink"));
+    config->sink_file_segment_bytes = parse_size_env("SINK_FILE_SEGMENT_BYTES", 67108864);
+    config->sink_file_fsync = parse_int_env("SINK_FILE_FSYNC", 0) != 0;
+
     snprintf(config->db_host, sizeof(config->db_host), "%s", env_or_default("DB_HOST", "127.0.0.1"));
     config->db_port = parse_int_env("DB_PORT", 5432);
     snprintf(config->db_name, sizeof(config->db_name), "%s", env_or_default("DB_NAME", "log_engine"));
     snprintf(config->db_user, sizeof(config->db_user), "%s", env_or_default("DB_USER", "log_engine"));
     snprintf(config->db_password, sizeof(config->db_password), "%s", env_or_default("DB_PASSWORD", "log_engine"));
     config->db_connect_timeout = parse_int_env("DB_CONNECT_TIMEOUT", 5);
+    config->db_write_mode = db_write_mode_from_string(env_or_default("DB_WRITE_MODE", "copy"));
+    config->db_pipeline_depth = parse_size_env("DB_PIPELINE_DEPTH", 128);
+    config->db_pool_size = parse_size_env("DB_POOL_SIZE", 1);
+    config->db_source_affinity = parse_int_env("DB_SOURCE_AFFINITY", 0) != 0;
+    config->db_breaker_failures = parse_int_env("DB_BREAKER_FAILURES", 3);
+    config->db_reconnect_backoff_ms = parse_int_env("DB_RECONNECT_BACKOFF_MS", 500);
+    config->db_reconnect_backoff_max_ms = parse_int_env("DB_RECONNECT_BACKOFF_MAX_MS", 30000);
 
     config->buffer_capacity = parse_size_env("BUFFER_CAPACITY", 2048);
     config->auto_process_threshold = parse_size_env("AUTO_PROCESS_THRESHOLD", 256);
     config->process_batch_size = parse_size_env("PROCESS_BATCH_SIZE", 200);
+    config->process_batch_mode = batch_size_mode_from_string(env_or_default("PROCESS_BATCH_MODE", "static"));
+    config->process_batch_min = parse_size_env("PROCESS_BATCH_MIN", 50);
+    config->process_batch_max = parse_size_env("PROCESS_BATCH_MAX", 5000);
+    config->process_batch_target_ms = parse_int_env("PROCESS_BATCH_TARGET_MS", 250);
     config->pending_preview_limit = parse_size_env("PENDING_PREVIEW_LIMIT", 200);
+    snprintf(config->dead_letter_path,
+             sizeof(config->dead_letter_path),
+             "%s",
+             env_or_default("DEAD_LETTER_PATH", "dead_letter.jsonl"));
+    config->dead_letter_max_attempts = (unsigned int)parse_size_env("DEAD_LETTER_MAX_ATTEMPTS", 3);
+    config->spill_enabled = parse_int_env("SPILL_ENABLED", 0) != 0;
+    snprintf(config->spill_dir, sizeof(config->spill_dir), "%s", env_or_default("SPILL_DIR", "spill"));
+    config->spill_segment_bytes = parse_size_env("SPILL_SEGMENT_BYTES", 67108864);
+    config->spill_max_bytes = parse_size_env("SPILL_MAX_BYTES", 4294967296UL);
+    config->journal_enabled = parse_int_env("JOURNAL_ENABLED", 0) != 0;
+    snprintf(config->journal_dir, sizeof(config->journal_dir), "%s", env_or_default("JOURNAL_DIR", "journal"));
+    config->journal_segment_bytes = parse_size_env("JOURNAL_SEGMENT_BYTES", 16777216);
+    config->journal_fsync = parse_int_env("JOURNAL_FSYNC", 1) != 0;
+    config->processor_threads = parse_size_env("PROCESSOR_THREADS", 1);
+    config->processor_linger_ms = parse_int_env("PROCESSOR_LINGER_MS", 1000);
+    config->process_max_linger_ms = parse_int_env("PROCESS_MAX_LINGER_MS", 0);
+    config->shutdown_drain_timeout_ms = parse_int_env("SHUTDOWN_DRAIN_TIMEOUT_MS", 10000);
+    config->shutdown_snapshot = parse_int_env("SHUTDOWN_SNAPSHOT", 1) != 0;
+    snprintf(config->snapshot_path, sizeof(config->snapshot_path), "%s", env_or_default("SNAPSHOT_PATH", "buffer.snapshot"));
+    config->buffer_queue_backend = buffer_queue_backend_from_string(env_or_default("BUFFER_QUEUE_BACKEND", "list"));
+    config->buffer_ingest_mode = buffer_ingest_mode_from_string(env_or_default("BUFFER_INGEST_MODE", "mutex"));
+    snprintf(config->buffer_lanes, sizeof(config->buffer_lanes), "%s", env_or_default("BUFFER_LANES", ""));
+    snprintf(config->buffer_lane_weights,
+             sizeof(config->buffer_lane_weights),
+             "%s",
+             env_or_default("BUFFER_LANE_WEIGHTS", ""));
+    snprintf(config->buffer_lane_capacities,
+             sizeof(config->buffer_lane_capacities),
+             "%s",
+             env_or_default("BUFFER_LANE_CAPACITIES", ""));
+    config->buffer_lane_schedule = buffer_lane_schedule_from_string(env_or_default("BUFFER_LANE_SCHEDULE", "weighted"));
     config->api_port = parse_int_env("API_PORT", 8000);
 
+    config->entry_arena_enabled = parse_int_env("ENTRY_ARENA", 0) != 0;
+    config->entry_arena_slot_bytes = parse_size_env("ENTRY_ARENA_SLOT_BYTES", 0);
+    config->entry_arena_pages = entry_arena_page_mode_from_string(env_or_default("ENTRY_ARENA_HUGE_PAGES", "off"));
+    config->entry_arena_prefault = parse_int_env("ENTRY_ARENA_PREFAULT", 0) != 0;
+
     const char *level = env_or_default("LOG_LEVEL", "INFO");
     config->log_level = logger_level_from_string(level);
 
@@ -83,13 +135,99 @@ int config_load_from_env(AppConfig *config, char *error, size_t error_size) {
         config->process_batch_size = 1;
     }
 
+    if (config->process_batch_min == 0) {
+        config->process_batch_min = 1;
+    }
+
+    if (config->process_batch_max < config->process_batch_min) {
+        config->process_batch_max = config->process_batch_min;
+    }
+
+    if (config->process_batch_target_ms <= 0) {
+        config->process_batch_target_ms = 250;
+    }
+
     if (config->pending_preview_limit == 0) {
         config->pending_preview_limit = 50;
     }
 
+    if (config->journal_segment_bytes == 0) {
+        config->journal_segment_bytes = 16777216;
+    }
+
+    if (config->processor_linger_ms < 0) {
+        config->processor_linger_ms = 0;
+    }
+
+    if (config->process_max_linger_ms < 0) {
+        config->process_max_linger_ms = 0;
+    }
+
+    if (config->shutdown_drain_timeout_ms < 0) {
+        config->shutdown_drain_timeout_ms = 0;
+    }
+
     return 1;
 }
 
+SinkKind sink_kind_from_string(const char *text) {
+    if (text != NULL && strcmp(text, "file") == 0) {
+        return SINK_FILE;
+    }
+    if (text != NULL && strcmp(text, "null") == 0) {
+        return SINK_NULL;
+    }
+
+    return SINK_POSTGRES;
+}
+
+const char *sink_kind_to_string(SinkKind kind) {
+    switch (kind) {
+        case SINK_FILE:
+            return "file";
+        case SINK_NULL:
+            return "null";
+        case SINK_POSTGRES:
+        default:
+            return "postgres";
+    }
+}
+
+BatchSizeMode batch_size_mode_from_string(const char *text) {
+    if (text != NULL && strcmp(text, "adaptive") == 0) {
+        return BATCH_SIZE_ADAPTIVE;
+    }
+
+    return BATCH_SIZE_STATIC;
+}
+
+const char *batch_size_mode_to_string(BatchSizeMode mode) {
+    return mode == BATCH_SIZE_ADAPTIVE ? "adaptive" : "static";
+}
+
+DbWriteMode db_write_mode_from_string(const char *text) {
+    if (text != NULL && strcmp(text, "transaction") == 0) {
+        return DB_WRITE_TRANSACTION;
+    }
+    if (text != NULL && strcmp(text, "pipeline") == 0) {
+        return DB_WRITE_PIPELINE;
+    }
+
+    return DB_WRITE_COPY;
+}
+
+const char *db_write_mode_to_string(DbWriteMode mode) {
+    switch (mode) {
+        case DB_WRITE_TRANSACTION:
+            return "transaction";
+        case DB_WRITE_PIPELINE:
+            return "pipeline";
+        case DB_WRITE_COPY:
+        default:
+            return "copy";
+    }
+}
+
 int config_build_conninfo(const AppConfig *config, char *buffer, size_t buffer_size) {
     if (config == NULL || buffer == NULL || buffer_size == 0) {
         return 0;
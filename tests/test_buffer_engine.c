@@ -1,19 +1,50 @@
 #include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "buffer_engine.h"
 #include "logger.h"
+#include "spill_queue.h"
 
-int main(void) {
-    AppLogger logger;
+#define PRODUCER_THREADS 4
+#define PRODUCER_ATTEMPTS 5000
+#define PRODUCER_CAPACITY 12000
+#define SPILL_TEST_DIR "build/test_spill.d"
+#define SPILL_TEST_ENTRIES 40
+
+typedef struct {
+    BufferEngine *engine;
+    size_t accepted;
+} ProducerArgs;
+
+static void *producer_main(void *arg) {
+    ProducerArgs *args = (ProducerArgs *)arg;
     char error[256] = {0};
 
-    assert(logger_init(&logger, LOGGER_ERROR, stderr));
+    for (size_t i = 0; i < PRODUCER_ATTEMPTS; ++i) {
+        if (buffer_engine_enqueue(args->engine, "INFO", "producer", "payload", error, sizeof(error))) {
+            args->accepted++;
+        }
+    }
+
+    return NULL;
+}
+
+static void test_fifo_and_capacity(AppLogger *logger, BufferQueueBackend backend, BufferIngestMode ingest_mode) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, 3);
+    options.queue_backend = backend;
+    options.ingest_mode = ingest_mode;
 
     BufferEngine engine;
-    assert(buffer_engine_init(&engine, 3, &logger, error, sizeof(error)));
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
 
     assert(buffer_engine_enqueue(&engine, "INFO", "tests", "one", error, sizeof(error)));
     assert(buffer_engine_enqueue(&engine, "INFO", "tests", "two", error, sizeof(error)));
@@ -25,17 +56,596 @@ int main(void) {
     EngineMetrics metrics;
     assert(buffer_engine_get_metrics(&engine, &metrics));
     assert(metrics.queue_depth == 3);
+    assert(metrics.memory_bytes_estimate < 3 * (sizeof(LogEntry) + 64));
 
     char json[2048] = {0};
     assert(buffer_engine_pending_json(&engine, 2, json, sizeof(json)));
     assert(strstr(json, "\"returned\":2") != NULL);
+    assert(strstr(json, "\"one\"") != NULL && strstr(json, "\"two\"") != NULL);
 
     LogEntry *entry = NULL;
     assert(buffer_engine_dequeue(&engine, &entry));
     assert(entry != NULL);
-    free(entry);
+    assert(strcmp(log_entry_message(entry), "one") == 0);
+
+    assert(buffer_engine_requeue_front(&engine, entry, error, sizeof(error)));
+    assert(buffer_engine_dequeue(&engine, &entry));
+    assert(strcmp(log_entry_message(entry), "one") == 0);
+    buffer_engine_release_entry(&engine, entry);
+
+    assert(buffer_engine_dequeue(&engine, &entry));
+    assert(strcmp(log_entry_message(entry), "two") == 0);
+    buffer_engine_release_entry(&engine, entry);
+
+    buffer_engine_shutdown(&engine);
+}
+
+static void test_batch_dequeue(AppLogger *logger, BufferQueueBackend backend) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, 5);
+    options.queue_backend = backend;
+
+    BufferEngine engine;
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
+
+    const char *messages[] = {"m1", "m2", "m3", "m4", "m5"};
+    for (size_t i = 0; i < 5; ++i) {
+        assert(buffer_engine_enqueue(&engine, "INFO", "tests", messages[i], error, sizeof(error)));
+    }
+
+    LinkedList batch;
+    linked_list_init(&batch);
+    assert(buffer_engine_dequeue_batch(&engine, 3, &batch) == 3);
+    assert(linked_list_size(&batch) == 3);
+    assert(strcmp(log_entry_message(batch.head), "m1") == 0);
+    assert(strcmp(log_entry_message(batch.tail), "m3") == 0);
+    assert(buffer_engine_queue_depth(&engine) == 2);
+
+    LogEntry *done = linked_list_pop_front(&batch);
+    buffer_engine_release_entry(&engine, done);
+
+    assert(buffer_engine_requeue_front_batch(&engine, &batch, error, sizeof(error)));
+    assert(linked_list_size(&batch) == 0);
+    assert(buffer_engine_queue_depth(&engine) == 4);
+
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", "m6", error, sizeof(error)));
+    assert(buffer_engine_dequeue_batch(&engine, 10, &batch) == 5);
+    const char *expected[] = {"m2", "m3", "m4", "m5", "m6"};
+    size_t index = 0;
+    for (const LogEntry *cursor = batch.head; cursor != NULL; cursor = cursor->next) {
+        assert(strcmp(log_entry_message(cursor), expected[index]) == 0);
+        index++;
+    }
+    assert(index == 5);
+
+    /* Only what fits goes back; the rest stays with the caller. */
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", "m7", error, sizeof(error)));
+    assert(!buffer_engine_requeue_front_batch(&engine, &batch, error, sizeof(error)));
+    assert(linked_list_size(&batch) == 1);
+    assert(strcmp(log_entry_message(batch.head), "m6") == 0);
+    buffer_engine_release_batch(&engine, &batch);
+
+    LogEntry *entry = NULL;
+    assert(buffer_engine_dequeue(&engine, &entry));
+    assert(strcmp(log_entry_message(entry), "m2") == 0);
+    buffer_engine_release_entry(&engine, entry);
+
+    buffer_engine_shutdown(&engine);
+}
+
+static void test_batch_enqueue(AppLogger *logger, BufferIngestMode ingest_mode) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, 3);
+    options.ingest_mode = ingest_mode;
+
+    BufferEngine engine;
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", "single", error, sizeof(error)));
+
+    BufferLogInput items[] = {
+        {"INFO", "tests", "b1"},
+        {"INFO", "tests", ""},
+        {"ERROR", "tests", "b2"},
+        {"INFO", "tests", "b3"},
+    };
+    int statuses[4] = {-1, -1, -1, -1};
+
+    assert(buffer_engine_enqueue_batch(&engine, items, 4, statuses, error, sizeof(error)) == 2);
+    assert(statuses[0] == BUFFER_ENQUEUE_OK);
+    assert(statuses[1] == BUFFER_ENQUEUE_INVALID);
+    assert(statuses[2] == BUFFER_ENQUEUE_OK);
+    assert(statuses[3] == BUFFER_ENQUEUE_FULL);
+
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.total_ingested == 3);
+    assert(metrics.total_errors == 2);
+    assert(metrics.queue_depth == 3);
+
+    LinkedList batch;
+    linked_list_init(&batch);
+    assert(buffer_engine_dequeue_batch(&engine, 3, &batch) == 3);
+    assert(batch.head->id == 1);
+    assert(strcmp(log_entry_message(batch.head->next), "b1") == 0 && batch.head->next->id == 2);
+    assert(strcmp(log_entry_message(batch.tail), "b2") == 0 && batch.tail->id == 3);
+    buffer_engine_release_batch(&engine, &batch);
+
+    buffer_engine_shutdown(&engine);
+}
+
+static void test_arena(AppLogger *logger) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, 2);
+    options.use_arena = 1;
+    options.arena_slot_size = sizeof(LogEntry) + 32;
+    options.arena_headroom = 1;
+
+    BufferEngine engine;
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", "slot", error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine,
+                                 "INFO",
+                                 "tests",
+                                 "this message is longer than the arena slot",
+                                 error,
+                                 sizeof(error)));
+
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.arena_slots_total == 3);
+    assert(metrics.arena_slots_in_use == 1);
+    assert(metrics.arena_fallback_allocs == 1);
+
+    LogEntry *entry = NULL;
+    assert(buffer_engine_dequeue(&engine, &entry));
+    assert(entry_arena_owns(&engine.arena, entry));
+    buffer_engine_release_entry(&engine, entry);
+
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.arena_slots_in_use == 0);
+    assert(metrics.arena_high_water == 1);
+
+    buffer_engine_shutdown(&engine);
+}
+
+static void test_spill_overflow(AppLogger *logger) {
+    char error[256] = {0};
+
+    BufferEngine engine;
+    assert(buffer_engine_init(&engine, 2, logger, error, sizeof(error)));
+
+    /* The smallest allowed segment, so the queue crosses several files. */
+    SpillQueue spill;
+    assert(spill_queue_open(&spill, SPILL_TEST_DIR, 1, 0, logger, error, sizeof(error)));
+    buffer_engine_attach_spill(&engine, &spill);
+
+    char message[32];
+    for (size_t i = 0; i < SPILL_TEST_ENTRIES - 2; ++i) {
+        snprintf(message, sizeof(message), "m%zu", i);
+        assert(buffer_engine_enqueue(&engine, "INFO", "tests", message, error, sizeof(error)));
+    }
+
+    BufferLogInput items[] = {
+        {"INFO", "tests", "m38"},
+        {"INFO", "tests", "m39"},
+    };
+    int statuses[2] = {-1, -1};
+    assert(buffer_engine_enqueue_batch(&engine, items, 2, statuses, error, sizeof(error)) == 2);
+    assert(statuses[0] == BUFFER_ENQUEUE_OK && statuses[1] == BUFFER_ENQUEUE_OK);
+
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.queue_depth == 2);
+    assert(metrics.spilled_entries == SPILL_TEST_ENTRIES - 2);
+    assert(metrics.spill_segments > 1);
+    assert(buffer_engine_queue_depth(&engine) == SPILL_TEST_ENTRIES);
+
+    /* Paging in never takes the room a failed batch needs to go back. */
+    LinkedList batch;
+    linked_list_init(&batch);
+    assert(buffer_engine_dequeue_batch(&engine, 2, &batch) == 2);
+    assert(buffer_engine_dequeue_batch(&engine, 2, &batch) == 0);
+    assert(buffer_engine_requeue_front_batch(&engine, &batch, error, sizeof(error)));
+
+    size_t expected = 0;
+    while (buffer_engine_dequeue_batch(&engine, 2, &batch) > 0) {
+        for (const LogEntry *cursor = batch.head; cursor != NULL; cursor = cursor->next) {
+            snprintf(message, sizeof(message), "m%zu", expected++);
+            assert(strcmp(log_entry_message(cursor), message) == 0);
+        }
+        buffer_engine_release_batch(&engine, &batch);
+    }
+    assert(expected == SPILL_TEST_ENTRIES);
 
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.spilled_entries == 0 && metrics.spilled_bytes == 0);
+    assert(metrics.spill_segments <= 1);
+    assert(metrics.spilled_total == SPILL_TEST_ENTRIES - 2);
+    assert(metrics.paged_in_total == SPILL_TEST_ENTRIES - 2);
+
+    /* New entries do not take the room of a batch in flight; they spill instead. */
+    const char *late[] = {"n0", "n1", "n2", "n3", "n4"};
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", late[0], error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", late[1], error, sizeof(error)));
+    assert(buffer_engine_dequeue_batch(&engine, 2, &batch) == 2);
+    for (size_t i = 2; i < 5; ++i) {
+        assert(buffer_engine_enqueue(&engine, "INFO", "tests", late[i], error, sizeof(error)));
+    }
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.queue_depth == 0 && metrics.spilled_entries == 3);
+    assert(buffer_engine_requeue_front_batch(&engine, &batch, error, sizeof(error)));
+    assert(linked_list_size(&batch) == 0);
+
+    expected = 0;
+    while (buffer_engine_dequeue_batch(&engine, 2, &batch) > 0) {
+        for (const LogEntry *cursor = batch.head; cursor != NULL; cursor = cursor->next) {
+            assert(strcmp(log_entry_message(cursor), late[expected++]) == 0);
+        }
+        buffer_engine_release_batch(&engine, &batch);
+    }
+    assert(expected == 5);
     buffer_engine_shutdown(&engine);
+
+    /* A full lane rejects batch items headed for the spill tier too. */
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, 2);
+    assert(buffer_engine_parse_lanes(&options, "high=ERROR;low=*", NULL, ",1", error, sizeof(error)));
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
+    buffer_engine_attach_spill(&engine, &spill);
+
+    BufferLogInput laned[] = {
+        {"DEBUG", "tests", "d1"},
+        {"DEBUG", "tests", "d2"},
+        {"ERROR", "tests", "e1"},
+        {"DEBUG", "tests", "d3"},
+    };
+    int laned_statuses[4] = {-1, -1, -1, -1};
+    assert(buffer_engine_enqueue_batch(&engine, laned, 4, laned_statuses, error, sizeof(error)) == 2);
+    assert(laned_statuses[1] == BUFFER_ENQUEUE_FULL && laned_statuses[3] == BUFFER_ENQUEUE_FULL);
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.spilled_entries == 1 && metrics.lanes[1].rejected == 2);
+
+    while (buffer_engine_dequeue_batch(&engine, 2, &batch) > 0) {
+        buffer_engine_release_batch(&engine, &batch);
+    }
+    buffer_engine_shutdown(&engine);
+    spill_queue_close(&spill);
+
+    /* A spilled frame that no longer decodes is skipped and counted, not lost silently. */
+    assert(spill_queue_open(&spill, SPILL_TEST_DIR, 1, 0, logger, error, sizeof(error)));
+    assert(buffer_engine_init(&engine, 1, logger, error, sizeof(error)));
+    buffer_engine_attach_spill(&engine, &spill);
+    const char *corrupt[] = {"c0", "c1", "c2"};
+    for (size_t i = 0; i < 3; ++i) {
+        assert(buffer_engine_enqueue(&engine, "INFO", "tests", corrupt[i], error, sizeof(error)));
+    }
+
+    char path[320];
+    DIR *handle = opendir(SPILL_TEST_DIR);
+    assert(handle != NULL);
+    struct dirent *item = NULL;
+    path[0] = '\0';
+    while ((item = readdir(handle)) != NULL) {
+        if (item->d_name[0] != '.') {
+            snprintf(path, sizeof(path), SPILL_TEST_DIR "/%s", item->d_name);
+        }
+    }
+    closedir(handle);
+
+    /* Overwrite the level terminator of c1's record, the first frame in the segment. */
+    const unsigned char garbage = 'x';
+    int fd = open(path, O_WRONLY);
+    assert(fd >= 0);
+    assert(pwrite(fd, &garbage, 1, 8 + LOG_ENTRY_RECORD_HEADER_SIZE + strlen("INFO")) == 1);
+    close(fd);
+
+    expected = 0;
+    const char *survivors[] = {"c0", "c2"};
+    while (buffer_engine_dequeue_batch(&engine, 1, &batch) > 0) {
+        assert(strcmp(log_entry_message(batch.head), survivors[expected++]) == 0);
+        buffer_engine_release_batch(&engine, &batch);
+    }
+    assert(expected == 2);
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.spilled_entries == 0 && metrics.total_errors == 1);
+    buffer_engine_shutdown(&engine);
+    spill_queue_close(&spill);
+    assert(rmdir(SPILL_TEST_DIR) == 0);
+}
+
+static void test_concurrent_producers(AppLogger *logger, BufferIngestMode ingest_mode, int use_arena) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, PRODUCER_CAPACITY);
+    options.ingest_mode = ingest_mode;
+    options.use_arena = use_arena;
+
+    BufferEngine engine;
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
+
+    pthread_t threads[PRODUCER_THREADS];
+    ProducerArgs args[PRODUCER_THREADS];
+    for (size_t i = 0; i < PRODUCER_THREADS; ++i) {
+        args[i].engine = &engine;
+        args[i].accepted = 0;
+        assert(pthread_create(&threads[i], NULL, producer_main, &args[i]) == 0);
+    }
+
+    size_t accepted = 0;
+    for (size_t i = 0; i < PRODUCER_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+        accepted += args[i].accepted;
+    }
+
+    assert(accepted == PRODUCER_CAPACITY);
+
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.total_ingested == accepted);
+    assert(metrics.queue_depth == accepted);
+    assert(metrics.total_errors == (PRODUCER_THREADS * PRODUCER_ATTEMPTS) - accepted);
+
+    unsigned char *seen = (unsigned char *)calloc(accepted + 1, 1);
+    assert(seen != NULL);
+
+    size_t drained = 0;
+    LogEntry *entry = NULL;
+    while (buffer_engine_dequeue(&engine, &entry)) {
+        assert(entry->id >= 1 && entry->id <= accepted);
+        assert(!seen[entry->id]);
+        seen[entry->id] = 1;
+        buffer_engine_release_entry(&engine, entry);
+        drained++;
+    }
+
+    free(seen);
+    assert(drained == accepted);
+    assert(buffer_engine_queue_depth(&engine) == 0);
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.memory_bytes_estimate == 0);
+
+    buffer_engine_shutdown(&engine);
+}
+
+typedef struct {
+    BufferEngine *engine;
+    size_t target;
+} ConsumerArgs;
+
+static void *consumer_main(void *arg) {
+    ConsumerArgs *args = (ConsumerArgs *)arg;
+    LinkedList batch;
+    linked_list_init(&batch);
+
+    size_t done = 0;
+    while (done < args->target) {
+        size_t taken = buffer_engine_dequeue_batch(args->engine, 64, &batch);
+        if (taken > 0) {
+            buffer_engine_mark_processed_batch(args->engine, taken, 1.0);
+            buffer_engine_release_batch(args->engine, &batch);
+            done += taken;
+        }
+    }
+
+    return NULL;
+}
+
+/* Metrics are read without the queue lock while producers and a consumer run. */
+static void test_metrics_snapshot_consistency(AppLogger *logger) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, PRODUCER_CAPACITY);
+    options.ingest_mode = BUFFER_INGEST_LOCKFREE;
+
+    BufferEngine engine;
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
+
+    pthread_t threads[PRODUCER_THREADS];
+    ProducerArgs args[PRODUCER_THREADS];
+    for (size_t i = 0; i < PRODUCER_THREADS; ++i) {
+        args[i].engine = &engine;
+        args[i].accepted = 0;
+        assert(pthread_create(&threads[i], NULL, producer_main, &args[i]) == 0);
+    }
+
+    /* Capacity is recycled by the consumer, so every attempt is eventually accepted or rejected. */
+    ConsumerArgs consumer_args = {&engine, PRODUCER_CAPACITY};
+    pthread_t consumer;
+    assert(pthread_create(&consumer, NULL, consumer_main, &consumer_args) == 0);
+
+    uint64_t last_processed = 0;
+    EngineMetrics metrics;
+    for (;;) {
+        assert(buffer_engine_get_metrics(&engine, &metrics));
+        assert(metrics.total_processed <= metrics.total_ingested);
+        assert(metrics.total_processed >= last_processed);
+        last_processed = metrics.total_processed;
+        if (last_processed >= PRODUCER_CAPACITY) {
+            break;
+        }
+    }
+
+    size_t accepted = 0;
+    for (size_t i = 0; i < PRODUCER_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+        accepted += args[i].accepted;
+    }
+    pthread_join(consumer, NULL);
+
+    LinkedList rest;
+    linked_list_init(&rest);
+    size_t leftover = buffer_engine_dequeue_batch(&engine, accepted, &rest);
+    buffer_engine_release_batch(&engine, &rest);
+
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.total_ingested == accepted);
+    assert(metrics.total_processed + leftover == accepted);
+    assert(metrics.total_ingested + metrics.total_errors == PRODUCER_THREADS * PRODUCER_ATTEMPTS);
+    assert(metrics.last_processing_ms == 1.0);
+    assert(metrics.last_processed_at_ms >= metrics.started_at_ms);
+
+    buffer_engine_shutdown(&engine);
+}
+
+static void test_latency_histogram(AppLogger *logger) {
+    LatencyHistogram histogram;
+    assert(latency_histogram_init(&histogram));
+
+    for (uint64_t micros = 1; micros <= 1000; ++micros) {
+        latency_histogram_record(&histogram, micros, 1);
+    }
+    latency_histogram_record(&histogram, 5000000, 10);
+
+    LatencySummary summary;
+    latency_histogram_summarize(&histogram, &summary);
+    assert(summary.count == 1010);
+    /* Log buckets keep percentiles within one sub-bucket (12.5%) above the true value. */
+    assert(summary.p50_ms >= 0.505 && summary.p50_ms <= 0.505 * 1.125);
+    assert(summary.p95_ms >= 0.960 && summary.p95_ms <= 0.960 * 1.125);
+    assert(summary.p99_ms >= 1.0 && summary.p99_ms <= 1.125);
+    assert(summary.max_ms == 5000.0);
+
+    latency_histogram_reset_window(&histogram);
+    latency_histogram_summarize(&histogram, &summary);
+    assert(summary.count == 0 && summary.p99_ms == 0.0 && summary.max_ms == 0.0);
+
+    latency_histogram_record(&histogram, 3, 4);
+    latency_histogram_summarize(&histogram, &summary);
+    assert(summary.count == 4 && summary.p50_ms == 0.003 && summary.max_ms == 0.003);
+    latency_histogram_destroy(&histogram);
+
+    char error[256] = {0};
+    BufferEngine engine;
+    assert(buffer_engine_init(&engine, 8, logger, error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", "timed", error, sizeof(error)));
+    BufferLogInput items[2] = {{"INFO", "tests", "a"}, {"INFO", "tests", "b"}};
+    assert(buffer_engine_enqueue_batch(&engine, items, 2, NULL, error, sizeof(error)) == 2);
+
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.latency[ENGINE_LATENCY_ENQUEUE].count == 2);
+    assert(metrics.latency[ENGINE_LATENCY_QUEUE_WAIT].count == 0);
+
+    buffer_engine_reset_latency_window(&engine);
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.latency[ENGINE_LATENCY_ENQUEUE].count == 0);
+    assert(metrics.latency_window_started_at_ms >= metrics.started_at_ms);
+    buffer_engine_shutdown(&engine);
+}
+
+static void test_priority_lanes(AppLogger *logger,
+                                BufferQueueBackend backend,
+                                BufferIngestMode ingest_mode,
+                                BufferLaneSchedule schedule) {
+    char error[256] = {0};
+
+    BufferEngineOptions options;
+    buffer_engine_default_options(&options, 16);
+    assert(!buffer_engine_parse_lanes(&options, "bad-name=INFO", NULL, NULL, error, sizeof(error)));
+    assert(!buffer_engine_parse_lanes(&options, "high=ERROR", "x", NULL, error, sizeof(error)));
+    assert(buffer_engine_parse_lanes(&options,
+                                     "high=ERROR, CRITICAL;normal=INFO,WARNING;low=*",
+                                     "2",
+                                     ",,2",
+                                     error,
+                                     sizeof(error)));
+    assert(options.lane_count == 3);
+    assert(strcmp(options.lanes[0].levels, "ERROR,CRITICAL") == 0);
+    assert(options.lanes[0].weight == 2 && options.lanes[1].weight == 1 && options.lanes[2].weight == 1);
+    assert(options.lanes[0].capacity == 0 && options.lanes[2].capacity == 2);
+    options.queue_backend = backend;
+    options.ingest_mode = ingest_mode;
+    options.lane_schedule = schedule;
+
+    BufferEngine engine;
+    assert(buffer_engine_init_with_options(&engine, &options, logger, error, sizeof(error)));
+
+    BufferLogInput items[] = {
+        {"DEBUG", "tests", "d1"},
+        {"TRACE", "tests", "d2"},
+        {"DEBUG", "tests", "d3"},
+        {"INFO", "tests", "i1"},
+    };
+    int statuses[4] = {-1, -1, -1, -1};
+    assert(buffer_engine_enqueue_batch(&engine, items, 4, statuses, error, sizeof(error)) == 3);
+    assert(statuses[2] == BUFFER_ENQUEUE_FULL);
+    assert(!buffer_engine_enqueue(&engine, "DEBUG", "tests", "d4", error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "WARNING", "tests", "i2", error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "ERROR", "tests", "e1", error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "error", "tests", "e2", error, sizeof(error)));
+    assert(buffer_engine_enqueue(&engine, "CRITICAL", "tests", "e3", error, sizeof(error)));
+
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.lane_count == 3 && metrics.queue_depth == 7);
+    assert(strcmp(metrics.lanes[0].name, "high") == 0 && metrics.lanes[0].depth == 3);
+    assert(metrics.lanes[1].depth == 2);
+    assert(metrics.lanes[2].depth == 2 && metrics.lanes[2].rejected == 2);
+
+    /* Weighted: two from "high", then one each from the others, round after round. */
+    const char *weighted[] = {"e1", "e2", "i1", "d1", "e3", "i2", "d2"};
+    const char *strict[] = {"e1", "e2", "e3", "i1", "i2", "d1", "d2"};
+    const char **expected = schedule == BUFFER_LANES_STRICT ? strict : weighted;
+
+    LinkedList batch;
+    linked_list_init(&batch);
+    assert(buffer_engine_dequeue_batch(&engine, 16, &batch) == 7);
+    size_t index = 0;
+    for (const LogEntry *cursor = batch.head; cursor != NULL; cursor = cursor->next) {
+        assert(strcmp(log_entry_message(cursor), expected[index]) == 0);
+        index++;
+    }
+
+    /* Failed entries go back to the head of their own lane. */
+    assert(buffer_engine_requeue_front_batch(&engine, &batch, error, sizeof(error)));
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.lanes[0].depth == 3 && metrics.lanes[1].depth == 2 && metrics.lanes[2].depth == 2);
+
+    LogEntry *entry = NULL;
+    assert(buffer_engine_dequeue(&engine, &entry));
+    assert(strcmp(log_entry_message(entry), "e1") == 0);
+    buffer_engine_release_entry(&engine, entry);
+    assert(buffer_engine_dequeue_batch(&engine, 16, &batch) == 6);
+    assert(strcmp(log_entry_message(batch.tail), "d2") == 0);
+    buffer_engine_release_batch(&engine, &batch);
+
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.queue_depth == 0);
+    assert(metrics.lanes[0].depth == 0 && metrics.lanes[1].depth == 0 && metrics.lanes[2].depth == 0);
+
+    buffer_engine_shutdown(&engine);
+}
+
+int main(void) {
+    AppLogger logger;
+    assert(logger_init(&logger, LOGGER_ERROR, stderr));
+
+    test_fifo_and_capacity(&logger, BUFFER_QUEUE_LIST, BUFFER_INGEST_MUTEX);
+    test_fifo_and_capacity(&logger, BUFFER_QUEUE_RING, BUFFER_INGEST_MUTEX);
+    test_fifo_and_capacity(&logger, BUFFER_QUEUE_LIST, BUFFER_INGEST_LOCKFREE);
+    test_fifo_and_capacity(&logger, BUFFER_QUEUE_RING, BUFFER_INGEST_LOCKFREE);
+    test_batch_dequeue(&logger, BUFFER_QUEUE_LIST);
+    test_batch_dequeue(&logger, BUFFER_QUEUE_RING);
+    test_batch_enqueue(&logger, BUFFER_INGEST_MUTEX);
+    test_batch_enqueue(&logger, BUFFER_INGEST_LOCKFREE);
+    test_arena(&logger);
+    test_spill_overflow(&logger);
+    test_concurrent_producers(&logger, BUFFER_INGEST_MUTEX, 0);
+    test_concurrent_producers(&logger, BUFFER_INGEST_LOCKFREE, 0);
+    test_concurrent_producers(&logger, BUFFER_INGEST_LOCKFREE, 1);
+    test_metrics_snapshot_consistency(&logger);
+    test_latency_histogram(&logger);
+    test_priority_lanes(&logger, BUFFER_QUEUE_LIST, BUFFER_INGEST_MUTEX, BUFFER_LANES_WEIGHTED);
+    test_priority_lanes(&logger, BUFFER_QUEUE_RING, BUFFER_INGEST_LOCKFREE, BUFFER_LANES_STRICT);
+
     logger_close(&logger);
     return 0;
 }
@@ -0,0 +1,43 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dead_letter.h"
+#include "log_entry.h"
+
+#define DEAD_LETTER_TEST_PATH "build/test_dead_letter.jsonl"
+
+int main(void) {
+    remove(DEAD_LETTER_TEST_PATH);
+
+    char error[256] = {0};
+    DeadLetterStore store;
+    assert(dead_letter_open(&store, DEAD_LETTER_TEST_PATH, error, sizeof(error)));
+
+    LogEntry *entry = log_entry_create(42, "ERROR", "billing", "bad \"row\"\nline two", 1000);
+    assert(entry != NULL);
+    entry->attempts = 3;
+
+    assert(dead_letter_write(&store, entry, "invalid byte sequence", error, sizeof(error)));
+    assert(dead_letter_write(&store, entry, NULL, error, sizeof(error)));
+    dead_letter_close(&store);
+    log_entry_free(entry);
+
+    FILE *file = fopen(DEAD_LETTER_TEST_PATH, "r");
+    assert(file != NULL);
+
+    char line[1024] = {0};
+    assert(fgets(line, sizeof(line), file) != NULL);
+    assert(strstr(line, "\"id\":42") != NULL);
+    assert(strstr(line, "\"attempts\":3") != NULL);
+    assert(strstr(line, "\"message\":\"bad \\\"row\\\"\\nline two\"") != NULL);
+    assert(strstr(line, "\"reason\":\"invalid byte sequence\"") != NULL);
+
+    assert(fgets(line, sizeof(line), file) != NULL);
+    assert(strstr(line, "\"reason\":\"\"") != NULL);
+    assert(fgets(line, sizeof(line), file) == NULL);
+
+    fclose(file);
+    remove(DEAD_LETTER_TEST_PATH);
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <assert.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "buffer_engine.h"
+#include "journal.h"
+#include "logger.h"
+
+#define JOURNAL_TEST_DIR "build/test_journal.d"
+#define PRODUCER_THREADS 4
+#define PRODUCER_ATTEMPTS 250
+
+static void clear_dir(void) {
+    DIR *handle = opendir(JOURNAL_TEST_DIR);
+    if (handle == NULL) {
+        return;
+    }
+
+    struct dirent *item = NULL;
+    while ((item = readdir(handle)) != NULL) {
+        if (item->d_name[0] != '.') {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", JOURNAL_TEST_DIR, item->d_name);
+            unlink(path);
+        }
+    }
+    closedir(handle);
+    rmdir(JOURNAL_TEST_DIR);
+}
+
+static int restore(void *context, const LogEntryRecord *record, uint32_t segment) {
+    return buffer_engine_restore((BufferEngine *)context, record, segment, NULL, 0);
+}
+
+static void open_engine(AppLogger *logger, BufferEngine *engine, Journal *journal, size_t segment_limit, int fsync) {
+    char error[256] = {0};
+    assert(buffer_engine_init(engine, 2048, logger, error, sizeof(error)));
+    assert(journal_open(journal, JOURNAL_TEST_DIR, segment_limit, fsync, logger, error, sizeof(error)));
+    assert(journal_replay(journal, restore, engine, error, sizeof(error)));
+    buffer_engine_attach_journal(engine, journal);
+}
+
+static void test_truncate_and_replay(AppLogger *logger) {
+    char error[256] = {0};
+    BufferEngine engine;
+    Journal journal;
+
+    /* Segments smaller than one record: every append seals the previous segment. */
+    open_engine(logger, &engine, &journal, 16, 1);
+    assert(buffer_engine_enqueue(&engine, "INFO", "tests", "one", error, sizeof(error)));
+
+    BufferLogInput items[] = {
+        {"WARN", "tests", "two"},
+        {"ERROR", "tests", "three"},
+    };
+    assert(buffer_engine_enqueue_batch(&engine, items, 2, NULL, error, sizeof(error)) == 2);
+
+    JournalStats stats;
+    journal_get_stats(&journal, &stats);
+    assert(stats.records == 3);
+    assert(stats.appends == 2);
+    assert(stats.segments == 3);
+
+    LogEntry *entry = NULL;
+    assert(buffer_engine_dequeue(&engine, &entry));
+    assert(strcmp(log_entry_message(entry), "one") == 0);
+    int64_t first_ingested_at = entry->ingested_at_ms;
+    buffer_engine_release_entry(&engine, entry);
+
+    journal_get_stats(&journal, &stats);
+    assert(stats.segments == 2);
+    uint32_t active = stats.active_segment;
+
+    /* Simulated crash: queued entries are dropped without being released. */
+    buffer_engine_shutdown(&engine);
+    journal_close(&journal);
+
+    /* A torn frame at the tail is where recovery stops. */
+    char path[512];
+    snprintf(path, sizeof(path), "%s/segment-%010u.log", JOURNAL_TEST_DIR, active);
+    FILE *file = fopen(path, "ab");
+    assert(file != NULL);
+    fputs("xyz", file);
+    fclose(file);
+
+    open_engine(logger, &engine, &journal, 16, 1);
+    journal_get_stats(&journal, &stats);
+    assert(stats.replayed == 2);
+    assert(stats.replay_corrupt == 1);
+    assert(buffer_engine_queue_depth(&engine) == 2);
+
+    LinkedList batch;
+    linked_list_init(&batch);
+    assert(buffer_engine_dequeue_batch(&engine, 10, &batch) == 2);
+    assert(strcmp(log_entry_message(batch.head), "two") == 0);
+    assert(strcmp(log_entry_level(batch.head), "WARN") == 0);
+    assert(batch.head->ingested_at_ms >= first_ingested_at);
+    assert(strcmp(log_entry_message(batch.tail), "three") == 0);
+
+    /* Dropped entries keep their journal records and come back on the next start. */
+    buffer_engine_drop_batch(&engine, &batch);
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.total_dropped == 2);
+    buffer_engine_shutdown(&engine);
+    journal_close(&journal);
+
+    open_engine(logger, &engine, &journal, 16, 1);
+    assert(buffer_engine_dequeue_batch(&engine, 10, &batch) == 2);
+    assert(strcmp(log_entry_message(batch.tail), "three") == 0);
+    buffer_engine_release_batch(&engine, &batch);
+
+    buffer_engine_shutdown(&engine);
+    journal_close(&journal);
+
+    /* Everything was released, so nothing is left to recover. */
+    assert(rmdir(JOURNAL_TEST_DIR) == 0);
+}
+
+static void *producer_main(void *arg) {
+    BufferEngine *engine = (BufferEngine *)arg;
+    char error[256] = {0};
+
+    for (size_t i = 0; i < PRODUCER_ATTEMPTS; ++i) {
+        assert(buffer_engine_enqueue(engine, "INFO", "producer", "payload", error, sizeof(error)));
+    }
+
+    return NULL;
+}
+
+static void test_group_commit(AppLogger *logger) {
+    BufferEngine engine;
+    Journal journal;
+    open_engine(logger, &engine, &journal, 4096, 0);
+
+    pthread_t threads[PRODUCER_THREADS];
+    for (size_t i = 0; i < PRODUCER_THREADS; ++i) {
+        assert(pthread_create(&threads[i], NULL, producer_main, &engine) == 0);
+    }
+    for (size_t i = 0; i < PRODUCER_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    JournalStats stats;
+    journal_get_stats(&journal, &stats);
+    assert(stats.records == PRODUCER_THREADS * PRODUCER_ATTEMPTS);
+    assert(stats.syncs > 0 && stats.syncs <= stats.records);
+    assert(stats.segments > 1);
+
+    LinkedList batch;
+    linked_list_init(&batch);
+    while (buffer_engine_dequeue_batch(&engine, 64, &batch) > 0) {
+        buffer_engine_release_batch(&engine, &batch);
+    }
+
+    journal_get_stats(&journal, &stats);
+    assert(stats.segments == 1);
+
+    buffer_engine_shutdown(&engine);
+    journal_close(&journal);
+    assert(rmdir(JOURNAL_TEST_DIR) == 0);
+}
+
+int main(void) {
+    AppLogger logger;
+    assert(logger_init(&logger, LOGGER_ERROR, stderr));
+
+    clear_dir();
+    test_truncate_and_replay(&logger);
+    test_group_commit(&logger);
+
+    logger_close(&logger);
+    return 0;
+}
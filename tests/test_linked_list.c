@@ -1,13 +1,12 @@
 #include <assert.h>
-#include <stdlib.h>
+#include <string.h>
 
 #include "linked_list.h"
 #include "log_entry.h"
 
 static LogEntry *new_entry(uint64_t id) {
-    LogEntry *entry = (LogEntry *)calloc(1, sizeof(LogEntry));
+    LogEntry *entry = log_entry_create(id, "INFO", "test", "payload", log_entry_now_ms());
     assert(entry != NULL);
-    assert(log_entry_init(entry, id, "INFO", "test", "payload", log_entry_now_ms()));
     return entry;
 }
 
@@ -30,19 +29,52 @@ int main(void) {
     LogEntry *first = linked_list_pop_front(&list);
     assert(first != NULL);
     assert(first->id == 3);
-    free(first);
+    assert(strcmp(log_entry_level(first), "INFO") == 0);
+    assert(strcmp(log_entry_source(first), "test") == 0);
+    assert(strcmp(log_entry_message(first), "payload") == 0);
+    log_entry_free(first);
 
     LogEntry *second = linked_list_pop_front(&list);
     assert(second != NULL);
     assert(second->id == 1);
-    free(second);
+    log_entry_free(second);
 
     LogEntry *third = linked_list_pop_front(&list);
     assert(third != NULL);
     assert(third->id == 2);
-    free(third);
+    log_entry_free(third);
 
     assert(linked_list_pop_front(&list) == NULL);
     assert(linked_list_size(&list) == 0);
+
+    assert(linked_list_push_back(&list, new_entry(4)));
+    assert(linked_list_push_back(&list, new_entry(5)));
+    assert(list.head->next == list.tail);
+    assert(list.tail->prev == list.head);
+
+    assert(linked_list_push_back(&list, new_entry(6)));
+    LinkedList batch;
+    linked_list_init(&batch);
+    assert(linked_list_pop_front_batch(&list, 2, &batch) == 2);
+    assert(batch.head->id == 4 && batch.tail->id == 5);
+    assert(list.head->id == 6 && list.head->prev == NULL);
+    assert(linked_list_size(&list) == 1);
+
+    linked_list_prepend_list(&list, &batch);
+    assert(linked_list_size(&batch) == 0 && batch.head == NULL);
+    assert(linked_list_size(&list) == 3);
+    assert(list.head->id == 4 && list.tail->id == 6);
+    assert(list.tail->prev->id == 5);
+
+    LogEntry *middle = list.head->next;
+    linked_list_remove(&list, middle);
+    assert(middle->next == NULL && middle->prev == NULL);
+    assert(list.head->next == list.tail && list.tail->prev == list.head);
+    assert(linked_list_size(&list) == 2);
+    log_entry_free(middle);
+
+    linked_list_clear(&list, log_entry_free);
+    assert(list.head == NULL && list.tail == NULL);
+    assert(linked_list_size(&list) == 0);
     return 0;
 }
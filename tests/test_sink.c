@@ -0,0 +1,430 @@
+#include <assert.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "buffer_engine.h"
+#include "config.h"
+#include "logger.h"
+#include "persistence.h"
+#include "processor_workers.h"
+#include "queue_processor.h"
+#include "sink.h"
+#include "snapshot.h"
+
+#define SINK_TEST_DIR "build/test_sink.d"
+#define SNAPSHOT_TEST_PATH "build/test_snapshot.bin"
+
+static void clear_dir(void) {
+    DIR *handle = opendir(SINK_TEST_DIR);
+    if (handle == NULL) {
+        return;
+    }
+
+    struct dirent *item = NULL;
+    while ((item = readdir(handle)) != NULL) {
+        if (item->d_name[0] != '.') {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", SINK_TEST_DIR, item->d_name);
+            unlink(path);
+        }
+    }
+    closedir(handle);
+    rmdir(SINK_TEST_DIR);
+}
+
+static void enqueue_messages(BufferEngine *engine, size_t count) {
+    char error[256] = {0};
+    for (size_t i = 0; i < count; ++i) {
+        char message[32];
+        snprintf(message, sizeof(message), "message-%zu", i);
+        assert(buffer_engine_enqueue(engine, "INFO", "tests", message, error, sizeof(error)));
+    }
+}
+
+static void test_null_sink(AppLogger *logger) {
+    char error[256] = {0};
+    AppConfig config;
+    memset(&config, 0, sizeof(config));
+    config.sink_kind = sink_kind_from_string("null");
+
+    Sink sink;
+    assert(sink_open(&sink, &config, logger, error, sizeof(error)));
+    assert(strcmp(sink_name(&sink), "null") == 0);
+    assert(sink_available(&sink));
+    assert(sink_health(&sink, error, sizeof(error)));
+    assert(sink_persistence(&sink) == NULL);
+
+    BufferEngine engine;
+    QueueProcessor processor;
+    assert(buffer_engine_init(&engine, 128, logger, error, sizeof(error)));
+    assert(queue_processor_init(&processor, &engine, &sink, NULL, logger, 16, 0, error, sizeof(error)));
+
+    enqueue_messages(&engine, 40);
+    size_t processed = 0;
+    assert(queue_processor_process(&processor, 0, &processed, NULL, error, sizeof(error)));
+    assert(processed == 16);
+    assert(queue_processor_process(&processor, 100, &processed, NULL, error, sizeof(error)));
+    assert(processed == 24);
+    assert(buffer_engine_queue_depth(&engine) == 0);
+
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.total_processed == 40);
+
+    queue_processor_shutdown(&processor);
+    buffer_engine_shutdown(&engine);
+    sink_close(&sink);
+}
+
+static void test_adaptive_batch_size(AppLogger *logger) {
+    char error[256] = {0};
+    AppConfig config;
+    memset(&config, 0, sizeof(config));
+    config.sink_kind = SINK_NULL;
+
+    Sink sink;
+    BufferEngine engine;
+    QueueProcessor processor;
+    assert(sink_open(&sink, &config, logger, error, sizeof(error)));
+    assert(buffer_engine_init(&engine, 128, logger, error, sizeof(error)));
+    assert(queue_processor_init(&processor, &engine, &sink, NULL, logger, 10, 0, error, sizeof(error)));
+    assert(queue_processor_batch_size(&processor) == 10);
+
+    /* The null sink always beats the target, so only fullness steers the size. */
+    queue_processor_set_adaptive(&processor, 4, 16, 60000.0);
+    enqueue_messages(&engine, 50);
+
+    size_t processed = 0;
+    assert(queue_processor_process(&processor, 0, &processed, NULL, error, sizeof(error)));
+    assert(processed == 10);
+    assert(queue_processor_batch_size(&processor) == 14);
+    assert(queue_processor_process(&processor, 0, &processed, NULL, error, sizeof(error)));
+    assert(processed == 14);
+    assert(queue_processor_batch_size(&processor) == 16);
+
+    /* Explicit limits are the caller's choice and do not move the controller. */
+    assert(queue_processor_process(&processor, 3, &processed, NULL, error, sizeof(error)));
+    assert(queue_processor_batch_size(&processor) == 16);
+
+    /* 23 left: one full batch keeps it at the cap, then a short one shrinks it. */
+    assert(queue_processor_process(&processor, 0, &processed, NULL, error, sizeof(error)));
+    assert(processed == 16);
+    assert(queue_processor_process(&processor, 0, &processed, NULL, error, sizeof(error)));
+    assert(processed == 7);
+    assert(queue_processor_batch_size(&processor) == 12);
+
+    queue_processor_shutdown(&processor);
+    buffer_engine_shutdown(&engine);
+    sink_close(&sink);
+}
+
+static void test_threshold_wakes_workers(AppLogger *logger) {
+    char error[256] = {0};
+    AppConfig config;
+    memset(&config, 0, sizeof(config));
+    config.sink_kind = SINK_NULL;
+
+    Sink sink;
+    BufferEngine engine;
+    QueueProcessor processor;
+    ProcessorWorkers workers;
+    assert(sink_open(&sink, &config, logger, error, sizeof(error)));
+    assert(buffer_engine_init(&engine, 128, logger, error, sizeof(error)));
+    assert(queue_processor_init(&processor, &engine, &sink, NULL, logger, 64, 0, error, sizeof(error)));
+
+    /* The idle period is far away, so only a notify past the threshold can flush. */
+    assert(processor_workers_start(&workers, &processor, &engine, logger, 2, 32, 64, 10000, 0, error, sizeof(error)));
+    enqueue_messages(&engine, 24);
+    processor_workers_notify(&workers);
+    usleep(50000);
+    assert(buffer_engine_queue_depth(&engine) == 24);
+
+    int64_t started_ms = log_entry_now_ms();
+    enqueue_messages(&engine, 16);
+    processor_workers_notify(&workers);
+    while (buffer_engine_queue_depth(&engine) > 0 && log_entry_now_ms() - started_ms < 5000) {
+        usleep(5000);
+    }
+    assert(buffer_engine_queue_depth(&engine) == 0);
+
+    processor_workers_stop(&workers);
+    EngineMetrics metrics;
+    assert(buffer_engine_get_metrics(&engine, &metrics));
+    assert(metrics.total_processed == 40);
+
+    queue_processor_shutdown(&processor);
+    buffer_engine_shutdown(&engine);
+    sink_close(&sink);
+}
+
+static void test_max_linger_flush(AppLogger *logger) {
+    char error[256] = {0};
+    AppConfig config;
+    memset(&config, 0, sizeof(config));
+    config.sink_kind = SINK_NULL;
+
+    Sink sink;
+    BufferEngine engine;
+    QueueProcessor processor;
+    ProcessorWorkers workers;
+    assert(sink_open(&sink, &config, logger, error, sizeof(error)));
+    assert(buffer_engine_init(&engine, 128, logger, error, sizeof(error)));
+    assert(queue_processor_init(&processor, &engine, &sink, NULL, logger, 64, 0, error, sizeof(error)));
+    assert(buffer_engine_oldest_ingested_at_ms(&engine) == 0);
+
+    /* Far below the threshold and well inside the idle period: only the max linger can flush. */
+    assert(processor_workers_start(&workers, &processor, &engine, logger, 1, 100, 64, 10000, 50, error, sizeof(error)));
+    int64_t started_ms = log_entry_now_ms();
+    enqueue_messages(&engine, 3);
+    assert(buffer_engine_oldest_ingested_at_ms(&engine) >= started_ms);
+
+    while (buffer_engine_queue_depth(&engine) > 0 && log_entry_now_ms() - started_ms < 5000) {
+        usleep(5000);
+    }
+    assert(buffer_engine_queue_depth(&engine) == 0);
+    assert(log_entry_now_ms() - started_ms < 5000);
+    assert(buffer_engine_oldest_ingested_at_ms(&engine) == 0);
+
+    processor_workers_stop(&workers);
+    queue_processor_shutdown(&processor);
+    buffer_engine_shutdown(&engine);
+    sink_close(&sink);
+}
+
+static int write_routed(Persistence *persistence, LinkedList *batch, LinkedList *failed) {
+    char error[256] = {0};
+    LinkedList stored;
+    PersistenceRoute route;
+    linked_list_init(&stored);
+    persistence_route_batch(persistence, batch, &route);
+    int ok = persistence_write_routed(persistence, &route, log_entry_now_ms(), &stored, failed, error, sizeof(error));
+    assert(stored.head == NULL);
+    return ok;
+}
+
+/*
+ * No server is needed: the pool points at a closed port, so every probe
+ * fails to reconnect and reopens the breaker.
+ */
+static void test_breaker_ignores_empty_routed_batch(AppLogger *logger) {
+    Persistence persistence;
+    memset(&persistence, 0, sizeof(persistence));
+    persistence.connection_count = 1;
+    persistence.source_affinity = 1;
+    persistence.breaker_threshold = 1;
+    persistence.breaker_backoff_ms = 1;
+    persistence.reconnect_backoff_initial_ms = 1;
+    persistence.reconnect_backoff_max_ms = 1;
+    persistence.logger = logger;
+    assert(pthread_mutex_init(&persistence.breaker_mutex, NULL) == 0);
+    assert(pthread_mutex_init(&persistence.connections[0].mutex, NULL) == 0);
+    assert(pthread_cond_init(&persistence.connections[0].turn, NULL) == 0);
+    persistence.connections[0].conn = PQconnectdb("host=127.0.0.1 port=1 connect_timeout=1");
+    assert(persistence.connections[0].conn != NULL);
+    persistence.initialized = 1;
+
+    LinkedList batch;
+    LinkedList failed;
+    linked_list_init(&batch);
+    linked_list_init(&failed);
+    linked_list_push_back(&batch, log_entry_create(1, "INFO", "tests", "probe", log_entry_now_ms()));
+    assert(!write_routed(&persistence, &batch, &failed));
+
+    PersistenceStats stats;
+    persistence_get_stats(&persistence, &stats);
+    assert(stats.breaker_state == PERSISTENCE_BREAKER_OPEN && stats.breaker_failures == 1);
+
+    /* Once the retry time passes, an empty batch leaves the probe to the next real one. */
+    usleep(5000);
+    assert(persistence_breaker_allows(&persistence));
+    assert(write_routed(&persistence, &batch, &failed));
+    assert(persistence_breaker_allows(&persistence));
+
+    linked_list_append_list(&batch, &failed);
+    assert(!write_routed(&persistence, &batch, &failed));
+    persistence_get_stats(&persistence, &stats);
+    assert(stats.breaker_state == PERSISTENCE_BREAKER_OPEN && stats.breaker_failures == 2);
+    assert(linked_list_size(&failed) == 1);
+
+    log_entry_free(linked_list_pop_front(&failed));
+    persistence_close(&persistence);
+}
+
+static size_t count_lines(const char *path) {
+    FILE *file = fopen(path, "r");
+    assert(file != NULL);
+
+    size_t lines = 0;
+    int ch = 0;
+    while ((ch = fgetc(file)) != EOF) {
+        lines += ch == '\n';
+    }
+    fclose(file);
+    return lines;
+}
+
+static void test_file_sink(AppLogger *logger) {
+    char error[256] = {0};
+    AppConfig config;
+    memset(&config, 0, sizeof(config));
+    config.sink_kind = sink_kind_from_string("file");
+    snprintf(config.sink_file_dir, sizeof(config.sink_file_dir), "%s", SINK_TEST_DIR);
+    /* Small enough that the second batch rolls over to a new segment. */
+    config.sink_file_segment_bytes = 1024;
+    config.sink_file_fsync = 1;
+
+    Sink sink;
+    assert(sink_open(&sink, &config, logger, error, sizeof(error)));
+    assert(strcmp(sink_name(&sink), "file") == 0);
+
+    BufferEngine engine;
+    QueueProcessor processor;
+    assert(buffer_engine_init(&engine, 128, logger, error, sizeof(error)));
+    assert(queue_processor_init(&processor, &engine, &sink, NULL, logger, 10, 0, error, sizeof(error)));
+
+    assert(buffer_engine_enqueue(&engine, "ERROR", "billing", "bad \"row\"\nline two", error, sizeof(error)));
+    enqueue_messages(&engine, 19);
+
+    size_t processed = 0;
+    assert(queue_processor_process(&processor, 10, &processed, NULL, error, sizeof(error)));
+    assert(processed == 10);
+    assert(queue_processor_process(&processor, 10, &processed, NULL, error, sizeof(error)));
+    assert(processed == 10);
+    assert(sink_flush(&sink, error, sizeof(error)));
+
+    queue_processor_shutdown(&processor);
+    buffer_engine_shutdown(&engine);
+    sink_close(&sink);
+
+    const char *first = SINK_TEST_DIR "/sink-0000000001.jsonl";
+    const char *second = SINK_TEST_DIR "/sink-0000000002.jsonl";
+    assert(count_lines(first) == 10);
+    assert(count_lines(second) == 10);
+
+    FILE *file = fopen(first, "r");
+    assert(file != NULL);
+    char line[1024] = {0};
+    assert(fgets(line, sizeof(line), file) != NULL);
+    assert(strstr(line, "\"id\":1,") != NULL);
+    assert(strstr(line, "\"source\":\"billing\"") != NULL);
+    assert(strstr(line, "\"message\":\"bad \\\"row\\\"\\nline two\"") != NULL);
+    fclose(file);
+
+    /* A restart never appends to existing output. */
+    assert(sink_open(&sink, &config, logger, error, sizeof(error)));
+    sink_close(&sink);
+    assert(access(SINK_TEST_DIR "/sink-0000000003.jsonl", F_OK) == 0);
+
+    clear_dir();
+}
+
+static int restore_entry(void *context, const LogEntryRecord *record) {
+    return buffer_engine_restore((BufferEngine *)context, record, 0, NULL, 0);
+}
+
+static void test_shutdown_drain_and_snapshot(AppLogger *logger) {
+    char error[256] = {0};
+    AppConfig config;
+    memset(&config, 0, sizeof(config));
+    config.sink_kind = SINK_NULL;
+
+    Sink sink;
+    BufferEngine engine;
+    QueueProcessor processor;
+    assert(sink_open(&sink, &config, logger, error, sizeof(error)));
+    assert(buffer_engine_init(&engine, 256, logger, error, sizeof(error)));
+    assert(queue_processor_init(&processor, &engine, &sink, NULL, logger, 7, 0, error, sizeof(error)));
+
+    enqueue_messages(&engine, 100);
+    assert(processor_workers_drain(&processor, logger, 4, 7, log_entry_now_ms() + 5000) == 100);
+    assert(buffer_engine_queue_depth(&engine) == 0);
+
+    /* A deadline that already passed leaves the queue for the snapshot. */
+    enqueue_messages(&engine, 5);
+    assert(processor_workers_drain(&processor, logger, 4, 7, log_entry_now_ms() - 1) == 0);
+
+    LogEntry *head = NULL;
+    assert(buffer_engine_dequeue(&engine, &head));
+    head->attempts = 2;
+    int64_t head_ingested_at = head->ingested_at_ms;
+    LinkedList retry;
+    linked_list_init(&retry);
+    linked_list_push_back(&retry, head);
+    assert(buffer_engine_requeue_front_batch(&engine, &retry, error, sizeof(error)));
+
+    /* A failed rename keeps every entry written so far queued, in order. */
+    size_t written = 0;
+    char blocker[128];
+    snprintf(blocker, sizeof(blocker), "%s.d/keep", SNAPSHOT_TEST_PATH);
+    assert(mkdir(SNAPSHOT_TEST_PATH ".d", 0755) == 0);
+    FILE *keep = fopen(blocker, "w");
+    assert(keep != NULL);
+    fclose(keep);
+    assert(!snapshot_write(SNAPSHOT_TEST_PATH ".d", &engine, 2, &written, error, sizeof(error)));
+    assert(written == 0);
+    assert(buffer_engine_queue_depth(&engine) == 5);
+    assert(access(SNAPSHOT_TEST_PATH ".d.tmp", F_OK) != 0);
+    assert(unlink(blocker) == 0 && rmdir(SNAPSHOT_TEST_PATH ".d") == 0);
+
+    remove(SNAPSHOT_TEST_PATH);
+    assert(snapshot_write(SNAPSHOT_TEST_PATH, &engine, 2, &written, error, sizeof(error)));
+    assert(written == 5);
+    assert(buffer_engine_queue_depth(&engine) == 0);
+
+    queue_processor_shutdown(&processor);
+    buffer_engine_shutdown(&engine);
+    sink_close(&sink);
+
+    /* Too small to take the snapshot: what fits is loaded, the rest stays in the file. */
+    size_t loaded = 0;
+    size_t kept = 0;
+    assert(buffer_engine_init(&engine, 3, logger, error, sizeof(error)));
+    assert(snapshot_load(SNAPSHOT_TEST_PATH, restore_entry, &engine, &loaded, &kept, error, sizeof(error)));
+    assert(loaded == 3 && kept == 2);
+    assert(access(SNAPSHOT_TEST_PATH, F_OK) == 0);
+
+    /* The next snapshot carries the records still on disk over behind the queued ones. */
+    assert(snapshot_write(SNAPSHOT_TEST_PATH, &engine, 2, &written, error, sizeof(error)));
+    assert(written == 5);
+    buffer_engine_shutdown(&engine);
+
+    assert(buffer_engine_init(&engine, 16, logger, error, sizeof(error)));
+    assert(snapshot_load(SNAPSHOT_TEST_PATH, restore_entry, &engine, &loaded, &kept, error, sizeof(error)));
+    assert(loaded == 5 && kept == 0);
+    assert(access(SNAPSHOT_TEST_PATH, F_OK) != 0);
+
+    LinkedList batch;
+    linked_list_init(&batch);
+    assert(buffer_engine_dequeue_batch(&engine, 16, &batch) == 5);
+    assert(strcmp(log_entry_message(batch.head), "message-0") == 0);
+    assert(batch.head->attempts == 2);
+    assert(batch.head->ingested_at_ms == head_ingested_at);
+    assert(strcmp(log_entry_message(batch.tail), "message-4") == 0);
+    buffer_engine_release_batch(&engine, &batch);
+    buffer_engine_shutdown(&engine);
+
+    /* Nothing to reload is not an error. */
+    assert(snapshot_load(SNAPSHOT_TEST_PATH, restore_entry, &engine, &loaded, &kept, error, sizeof(error)));
+    assert(loaded == 0);
+}
+
+int main(void) {
+    AppLogger logger;
+    assert(logger_init(&logger, LOGGER_ERROR, stderr));
+
+    clear_dir();
+    test_null_sink(&logger);
+    test_adaptive_batch_size(&logger);
+    test_threshold_wakes_workers(&logger);
+    test_max_linger_flush(&logger);
+    test_file_sink(&logger);
+    test_breaker_ignores_empty_routed_batch(&logger);
+    test_shutdown_drain_and_snapshot(&logger);
+
+    logger_close(&logger);
+    return 0;
+}